@@ -9,6 +9,7 @@ uniform float fadeThreshold;
 uniform float saturationBoost;
 uniform float ditherStrength;
 uniform float time; // For temporal dithering
+uniform float jitterSamples; // Pixelation samples per axis, at most 8
 
 // Function to generate a random value based on UV coordinates
 float random(vec2 uv) {
@@ -66,9 +67,14 @@ void main() {
 
     // Jittered sampling for anti-aliasing
     vec4 pixelatedColor = vec4(0.0);
-    int sampleCount = 8;
-    for (int i = 0; i < sampleCount; ++i) {
-        for (int j = 0; j < sampleCount; ++j) {
+    // Constant bounds for older GLSL; the uniform lowers the real count
+    int sampleCount = int(clamp(jitterSamples, 1.0, 8.0));
+    for (int i = 0; i < 8; ++i) {
+        if (i >= sampleCount)
+            break;
+        for (int j = 0; j < 8; ++j) {
+            if (j >= sampleCount)
+                break;
           float angle = random(uv + vec2(i, j)) * 6.2831853;
      float radius = random(uv + vec2(j, i));
           radius *= (1.0 / resolution.x);
@@ -3,20 +3,52 @@
 
 #define NOMINMAX // Define NOMINMAX before including any Windows headers
 #include <audioclient.h>
+#include <functional>
 #include <mmdeviceapi.h>
 #include <vector>
 #include <windows.h>
 
 namespace capture {
 
-class AudioCapture {
+// One packet exactly as WASAPI delivered it
+struct AudioPacket {
+  const float *data; // Interleaved frames, or null if the packet is silent
+  UINT32 frames;
+  UINT32 channels;
+  UINT32 sampleRate;
+  INT64 captureTimeNs; // steady_clock time of the first frame
+};
+
+// Called on the capture thread for every packet; must not block
+using PacketCallback = std::function<void(const AudioPacket &)>;
+
+// Where the capture thread gets its audio: the loopback device, or a
+// recorded session being replayed
+class AudioSource {
+public:
+  virtual ~AudioSource() = default;
+  virtual bool initialize() = 0;
+  // Replaces monoFrames with every pending packet mixed down to mono, in
+  // order, at the source rate
+  virtual bool captureAudio(std::vector<float> &monoFrames) = 0;
+  virtual UINT32 getSampleRate() const = 0;
+
+  void setPacketCallback(PacketCallback callback) {
+    packetCallback = std::move(callback);
+  }
+
+protected:
+  PacketCallback packetCallback;
+};
+
+class AudioCapture : public AudioSource {
 public:
   AudioCapture(UINT32 bufferSize);
-  ~AudioCapture();
-  bool initialize();
-  bool captureAudio(std::vector<double> &audioBuffer);
+  ~AudioCapture() override;
+  bool initialize() override;
+  bool captureAudio(std::vector<float> &monoFrames) override;
 
-  UINT32 getSampleRate() const { return pwfx->nSamplesPerSec; }
+  UINT32 getSampleRate() const override { return pwfx->nSamplesPerSec; }
 
 private:
   void releaseResources();
@@ -2,28 +2,45 @@
 #define AUDIO_CAPTURE_RAII_H
 
 #include "AudioCapture.h"
+#include "AudioUtils.h"
+#include "PerfTimers.h"
+#include "PolyphaseResampler.h"
+#include "ThreadConfig.h"
+#include "Tracer.h"
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
+#include <iostream>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
 
 // RAII wrapper for AudioCapture to handle automatic cleanup and thread
-// management
+// management. The shared buffer always holds the latest sharedBuffer.size()
+// mono samples at VISUAL_SAMPLE_RATE.
 class AudioCaptureRAII {
 public:
-  // Constructor automatically initializes capture and starts the thread
+  // Constructor starts the thread, which initializes capture itself so
+  // device setup overlaps the rest of startup; a source that fails to
+  // initialize is reported and stops capture like a failed read.
+  // The optional packet callback sees every packet on the capture thread,
+  // before packets are merged into the shared buffer. Without a source the
+  // default loopback device is captured.
   AudioCaptureRAII(int bufferSize, std::vector<double> &sharedBuffer,
                    std::mutex &bufferMutex, std::condition_variable &bufferCV,
-                   std::atomic<bool> &running, bool &bufferReady)
-      : audioCapture_(bufferSize), sharedBuffer_(sharedBuffer),
+                   std::atomic<bool> &running, bool &bufferReady,
+                   capture::PacketCallback packetCallback = nullptr,
+                   std::unique_ptr<capture::AudioSource> source = nullptr)
+      : audioCapture_(std::move(source)), sharedBuffer_(sharedBuffer),
         bufferMutex_(bufferMutex), bufferCV_(bufferCV), running_(running),
         bufferReady_(bufferReady) {
-
-    if (!audioCapture_.initialize()) {
-      throw std::runtime_error("Failed to initialize audio capture");
+    if (!audioCapture_) {
+      audioCapture_ = std::make_unique<capture::AudioCapture>(bufferSize);
     }
+    audioCapture_->setPacketCallback(std::move(packetCallback));
 
     // Start the capture thread
     captureThread_ = std::thread(&AudioCaptureRAII::captureLoop, this);
@@ -50,28 +67,71 @@ public:
 private:
   // The audio capture loop that runs in a separate thread
   void captureLoop() {
+    trace::setThreadName("Audio Capture");
+    if (!audioCapture_->initialize()) {
+      std::cerr << "Failed to initialize audio capture" << std::endl;
+      audioCapture_.reset();
+      running_ = false;
+      return;
+    }
+
     std::vector<double> tempBuffer(sharedBuffer_.size());
+    std::vector<double> window(sharedBuffer_.size(), 0.0);
+    std::vector<float> deviceFrames;
+    std::vector<float> visualFrames;
+    PolyphaseResampler resampler(audioCapture_->getSampleRate(),
+                                 VISUAL_SAMPLE_RATE);
+    std::uint64_t policyVersion = 0;
 
     while (running_) {
-      if (!audioCapture_.captureAudio(tempBuffer)) {
+      threading::refreshPolicy(ThreadRole::Capture, policyVersion);
+      auto start = std::chrono::steady_clock::now();
+      if (!audioCapture_->captureAudio(deviceFrames)) {
         running_ = false;
         break;
       }
 
-      {
-        std::lock_guard<std::mutex> lock(bufferMutex_);
-        std::swap(sharedBuffer_, tempBuffer);
-        bufferReady_ = true;
-      }
+      visualFrames.clear();
+      resampler.process(deviceFrames.data(), deviceFrames.size(),
+                        visualFrames);
+
+      // Most polls find nothing, and a consumer woken for them would only
+      // reprocess the same window
+      if (!visualFrames.empty()) {
+        // Slide the window along by however much arrived
+        size_t count = std::min(visualFrames.size(), window.size());
+        std::copy(window.begin() + count, window.end(), window.begin());
+        std::copy(visualFrames.end() - count, visualFrames.end(),
+                  window.end() - count);
+        std::copy(window.begin(), window.end(), tempBuffer.begin());
 
-      bufferCV_.notify_one();
+        {
+          std::lock_guard<std::mutex> lock(bufferMutex_);
+          std::swap(sharedBuffer_, tempBuffer);
+          bufferReady_ = true;
+        }
 
-      // Control capture rate
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        bufferCV_.notify_one();
+
+        auto end = std::chrono::steady_clock::now();
+        perf::cpuTimes(perf::Timer::Capture)
+            .record(std::chrono::duration<float, std::milli>(end - start)
+                        .count());
+        if (trace::isEnabled()) {
+          trace::record("Capture", start, end);
+        }
+      }
+
+      // Control capture rate. WASAPI delivers a packet every 10 ms; polling
+      // faster than that keeps the wait from adding to onset latency.
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
     }
+
+    // Released on the thread that initialized it, which owns its COM state
+    audioCapture_.reset();
   }
 
-  capture::AudioCapture audioCapture_;
+  std::unique_ptr<capture::AudioSource> audioCapture_;
   std::vector<double> &sharedBuffer_;
   std::mutex &bufferMutex_;
   std::condition_variable &bufferCV_;
@@ -0,0 +1,43 @@
+#ifndef AUDIO_CONDITIONER_H
+#define AUDIO_CONDITIONER_H
+
+#include <cstddef>
+#include <vector>
+
+// One conditioned block of audio, always frameSize samples long so the
+// geometry built from it keeps a constant size
+struct AnalysisFrame {
+  std::vector<double> samples; // Input, truncated or zero padded
+  double peak = 0.0;           // Largest absolute sample
+  double rms = 0.0;
+  bool silent = true;
+  double gain = 1.0; // Display gain from the level envelope
+};
+
+// Replaces the separate silence check, trim and min/max normalisation
+// passes. A single SIMD pass copies the input into the frame while
+// collecting peak and sum of squares; the display gain then follows the
+// peak through an attack/release envelope instead of jumping to 1/peak
+// every frame. The gain is not multiplied in here: consumers fold it into
+// their own first pass over the samples (see SmoothingCache::build).
+class AudioConditioner {
+public:
+  explicit AudioConditioner(size_t frameSize);
+
+  // Envelope time constants in seconds
+  void setAttack(float seconds) { attackTime = seconds; }
+  void setRelease(float seconds) { releaseTime = seconds; }
+
+  // Condition the input; deltaTime is the time since the previous call
+  const AnalysisFrame &process(const std::vector<double> &input,
+                               float deltaTime);
+  const AnalysisFrame &getFrame() const { return frame; }
+
+private:
+  AnalysisFrame frame;
+  double envelope = 0.0; // Smoothed peak level
+  float attackTime = 0.01f;
+  float releaseTime = 0.5f;
+};
+
+#endif // AUDIO_CONDITIONER_H
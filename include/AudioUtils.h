@@ -1,14 +1,33 @@
 #ifndef AUDIO_UTILS_H
 #define AUDIO_UTILS_H
 
+#include <cmath>
+#include <cstddef>
 #include <vector>
 
+// Rate everything after capture runs at, whatever the device rate, so
+// visuals and per-frame work are the same on every device
+constexpr unsigned int VISUAL_SAMPLE_RATE = 48000;
+
+// Length of the analysis window (1024 samples at the visual rate)
+constexpr double ANALYSIS_WINDOW_MS = 1024.0 * 1000.0 / VISUAL_SAMPLE_RATE;
+
+inline size_t samplesForMs(double milliseconds, unsigned int sampleRate) {
+  return static_cast<size_t>(std::lround(milliseconds * sampleRate / 1000.0));
+}
+
+// Average interleaved frames into one mono sample per frame
+void downmixToMono(const float *interleaved, size_t frames, size_t channels,
+                   float *mono);
+
 // Function declarations
 void smoothAudioData(const std::vector<double> &audioData,
                      std::vector<double> &smoothedData,
                      int smoothness);
-void trimTrailingZeros(std::vector<double> &audioBuffer);
-bool isAudioPlaying(const std::vector<double> &audioBuffer);
-void normalizeAudioData(std::vector<double> &audioBuffer);
+// Lay the buffer out forward then reversed, scaled by gain, so a circular
+// plot closes on itself; the two ends are averaged at the join
+void mirrorAudioBuffer(const std::vector<double> &buffer,
+                       std::vector<double> &extendedBuffer,
+                       double gain = 1.0);
 
 #endif // AUDIO_UTILS_H
@@ -1,13 +1,37 @@
 #ifndef AUDIO_VISUALIZER_H
 #define AUDIO_VISUALIZER_H
 
+#include "AudioConditioner.h"
 #include "AudioUtils.h"
+#include "BandAnalyzer.h"
+#include "BeatAnalyzer.h"
+#include "ConfigSerializer.h"
+#include "GpuTimer.h"
+#include "ModulationMatrix.h"
 #include "VisualizerConfig.h"
+#include "RadialBars.h"
+#include "RenderQuality.h"
 #include "ShaderConfig.h"
-#include "Waveform.h"
+#include "SmoothingCache.h"
+#include "VideoRecorder.h"
+#include "WaveformStore.h"
 #include <SFML/Graphics.hpp>
-#include <vector>
+#include <functional>
+#include <future>
 #include <memory>
+#include <string>
+#include <vector>
+
+// Everything needed to draw one preset. Scenes are built off the render
+// thread and swapped in whole at a frame boundary so there is never a frame
+// with a half-applied preset.
+struct SceneState {
+  std::string name;
+  VisualizerConfig visualizerConfig;
+  ShaderConfig shaderConfig;
+  WaveformStore waveforms;
+  ModulationSettings modulation;
+};
 
 class AudioVisualizer {
 public:
@@ -16,27 +40,152 @@ public:
 
   bool initialize(unsigned int width, unsigned int height);
   void handleResize(unsigned int width, unsigned int height);
-  void update(const std::vector<double> &audioBuffer, float deltaTime);
+
+  // Called once at the start of every frame; commits a pending scene swap
+  // and advances any running crossfade
+  void beginFrame(float deltaTime);
+  // New conditioned audio; the next update() builds geometry from it
+  void setAnalysisFrame(const AnalysisFrame &frame);
+  void update(float deltaTime);
   void render(sf::RenderWindow &window);
 
-  // Waveform management
-  void addWaveform(const WaveformConfig &config);
+  // Waveform management. Indices are positions in draw order; handles stay
+  // valid across additions and removals.
+  WaveformHandle addWaveform(const WaveformConfig &config);
   void removeWaveform(size_t index);
   size_t getWaveformCount() const { return waveforms.size(); }
-  Waveform* getWaveform(size_t index) { return index < waveforms.size() ? waveforms[index] : nullptr; }
+  WaveformHandle getWaveformHandle(size_t index) const { return waveforms.getHandle(index); }
+  WaveformConfig* getWaveformConfig(size_t index) { return index < waveforms.size() ? &waveforms.getConfig(index) : nullptr; }
+
+  // Audio-reactive routes of the active scene, evaluated once per update().
+  // Modulated values are used for the frame only; configs keep their edited
+  // values.
+  ModulationMatrix &getModulation() { return modulation; }
+
+  // Preset switching. The file is read and the scene built on a worker
+  // thread; the swap happens at the next frame boundary. A crossfade time of
+  // zero swaps instantly.
+  void loadPresetAsync(const std::string &filepath, float crossfadeSeconds);
+  // The current scene as a preset, for saving or recording
+  VisualizerPreset getCurrentPreset(const std::string &name) const;
+  void applyPresetAsync(const VisualizerPreset &preset, float crossfadeSeconds);
+  // Apply a preset with the current scene's waveform count straight to the
+  // live configuration, as UI edits are, with no scene rebuild. False, and
+  // nothing applied, if the count differs or a swap is under way.
+  bool applyPresetInPlace(const VisualizerPreset &preset);
+  bool isPresetLoading() const { return pendingScene.valid(); }
+  bool isCrossfading() const { return crossfadeDuration > 0.0f; }
+
+  // Beat events drive the pulse; the analyzer must outlive the visualizer
+  // or be detached first
+  void setBeatAnalyzer(BeatAnalyzer *analyzer) { beatAnalyzer = analyzer; }
+  BeatAnalyzer *getBeatAnalyzer() const { return beatAnalyzer; }
+
+  // Position within the current tracked beat in [0, 1), or -1 when no beat
+  // is being tracked
+  float getBeatPhase() const;
+
+  // Waveform geometry is built in a vertex shader when available; turning
+  // it off uses the CPU path, e.g. to compare the two
+  bool isGpuGeometryAvailable() const { return gpuGeometryAvailable; }
+  bool isGpuGeometryEnabled() const { return gpuGeometryEnabled; }
+  void setGpuGeometryEnabled(bool enabled) { gpuGeometryEnabled = enabled; }
+
+  // Detail level, usually driven by QualityGovernor. A new trail scale
+  // recreates the trail texture, which clears the trails.
+  void setQuality(const RenderQuality &renderQuality);
+  const RenderQuality &getQuality() const { return quality; }
+
+  // CPU-built geometry is produced on a worker thread one frame ahead of
+  // rendering; turning it off builds it inline
+  bool isGeometryPipelined() const { return geometryPipelined; }
+  void setGeometryPipelined(bool enabled) { geometryPipelined = enabled; }
+
+  // Latest analysis results, for export. The spectrum and bands are only
+  // kept current while bars are shown or the spectrum is required.
+  void setSpectrumRequired(bool required) { spectrumRequired = required; }
+  const std::vector<float> &getSpectrum() const { return magnitudes; }
+  size_t getSpectrumFftSize() const { return spectrumFftSize; }
+  const std::vector<float> &getBandLevels() const { return bands.getLevels(); }
+  // Beat events taken by the last beginFrame()
+  const std::vector<BeatEvent> &getBeatEvents() const { return beatEvents; }
+  const BeatEvent *getLastBeat() const { return hasBeat ? &lastBeat : nullptr; }
+
+  // Every rendered trail frame is offered to the recorder when set
+  void setVideoRecorder(VideoRecorder *recorder) { videoRecorder = recorder; }
+  sf::Vector2u getTrailSize() const { return renderTexture.getSize(); }
 
 private:
+  using SceneBuilder = std::function<std::unique_ptr<SceneState>()>;
+
+  void startSceneBuild(SceneBuilder builder, float crossfadeSeconds);
+  void commitScene(std::unique_ptr<SceneState> scene);
+  void configureStore(WaveformStore &store);
+  void applyShaderUniforms(const ShaderConfig &shaderSettings);
+  ShaderConfig crossfadeShader() const;
+  bool createTrailTexture();
+
   VisualizerConfig &config; // Non-const reference to configuration
   ShaderConfig &shaderConfig; // Reference to shader configuration
 
-  // Rendering components
+  // Rendering components. The trail texture is quality.trailScale times
+  // viewSize; trailView maps view coordinates onto it.
   sf::RenderTexture renderTexture;
+  sf::Vector2u viewSize;
+  sf::View trailView;
+  RenderQuality quality;
   sf::Shader shader;
+  sf::Shader waveformShader; // Vertex shader building waveform geometry
+  GpuTimer trailGpuTimer{perf::gpuTimes(perf::Timer::TrailShader)};
+  GpuTimer waveformGpuTimer{perf::gpuTimes(perf::Timer::Waveforms)};
+  VideoRecorder *videoRecorder = nullptr;
+  bool gpuGeometryAvailable = false;
+  bool gpuGeometryEnabled = true;
+  bool geometryPipelined = true;
   
-  // Waveforms (using raw pointers for simplicity)
-  std::vector<Waveform*> waveforms;
+  // Mirrored and smoothed samples, built once per frame for all waveforms
+  SmoothingCache smoothing;
+
+  // Log-frequency spectrum for the bars, from the analyzer's STFT
+  void updateSpectrum(float deltaTime);
+  std::vector<float> magnitudes;
+  size_t spectrumFftSize = 0;
+  bool spectrumRequired = false;
+  BandAnalyzer bands;
+  RadialBars radialBars;
+
+  // Waveforms of the active scene
+  WaveformStore waveforms;
+  ModulationMatrix modulation;
+
+  // Levels of the latest analysis frame, for modulation
+  float analysisRms = 0.0f;
+  float analysisPeak = 0.0f;
+
+  // Scene being built on a worker thread, and the next one requested while
+  // that build was still running
+  std::future<std::unique_ptr<SceneState>> pendingScene;
+  float pendingCrossfade = 0.0f;
+  SceneBuilder queuedBuilder;
+  float queuedCrossfade = 0.0f;
+
+  // Outgoing scene kept alive while it fades out. The shader fades from
+  // the settings shown at the swap to shaderConfig, which already holds the
+  // incoming scene's and stays the user's to edit.
+  WaveformStore fadingWaveforms;
+  ModulationMatrix fadingModulation;
+  ShaderConfig fadeFromShader;
+  float crossfadeDuration = 0.0f;
+  float crossfadeElapsed = 0.0f;
 
   float rotationAngle; // Current rotation angle for global hue
+  float radiusScale = 1.0f; // Beat pulse applied by the last update()
+
+  // Most recent tracked beat, from the analyzer's event channel
+  BeatAnalyzer *beatAnalyzer = nullptr;
+  std::vector<BeatEvent> beatEvents;
+  BeatEvent lastBeat;
+  bool hasBeat = false;
 };
 
 #endif // AUDIO_VISUALIZER_H
@@ -0,0 +1,48 @@
+#ifndef BAND_ANALYZER_H
+#define BAND_ANALYZER_H
+
+#include <cstddef>
+#include <vector>
+
+// Maps FFT magnitudes to log-spaced perceptual bands and smooths each band
+// with its own attack/release envelope.
+//
+// Each band is a triangular filter between its neighbours' centre
+// frequencies, so it only touches a contiguous run of bins. The weights are
+// precomputed into one flat array (a compressed sparse row matrix with one
+// run per row), and mapping is a short SIMD dot product per band: the cost
+// is proportional to the number of bins, about two multiply-adds each,
+// whatever the FFT size.
+class BandAnalyzer {
+public:
+  // Rebuild the weight matrix; cheap enough to call when settings change
+  void configure(size_t fftSize, unsigned int sampleRate, size_t bandCount,
+                 float minFrequency = 30.0f, float maxFrequency = 16000.0f);
+
+  bool matches(size_t fftSize, unsigned int sampleRate,
+               size_t bandCount) const {
+    return fftSize == configuredFftSize && sampleRate == configuredRate &&
+           bandCount == levels.size();
+  }
+
+  // magnitudes holds fftSize / 2 + 1 linear magnitudes, 1.0 = full scale.
+  // Attack and release are time constants in seconds.
+  void process(const float *magnitudes, float deltaTime, float attack,
+               float release);
+
+  // Smoothed band levels in [0, 1] on a dB scale
+  const std::vector<float> &getLevels() const { return levels; }
+  size_t getBandCount() const { return levels.size(); }
+
+private:
+  size_t configuredFftSize = 0;
+  unsigned int configuredRate = 0;
+
+  std::vector<size_t> firstBin;     // First bin of each band's run
+  std::vector<size_t> weightOffset; // Start of each run in weights, plus end
+  std::vector<float> weights;       // All runs back to back
+
+  std::vector<float> levels;
+};
+
+#endif // BAND_ANALYZER_H
@@ -0,0 +1,98 @@
+#ifndef BEAT_ANALYZER_H
+#define BEAT_ANALYZER_H
+
+#include "BeatDetector.h"
+#include "SpscRingBuffer.h"
+#include "StftEngine.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs a BeatDetector on its own thread. The capture thread pushes every
+// packet as it arrives and the render thread polls for events; both sides
+// go through lock-free single-producer/single-consumer rings, so neither
+// ever waits on the analysis.
+//
+// The same thread runs a high-rate STFT for the spectrum display, so the
+// visuals see every hop rather than one block FFT per render frame.
+class BeatAnalyzer {
+public:
+  BeatAnalyzer();
+  ~BeatAnalyzer();
+
+  BeatAnalyzer(const BeatAnalyzer &) = delete;
+  BeatAnalyzer &operator=(const BeatAnalyzer &) = delete;
+
+  // Capture thread only. data holds frames * channels interleaved samples,
+  // or null for a silent packet; captureTimeNs is the steady_clock time of
+  // its first frame.
+  void pushPacket(const float *data, size_t frames, unsigned int channels,
+                  unsigned int sampleRate, std::int64_t captureTimeNs);
+
+  // Render thread only. Appends events raised since the last call.
+  void pollEvents(std::vector<BeatEvent> &events);
+
+  // Render thread only. Per-bin peak of the spectra computed since the last
+  // call, so short transients between frames still show. Returns false if
+  // there is nothing new; fftSize and sampleRate describe the bins.
+  bool takeSpectrum(std::vector<float> &magnitudes, size_t &fftSize,
+                    unsigned int &sampleRate);
+
+  // Time from an onset's capture to its event being published
+  float getMeanDelayMs() const { return meanDelayMs.load(); }
+  float getMaxDelayMs() const { return maxDelayMs.load(); }
+
+  float getBpm() const { return bpm.load(); }
+  float getConfidence() const { return confidence.load(); }
+  std::uint64_t getDroppedSamples() const { return droppedSamples.load(); }
+
+private:
+  // Where a packet starts in the sample stream and when it was captured
+  struct PacketStamp {
+    std::uint64_t firstSample = 0;
+    std::int64_t timeNs = 0;
+    unsigned int sampleRate = 0;
+  };
+
+  void analysisLoop();
+  void publishSpectrum(const std::vector<float> &peaks, unsigned int rate);
+  std::int64_t sampleTime(std::uint64_t sample) const;
+  void recordDelay(std::int64_t delayNs);
+
+  SpscRingBuffer<float> samples;
+  SpscRingBuffer<PacketStamp> stamps;
+  SpscRingBuffer<BeatEvent> events;
+
+  // Producer-side state
+  std::vector<float> monoScratch;
+  std::uint64_t samplesPushed = 0;
+
+  // Analysis-thread state
+  std::unique_ptr<BeatDetector> detector;
+  std::unique_ptr<StftEngine> spectrum;
+  std::vector<float> spectrumPeaks;
+  std::vector<PacketStamp> recentStamps;
+  std::int64_t maxWindowStartNs = 0;
+  float maxWindowDelayMs = 0.0f;
+
+  // Latest spectrum handed to the render thread; held only for a copy
+  std::mutex spectrumMutex;
+  std::vector<float> sharedSpectrum;
+  size_t sharedFftSize = 0;
+  unsigned int sharedSampleRate = 0;
+  bool spectrumFresh = false;
+
+  std::atomic<float> meanDelayMs{0.0f};
+  std::atomic<float> maxDelayMs{0.0f};
+  std::atomic<float> bpm{0.0f};
+  std::atomic<float> confidence{0.0f};
+  std::atomic<std::uint64_t> droppedSamples{0};
+
+  std::atomic<bool> running{true};
+  std::thread analysisThread;
+};
+
+#endif // BEAT_ANALYZER_H
@@ -0,0 +1,79 @@
+#ifndef BEAT_DETECTOR_H
+#define BEAT_DETECTOR_H
+
+#include "StftEngine.h"
+#include <cstdint>
+#include <vector>
+
+// A detected onset or a tracked beat. sample is the position in the
+// analysed stream; timeNs is filled in by BeatAnalyzer from the capture
+// timestamps, on the std::chrono::steady_clock time base.
+struct BeatEvent {
+  enum class Type { Onset, Beat };
+
+  Type type = Type::Onset;
+  std::uint64_t sample = 0;
+  std::int64_t timeNs = 0;
+  float strength = 0.0f; // Onset: flux over threshold; Beat: tempo confidence
+  float bpm = 0.0f;      // Tempo estimate when the event was raised
+};
+
+// Incremental onset detection and beat tracking on a mono stream.
+//
+// Every hop, a Hann-windowed frame is transformed and the spectral flux
+// (summed rise of log-compressed magnitudes) is compared against an
+// adaptive threshold from its recent mean and deviation. The onset strength
+// envelope is autocorrelated a few times a second to estimate the tempo,
+// and a phase-locked beat grid is nudged toward each onset near a predicted
+// beat. Short windows and rising-edge picking keep the detection delay to
+// roughly half a window plus one hop.
+class BeatDetector {
+public:
+  explicit BeatDetector(unsigned int sampleRate);
+
+  unsigned int getSampleRate() const { return sampleRate; }
+  size_t getHopSize() const { return stft.getHopSize(); }
+
+  // Analyse more samples, appending any events to events
+  void process(const float *samples, size_t count,
+               std::vector<BeatEvent> &events);
+
+  float getBpm() const { return bpm; }
+  float getConfidence() const { return confidence; }
+
+private:
+  void analyseHop(const std::vector<float> &spectrum,
+                  std::vector<BeatEvent> &events);
+  void updateTempo();
+  void trackBeats(bool onset, std::vector<BeatEvent> &events);
+
+  unsigned int sampleRate;
+  StftEngine stft;
+  double hopsPerSecond;
+
+  std::vector<double> magnitudes; // Log-compressed
+  std::vector<double> previousMagnitudes;
+
+  // Adaptive threshold over a short flux history, with running sums
+  std::vector<double> fluxHistory;
+  size_t fluxPos = 0;
+  size_t fluxCount = 0;
+  double fluxSum = 0.0;
+  double fluxSumSquares = 0.0;
+  bool wasAboveThreshold = false;
+  std::uint64_t lastOnsetSample = 0;
+
+  // Onset strength envelope for tempo estimation, circular
+  std::vector<float> envelope;
+  size_t envelopePos = 0;
+  size_t envelopeCount = 0;
+  size_t hopsSinceTempo = 0;
+  std::vector<double> autocorrelation;
+
+  float bpm = 0.0f;
+  float confidence = 0.0f;
+  double periodSamples = 0.0;
+  double nextBeatSample = 0.0; // Zero until the grid is anchored
+};
+
+#endif // BEAT_DETECTOR_H
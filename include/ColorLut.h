@@ -0,0 +1,47 @@
+#ifndef COLOR_LUT_H
+#define COLOR_LUT_H
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// A hue gradient sampled at SIZE points. Hues are 32-bit fixed point with
+// one full turn at 2^32, so walking the gradient is an integer add that
+// wraps by itself and a lookup is a shift. Built once per palette and
+// shared by every waveform.
+class ColorLut {
+public:
+  static constexpr unsigned int BITS = 12;
+  static constexpr size_t SIZE = size_t(1) << BITS;
+
+  // The HSV rainbow at one saturation and value
+  static ColorLut hsv(float saturation, float value);
+
+  static std::uint32_t toFixed(double hue) {
+    double turns = hue - std::floor(hue);
+    return static_cast<std::uint32_t>(
+        static_cast<std::uint64_t>(turns * 4294967296.0));
+  }
+
+  // Fixed-point step that walks the whole gradient in count steps
+  static std::uint32_t stepFor(size_t count) {
+    return count > 0 ? static_cast<std::uint32_t>((std::uint64_t(1) << 32) /
+                                                  count)
+                     : 0;
+  }
+
+  sf::Color operator[](std::uint32_t fixedHue) const {
+    return colors[fixedHue >> (32 - BITS)];
+  }
+
+private:
+  std::array<sf::Color, SIZE> colors;
+};
+
+// Palettes of the waveforms' normal and thick passes
+const ColorLut &normalPassPalette();
+const ColorLut &thickPassPalette();
+
+#endif // COLOR_LUT_H
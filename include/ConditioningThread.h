@@ -0,0 +1,46 @@
+#ifndef CONDITIONING_THREAD_H
+#define CONDITIONING_THREAD_H
+
+#include "AudioConditioner.h"
+#include "TripleBuffer.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Conditions each window capture hands over as soon as it arrives, on its
+// own thread, and passes the latest AnalysisFrame to the render thread
+// through a triple buffer. The scheduler's stages, and the vsync wait in
+// presenting, share the render thread; none of them can delay analysis.
+class ConditioningThread {
+public:
+  // Takes windows from capture's shared buffer, which the capture thread
+  // fills and flags under bufferMutex before notifying bufferCV
+  ConditioningThread(size_t windowSamples, std::vector<double> &sharedBuffer,
+                     std::mutex &bufferMutex,
+                     std::condition_variable &bufferCV, bool &bufferReady);
+  ~ConditioningThread();
+
+  ConditioningThread(const ConditioningThread &) = delete;
+  ConditioningThread &operator=(const ConditioningThread &) = delete;
+
+  // Render thread. True if a newer frame was taken into frame().
+  bool acquire() { return frames.acquire(); }
+  const AnalysisFrame &frame() const { return frames.readBuffer(); }
+
+private:
+  void conditionLoop();
+
+  std::vector<double> &sharedBuffer;
+  std::mutex &bufferMutex;
+  std::condition_variable &bufferCV;
+  bool &bufferReady;
+  bool stopping = false; // Guarded by bufferMutex
+
+  std::vector<double> window; // Conditioning thread only
+  AudioConditioner conditioner;
+  TripleBuffer<AnalysisFrame> frames;
+  std::thread conditioningThread;
+};
+
+#endif // CONDITIONING_THREAD_H
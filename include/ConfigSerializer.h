@@ -1,10 +1,13 @@
 #ifndef CONFIG_SERIALIZER_H
 #define CONFIG_SERIALIZER_H
 
+#include "JsonReader.h"
+#include "ModulationMatrix.h"
 #include "VisualizerConfig.h"
 #include "ShaderConfig.h"
 #include "WaveformConfig.h"
 #include <string>
+#include <string_view>
 #include <vector>
 
 // Forward declaration
@@ -16,10 +19,13 @@ struct VisualizerPreset {
     VisualizerConfig visualizerConfig;
     ShaderConfig shaderConfig;
     std::vector<WaveformConfig> waveforms;
+    ModulationSettings modulation;
     
     // Serialization methods
     std::string toJSON() const;
-    void fromJSON(const std::string& json);
+    // Parses a whole preset document in one pass. On malformed input the
+    // preset is left untouched and error (if given) holds the byte offset.
+    bool fromJSON(std::string_view json, json::Error* error = nullptr);
 };
 
 class ConfigSerializer {
@@ -32,10 +38,6 @@ public:
     
     // Get list of available presets in a directory
     static std::vector<std::string> getAvailablePresets(const std::string& directory = "presets");
-
-    // Utility functions (public so VisualizerPreset can use them)
-    static std::string extractValue(const std::string& content, const std::string& key);
-    static std::string extractSection(const std::string& content, const std::string& key);
 };
 
 #endif // CONFIG_SERIALIZER_H
@@ -0,0 +1,32 @@
+#ifndef DIRECTORY_WATCHER_H
+#define DIRECTORY_WATCHER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// A file in the watched directory that was created, written or removed.
+// Overflow means events were lost and the directory should be rescanned.
+struct FileChange {
+  enum class Type { Modified, Removed, Overflow };
+
+  Type type;
+  std::string filename; // Name relative to the watched directory
+};
+
+// Reports changes to the files of a single directory. Backed by inotify on
+// Linux and ReadDirectoryChangesW on Windows, falling back to polling file
+// timestamps elsewhere or if the native API is unavailable.
+class DirectoryWatcher {
+public:
+  virtual ~DirectoryWatcher() = default;
+
+  // Waits up to timeoutMs for changes and appends them to changes. Returns
+  // false if the watcher has failed and should no longer be used.
+  virtual bool waitForChanges(std::vector<FileChange> &changes,
+                              int timeoutMs) = 0;
+
+  static std::unique_ptr<DirectoryWatcher> create(const std::string &directory);
+};
+
+#endif // DIRECTORY_WATCHER_H
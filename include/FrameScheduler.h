@@ -0,0 +1,82 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Runs pipeline stages (geometry, rendering, UI, ...) on one thread, each
+// at its own rate. A stage gets the time since its own last run, so its
+// animation keeps time however the others behave. They share the thread,
+// though: a run starts late while another stage or a present is still
+// running, and meanLateMs reports by how much. Work that must not wait
+// behind them, like audio analysis, belongs on its own thread. Stages run
+// in the order they were added, so one added after another sees its
+// results from the same pass.
+class FrameScheduler {
+public:
+  using StageFunction = std::function<void(float deltaTime)>;
+
+  struct Stage {
+    std::string name;
+    float rateHz = 0.0f;   // 0 runs on every pass
+    float budgetMs = 0.0f; // Cost above this is counted as an overrun
+    StageFunction run;
+    std::function<void()> present; // Waits for the display, or null
+
+    // Statistics, updated after every run
+    float lastMs = 0.0f;
+    float meanMs = 0.0f;
+    float measuredHz = 0.0f;
+    float meanInterval = 0.0f; // Seconds
+    float meanLateMs = 0.0f;   // From due to started, behind other work
+    std::uint64_t runs = 0;
+    std::uint64_t overruns = 0;
+    std::uint64_t missed = 0; // Runs skipped after falling behind
+
+    std::chrono::steady_clock::time_point lastRun;
+    std::chrono::steady_clock::time_point nextDue;
+
+    // Refreshes seen by present; a period of 0 while present is not
+    // waiting for them
+    float displayPeriod = 0.0f; // Seconds
+    std::chrono::steady_clock::time_point lastRefresh;
+  };
+
+  size_t addStage(const std::string &name, float rateHz, float budgetMs,
+                  StageFunction run);
+
+  size_t getStageCount() const { return stages.size(); }
+  const Stage &getStage(size_t index) const { return stages[index]; }
+  void setRate(size_t index, float rateHz);
+  void setBudget(size_t index, float budgetMs) {
+    stages[index].budgetMs = budgetMs;
+  }
+
+  // Run present, such as a vsynced display(), after each run of a stage.
+  // While it waits for refreshes the stage is paced off them: each run
+  // starts just early enough to finish before the refresh nearest its
+  // period, and the wait is not counted as its cost.
+  void setPresent(size_t index, std::function<void()> present) {
+    stages[index].present = std::move(present);
+  }
+
+  // Run every stage that is due
+  void runDueStages();
+
+  // Time until the next stage is due, for the caller to sleep
+  float secondsUntilNextStage() const;
+
+  // Total cost of all stages run since the previous call, in milliseconds
+  float takeBusyMs();
+
+private:
+  bool schedulePresented(Stage &stage);
+
+  std::vector<Stage> stages;
+  float busyMs = 0.0f;
+};
+
+#endif // FRAME_SCHEDULER_H
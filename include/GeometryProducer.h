@@ -0,0 +1,94 @@
+#ifndef GEOMETRY_PRODUCER_H
+#define GEOMETRY_PRODUCER_H
+
+#include "TripleBuffer.h"
+#include "WaveformGeometry.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Everything needed to build one frame of CPU geometry, copied from the
+// store so it can be built while the render thread carries on
+struct GeometryJob {
+  SmoothingCache samples;
+  std::vector<WaveformConfig> configs;
+  std::vector<float> rotationAngles;
+  std::vector<GeometryRange> ranges;
+  size_t vertexCount = 0;
+  float globalHue = 0.0f;
+  float width = 0.0f;
+  float height = 0.0f;
+  float opacity = 1.0f;
+  float radiusScale = 1.0f;
+  RenderQuality quality;
+};
+
+// Builds waveform geometry on its own thread, so frame N + 1's vertices are
+// generated while the render thread submits frame N. Jobs go in through a
+// one-deep mailbox (a newer job replaces one not yet started) and finished
+// vertex arrays come back through a triple buffer, so the render thread
+// never waits for generation.
+class GeometryProducer {
+public:
+  GeometryProducer();
+  ~GeometryProducer();
+
+  GeometryProducer(const GeometryProducer &) = delete;
+  GeometryProducer &operator=(const GeometryProducer &) = delete;
+
+  // Ask the thread to exit without waiting for it, so a producer can be
+  // retired mid-frame and destroyed once finished() is true
+  void stop();
+  bool finished() const { return exited.load(std::memory_order_acquire); }
+
+  // Render thread. Swaps job with the mailbox, so the caller gets an old
+  // job's allocations back to fill next time.
+  void submit(GeometryJob &job);
+
+  // Render thread. True if newer geometry was taken into vertices().
+  bool acquire() { return frames.acquire(); }
+  const std::vector<sf::Vertex> &vertices() const {
+    return frames.readBuffer();
+  }
+
+private:
+  void produceLoop();
+
+  std::mutex mutex;
+  std::condition_variable jobReady;
+  GeometryJob pending;
+  bool hasPending = false;
+  bool running = true;
+  std::atomic<bool> exited{false};
+
+  GeometryJob working; // Producer thread only
+  TripleBuffer<std::vector<sf::Vertex>> frames;
+  std::thread producerThread;
+};
+
+// A store's producer, started on first use. Joining a producer can wait
+// out a whole build, so one that is replaced, by retire() or by moving
+// another slot over this one, is stopped and kept until its thread has
+// exited; later calls to acquire() destroy those that have.
+class GeometryProducerSlot {
+public:
+  GeometryProducerSlot() = default;
+  GeometryProducerSlot(GeometryProducerSlot &&) = default;
+  GeometryProducerSlot &operator=(GeometryProducerSlot &&other);
+
+  // The current producer, started if there is none
+  GeometryProducer &acquire();
+  GeometryProducer *get() const { return current.get(); }
+  void retire();
+
+private:
+  void pruneRetired();
+
+  std::unique_ptr<GeometryProducer> current;
+  std::vector<std::unique_ptr<GeometryProducer>> retired; // Stopping
+};
+
+#endif // GEOMETRY_PRODUCER_H
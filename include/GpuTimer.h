@@ -0,0 +1,40 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include "PerfTimers.h"
+#include <array>
+
+// Measures GPU time between begin() and end() with timer queries. Results
+// are read back frames later, and a measurement is skipped rather than
+// waited for, so timing never stalls the pipeline. Queries belong to the
+// context that is active at begin(); use one timer per render target and
+// abandon() it when that target's context is recreated. Query names are
+// released with their context. Timers on one context must not overlap.
+class GpuTimer {
+public:
+  explicit GpuTimer(perf::RollingHistogram &histogram)
+      : histogram(histogram) {}
+
+  // Needs an active context the first time
+  static bool isAvailable();
+
+  void begin();
+  void end();
+
+  // Forget queries whose context is gone
+  void abandon();
+
+private:
+  void collect();
+
+  static constexpr size_t QUERY_COUNT = 4;
+
+  perf::RollingHistogram &histogram;
+  std::array<unsigned int, QUERY_COUNT> queries{};
+  std::array<bool, QUERY_COUNT> pending{};
+  size_t next = 0;
+  bool created = false;
+  bool running = false;
+};
+
+#endif // GPU_TIMER_H
@@ -2,10 +2,15 @@
 #define IMGUI_RAII_H
 
 #include <SFML/Graphics.hpp>
+#include <SFML/OpenGL.hpp>
 #include <imgui-SFML.h>
 #include <imgui.h>
 #include <implot.h>
 
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
 // RAII wrapper for ImGui to handle automatic initialization and shutdown
 class ImGuiRAII {
 public:
@@ -36,6 +41,17 @@ public:
 
   // Render ImGui
   void render() { ImGui::SFML::Render(window_); }
+  void render(sf::RenderTarget &target) { ImGui::SFML::Render(target); }
+
+  // Render into a target cleared to transparent, leaving premultiplied
+  // colour for compositing with One, OneMinusSrcAlpha. ImGui-SFML blends
+  // alpha like colour, which would square the coverage of translucent
+  // windows, so its blend is replaced by one that accumulates coverage
+  // before any window draws.
+  void renderPremultiplied(sf::RenderTarget &target) {
+    ImGui::GetBackgroundDrawList()->AddCallback(&premultipliedBlend, nullptr);
+    ImGui::SFML::Render(target);
+  }
 
   // Deleted copy/move constructors and assignment to ensure proper RAII
   // behavior
@@ -45,6 +61,17 @@ public:
   ImGuiRAII &operator=(ImGuiRAII &&) = delete;
 
 private:
+  static void premultipliedBlend(const ImDrawList *, const ImDrawCmd *) {
+    // Core since OpenGL 1.4 but absent from the 1.1 headers
+    using BlendFuncSeparate = void(APIENTRY *)(GLenum, GLenum, GLenum, GLenum);
+    static const auto blendFuncSeparate = reinterpret_cast<BlendFuncSeparate>(
+        sf::Context::getFunction("glBlendFuncSeparate"));
+    if (blendFuncSeparate) {
+      blendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE,
+                        GL_ONE_MINUS_SRC_ALPHA);
+    }
+  }
+
   sf::RenderWindow &window_;
 };
 
@@ -0,0 +1,137 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <variant>
+
+namespace json {
+
+struct Error {
+  size_t offset = 0; // Byte offset into the document where parsing failed
+  std::string message;
+};
+
+// Single-pass pull parser over an in-memory JSON document. Keys and strings
+// are read as views into the input and numbers with std::from_chars, so no
+// temporary strings are created. The first syntax error stops all further
+// reads and records its byte offset.
+class Reader {
+public:
+  explicit Reader(std::string_view input) : input(input) {}
+
+  // Objects: beginObject(), then nextKey() before each member's value until
+  // it returns false at the closing brace
+  bool beginObject();
+  bool nextKey(std::string_view &key);
+
+  // Arrays: beginArray(), then nextElement() before each value until it
+  // returns false at the closing bracket
+  bool beginArray();
+  bool nextElement();
+
+  bool readNumber(double &value);
+  bool readBool(bool &value);
+  bool readString(std::string &value);
+  bool skipValue();
+
+  // Succeeds if nothing but whitespace follows the top-level value
+  bool finish();
+
+  bool failed() const { return hasError; }
+  const Error &error() const { return err; }
+
+private:
+  static constexpr int MAX_DEPTH = 64;
+
+  void skipWhitespace();
+  bool expect(char c);
+  bool readRawString(std::string_view &raw);
+  bool fail(const char *message);
+
+  std::string_view input;
+  size_t pos = 0;
+  int depth = 0;
+  bool firstMember = false; // Next member is the first of its container
+  bool hasError = false;
+  Error err;
+};
+
+// Escapes a string for embedding between quotes in a JSON document
+std::string escape(std::string_view value);
+
+// JSON has no NaN or infinity, so writers pass floats through this: NaN is
+// written as 0 and infinities as the largest float of their sign
+inline float number(float value) {
+  if (std::isnan(value)) {
+    return 0.0f;
+  }
+  return std::clamp(value, std::numeric_limits<float>::lowest(),
+                    std::numeric_limits<float>::max());
+}
+
+// Binds a JSON key to a struct member. Tables of these are built at compile
+// time and drive readObject(), replacing per-key document searches.
+template <typename T> struct Field {
+  std::string_view key;
+  std::variant<float T::*, int T::*, std::uint8_t T::*, bool T::*> member;
+};
+
+template <typename T>
+bool readField(Reader &reader, T &target, const Field<T> &field) {
+  if (std::holds_alternative<bool T::*>(field.member)) {
+    return reader.readBool(target.*std::get<bool T::*>(field.member));
+  }
+
+  double number = 0.0;
+  if (!reader.readNumber(number)) {
+    return false;
+  }
+
+  if (auto member = std::get_if<float T::*>(&field.member)) {
+    target.**member = static_cast<float>(number);
+  } else if (auto member = std::get_if<int T::*>(&field.member)) {
+    target.**member = static_cast<int>(
+        std::clamp(number, double(std::numeric_limits<int>::min()),
+                   double(std::numeric_limits<int>::max())));
+  } else if (auto member = std::get_if<std::uint8_t T::*>(&field.member)) {
+    target.**member =
+        static_cast<std::uint8_t>(std::clamp(number, 0.0, 255.0));
+  }
+  return true;
+}
+
+// Reads one object into target through its field table. Unknown keys are
+// skipped so presets written by newer versions still load.
+template <typename T, size_t N>
+bool readObject(Reader &reader, T &target, const Field<T> (&fields)[N]) {
+  if (!reader.beginObject()) {
+    return false;
+  }
+
+  std::string_view key;
+  while (reader.nextKey(key)) {
+    const Field<T> *match = nullptr;
+    for (const Field<T> &field : fields) {
+      if (field.key == key) {
+        match = &field;
+        break;
+      }
+    }
+
+    bool ok = match ? readField(reader, target, *match) : reader.skipValue();
+    if (!ok) {
+      return false;
+    }
+  }
+  return !reader.failed();
+}
+
+} // namespace json
+
+#endif // JSON_READER_H
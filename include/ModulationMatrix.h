@@ -0,0 +1,177 @@
+#ifndef MODULATION_MATRIX_H
+#define MODULATION_MATRIX_H
+
+#include "ShaderConfig.h"
+#include "WaveformConfig.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace json {
+class Reader;
+}
+
+// Signals a route can follow, each in [0, 1]. Band reads one spectrum band,
+// chosen by the route.
+enum class ModSource {
+  Rms,
+  Peak,
+  BeatPhase,
+  BeatPulse,
+  Lfo1,
+  Lfo2,
+  Lfo3,
+  Lfo4,
+  Band,
+  Count
+};
+
+// Shaping applied to a source before it is scaled by depth
+enum class ModCurve { Linear, Square, SquareRoot, Smooth, Count };
+
+// Parameters a route can drive. Waveform targets come first; the rest are
+// ShaderConfig members.
+enum class ModTarget {
+  DisplayHeight,
+  RotationSpeed,
+  RadiusFactor,
+  Thickness,
+  HueOffset,
+  Alpha,
+  ThickAlpha,
+  FadeFactor,
+  PixelSize,
+  BlendFactor,
+  FadeThreshold,
+  SaturationBoost,
+  DitherStrength,
+  Count
+};
+
+constexpr size_t WAVEFORM_TARGET_COUNT =
+    static_cast<size_t>(ModTarget::FadeFactor);
+constexpr size_t SHADER_TARGET_COUNT =
+    static_cast<size_t>(ModTarget::Count) - WAVEFORM_TARGET_COUNT;
+
+// Display name and range of a target. Depth is a fraction of the range and
+// modulated values are clamped to it, except hue offsets, which wrap.
+struct ModTargetInfo {
+  const char *name;
+  float minimum;
+  float maximum;
+};
+
+const ModTargetInfo &targetInfo(ModTarget target);
+const char *sourceName(ModSource source);
+const char *curveName(ModCurve curve);
+
+// One source driving one parameter. Enums are stored as ints, like
+// WaveformConfig::interpolation, so the preset field table can read them.
+struct ModulationRoute {
+  int source = static_cast<int>(ModSource::Rms);
+  int band = 0; // Spectrum band for ModSource::Band
+  int curve = static_cast<int>(ModCurve::Linear);
+  int target = static_cast<int>(ModTarget::DisplayHeight);
+  int waveform = -1; // Draw-order index, or -1 for every waveform
+  float depth = 0.25f; // Fraction of the target's range; negative pushes down
+  bool enabled = true;
+
+  ModSource getSource() const;
+  ModCurve getCurve() const;
+  ModTarget getTarget() const;
+  bool isShaderTarget() const {
+    return static_cast<size_t>(getTarget()) >= WAVEFORM_TARGET_COUNT;
+  }
+
+  std::string toJSON(int indent = 0) const;
+  bool fromJSON(json::Reader &reader);
+};
+
+// Everything about modulation that a preset saves
+struct ModulationSettings {
+  static constexpr size_t LFO_COUNT = 4;
+
+  std::array<float, LFO_COUNT> lfoRates = {0.1f, 0.25f, 0.5f, 1.0f}; // Hz
+  std::vector<ModulationRoute> routes;
+
+  std::string toJSON(int indent = 0) const;
+  bool fromJSON(json::Reader &reader);
+};
+
+// This frame's audio-derived sources
+struct ModulationInputs {
+  float rms = 0.0f;  // Linear, as in AnalysisFrame
+  float peak = 0.0f;
+  float beatPhase = -1.0f; // -1 when no beat is tracked
+  float beatPulse = 0.0f;  // Decaying envelope from the last beat
+  const float *bands = nullptr; // Levels in [0, 1]
+  size_t bandCount = 0;
+};
+
+// Routes audio-derived sources and LFOs to waveform and shader parameters.
+// Routes are compiled into flat arrays whenever they or the number of
+// waveforms or bands change, with every-waveform routes expanded per
+// waveform, curves folded into the source index and routes grouped by the
+// parameter they drive. Each frame then shapes every source under every
+// curve once and makes one branch-free pass over the arrays, summing depth
+// times shaped source for each parameter in a register before storing its
+// offset. Configs are never modified; the apply functions write modulated
+// copies for the frame.
+class ModulationMatrix {
+public:
+  const ModulationSettings &getSettings() const { return settings; }
+  void setSettings(const ModulationSettings &newSettings);
+
+  // Drops routes to a removed waveform and renumbers those after it
+  void removeWaveform(size_t index);
+
+  // Whether any enabled route reads the spectrum
+  bool usesBands() const;
+
+  // Advance the LFOs and evaluate every route for this frame
+  void evaluate(const ModulationInputs &inputs, size_t waveformCount,
+                float deltaTime);
+
+  // Whether the last evaluate() had any routes to apply
+  bool isActive() const { return !routeSources.empty(); }
+  size_t getCompiledRouteCount() const { return routeSources.size(); }
+
+  // Base configs plus this frame's offsets. Waveforms beyond the count
+  // evaluated for are copied unchanged.
+  void applyToWaveforms(const std::vector<WaveformConfig> &base,
+                        std::vector<WaveformConfig> &out) const;
+  void applyToShader(ShaderConfig &shader) const;
+
+  // Base configs with the thickness and thick alpha at the most the routes
+  // can push them, so a geometry layout made from them holds every frame's
+  // thick pass and only changes when the routes or configs do
+  void applyLayoutBounds(const std::vector<WaveformConfig> &base,
+                         std::vector<WaveformConfig> &out) const;
+
+  // Current value of each source, for display
+  float getSourceValue(ModSource source, int band = 0) const;
+
+private:
+  void compile(size_t waveformCount, size_t bandCount);
+
+  ModulationSettings settings;
+  bool dirty = true;
+  std::array<double, ModulationSettings::LFO_COUNT> lfoPhases{};
+
+  // Compiled routes grouped by destination: the routes of run r end at
+  // runEnds[r] and all drive runDestinations[r]
+  std::vector<std::uint32_t> routeSources; // curve * sourceCount + source
+  std::vector<float> routeDepths; // Pre-scaled by the target's range
+  std::vector<std::uint32_t> runDestinations;
+  std::vector<std::uint32_t> runEnds;
+  size_t compiledWaveforms = 0;
+  size_t compiledBands = 0;
+
+  std::vector<float> sources; // Raw source values this frame
+  std::vector<float> shaped;  // Every source under every curve
+  std::vector<float> offsets; // Per waveform target, then shader targets
+  std::vector<float> maxOffsets; // Largest each offset can be, as offsets
+};
+
+#endif // MODULATION_MATRIX_H
@@ -0,0 +1,98 @@
+#ifndef PERF_TIMERS_H
+#define PERF_TIMERS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace perf {
+
+// Rolling distribution of the last WINDOW timings. Samples go into a ring
+// and into log-spaced bucket counts, so percentiles cost a walk over the
+// buckets instead of a sort. Recording and reading are lock-free; any
+// thread may record, and a reader racing a writer sees at worst one sample
+// out of place, which is fine for display.
+class RollingHistogram {
+public:
+  static constexpr size_t WINDOW = 512;
+  static constexpr size_t BUCKETS = 96;
+
+  void record(float milliseconds);
+
+  // Value below which the given fraction of the window lies; 0 when empty
+  float percentile(float fraction) const;
+
+  // The window oldest first
+  void copyRecent(std::vector<float> &out) const;
+
+  float getLatest() const;
+  std::uint64_t getCount() const {
+    return written.load(std::memory_order_acquire);
+  }
+
+private:
+  std::array<std::atomic<float>, WINDOW> samples{};
+  std::array<std::atomic<std::int32_t>, BUCKETS> counts{};
+  std::atomic<std::uint64_t> written{0};
+};
+
+// Everything timed per frame, in pipeline order
+enum class Timer {
+  Capture,       // Capture thread: read, downmix and resample a packet
+  Conditioning,  // Level analysis and gain
+  Smoothing,     // Mirrored and smoothed sample rows
+  Modulation,    // Evaluating the modulation matrix
+  Geometry,      // Geometry stage: inline geometry, or submitting a job
+  GeometryBuild, // Producer thread: building a submitted job
+  Upload,        // Vertex buffer and sample texture updates
+  TrailShader,   // Fade and blur pass
+  Waveforms,     // Drawing bars and waveforms into the trail
+  ImGui,         // Building and rendering the UI
+  Present,       // Compositing the UI; the vsync wait is not counted
+  Frame,         // Interval between presented frames
+  Count
+};
+
+constexpr size_t TIMER_COUNT = static_cast<size_t>(Timer::Count);
+
+// Waveforms beyond this many share no per-waveform timing
+constexpr size_t MAX_TIMED_WAVEFORMS = 16;
+
+const char *timerName(Timer timer);
+
+RollingHistogram &cpuTimes(Timer timer);
+RollingHistogram &gpuTimes(Timer timer);
+
+// Geometry cost of one waveform, or nullptr past MAX_TIMED_WAVEFORMS
+RollingHistogram *waveformTimes(size_t index);
+
+// Records the time from construction to destruction; a null histogram
+// makes it a no-op
+class ScopedTimer {
+public:
+  explicit ScopedTimer(Timer timer) : ScopedTimer(&cpuTimes(timer)) {}
+  explicit ScopedTimer(RollingHistogram *histogram)
+      : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+
+  ~ScopedTimer() {
+    if (histogram) {
+      histogram->record(std::chrono::duration<float, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count());
+    }
+  }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  RollingHistogram *histogram;
+  std::chrono::steady_clock::time_point start;
+};
+
+} // namespace perf
+
+#endif // PERF_TIMERS_H
@@ -0,0 +1,39 @@
+#ifndef POLYPHASE_RESAMPLER_H
+#define POLYPHASE_RESAMPLER_H
+
+#include <cstddef>
+#include <vector>
+
+// Streaming rational resampler (up by L, filter, down by M) as a polyphase
+// filter bank, so only the taps of the phase each output lands on are
+// evaluated. The low-pass sits below the lower of the two Nyquist rates,
+// so decimation does not alias. Equal rates pass samples straight through.
+class PolyphaseResampler {
+public:
+  // tapsPerPhase is scaled up with the decimation ratio to keep the
+  // transition band narrow relative to the output rate
+  PolyphaseResampler(unsigned int inputRate, unsigned int outputRate,
+                     size_t tapsPerPhase = 32);
+
+  unsigned int getInputRate() const { return inputRate; }
+  unsigned int getOutputRate() const { return outputRate; }
+
+  // Appends the resampled samples to output
+  void process(const float *input, size_t count, std::vector<float> &output);
+
+private:
+  unsigned int inputRate;
+  unsigned int outputRate;
+  size_t upFactor = 1;   // L
+  size_t downFactor = 1; // M
+  size_t taps = 0;       // Per phase
+
+  // Phase p's taps at [p * taps, (p + 1) * taps), oldest sample first
+  std::vector<float> coefficients;
+
+  std::vector<float> history; // Last taps inputs, stored twice
+  size_t historyPos = 0;
+  size_t phase = 0; // Next output's position between inputs, in 1/L steps
+};
+
+#endif // POLYPHASE_RESAMPLER_H
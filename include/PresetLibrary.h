@@ -0,0 +1,64 @@
+#ifndef PRESET_LIBRARY_H
+#define PRESET_LIBRARY_H
+
+#include "ConfigSerializer.h"
+#include "DirectoryWatcher.h"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// In-memory index of the presets directory, kept up to date by a background
+// thread that watches the directory and re-parses only the files that
+// changed. The render thread only ever copies out of the index.
+class PresetLibrary {
+public:
+  explicit PresetLibrary(const std::string &directory = "presets");
+  ~PresetLibrary();
+
+  PresetLibrary(const PresetLibrary &) = delete;
+  PresetLibrary &operator=(const PresetLibrary &) = delete;
+
+  // Incremented whenever the set of presets or any preset's contents change
+  std::uint64_t getVersion() const { return version.load(); }
+
+  // Sorted filenames of all presets that parsed successfully
+  std::vector<std::string> getPresetNames() const;
+
+  // Copy of an indexed preset; false if it is unknown or failed to parse
+  bool getPreset(const std::string &filename, VisualizerPreset &preset) const;
+
+  // Filenames whose contents changed since the last call
+  std::vector<std::string> takeChangedPresets();
+
+  // Queue a full rescan; unchanged files are still not re-parsed
+  void rescan() { rescanRequested = true; }
+
+private:
+  struct Entry {
+    VisualizerPreset preset;
+    std::filesystem::file_time_type writeTime;
+  };
+
+  void watchLoop();
+  void scanDirectory();
+  void reloadFile(const std::string &filename);
+  void removeFile(const std::string &filename);
+
+  std::string directory;
+
+  mutable std::mutex mutex; // Guards entries and changed
+  std::map<std::string, Entry> entries;
+  std::vector<std::string> changed;
+
+  std::atomic<std::uint64_t> version{0};
+  std::atomic<bool> rescanRequested{false};
+  std::atomic<bool> running{true};
+  std::thread watchThread;
+};
+
+#endif // PRESET_LIBRARY_H
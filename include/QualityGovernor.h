@@ -0,0 +1,73 @@
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+#include "RenderQuality.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Holds the frame rate by trading detail for time. Each rendered frame
+// reports how long its work took; when the recent average runs over the
+// target the governor steps down a quality ladder, and once there is ample
+// headroom for a sustained period it steps back up.
+//
+// Hysteresis keeps it from oscillating: the step-up threshold is well
+// below the step-down one, every change is followed by a cooldown while
+// the average refills, and a step up that has to be undone soon after
+// doubles the wait before the next one. Each stretch that long in which a
+// step up holds halves the wait again, back down to the minimum.
+class QualityGovernor {
+public:
+  // A level change and why it was made
+  struct Decision {
+    std::uint64_t frame = 0;
+    size_t fromLevel = 0;
+    size_t toLevel = 0;
+    float averageMs = 0.0f;
+    float targetMs = 0.0f;
+  };
+
+  QualityGovernor();
+
+  // Levels from full quality (0) down to the cheapest
+  static const std::vector<RenderQuality> &ladder();
+
+  void setEnabled(bool enabled);
+  bool isEnabled() const { return enabled; }
+  void setTargetMs(float milliseconds) { targetMs = milliseconds; }
+  float getTargetMs() const { return targetMs; }
+
+  // Report one frame's work time; returns true if the level changed
+  bool addFrame(float frameMs);
+
+  size_t getLevel() const { return level; }
+  const RenderQuality &getQuality() const { return ladder()[level]; }
+  float getAverageMs() const { return averageMs; }
+  const std::deque<Decision> &getDecisions() const { return decisions; }
+
+private:
+  void changeLevel(size_t newLevel);
+
+  bool enabled = true;
+  float targetMs = 1000.0f / 60.0f;
+  size_t level = 0;
+
+  // Recent frame times, circular, with their running sum
+  std::vector<float> frameTimes;
+  size_t framePos = 0;
+  size_t frameCount = 0;
+  float frameSum = 0.0f;
+  float averageMs = 0.0f;
+
+  std::uint64_t frameNumber = 0;
+  std::uint64_t lastChangeFrame = 0;
+  std::uint64_t lastUpgradeFrame = 0;
+  std::uint64_t holdingSince = 0; // Step up holding since; 0 once undone
+  size_t headroomFrames = 0; // Consecutive frames with room to step up
+  size_t upgradeHold;        // Frames of headroom needed to step up
+
+  std::deque<Decision> decisions;
+};
+
+#endif // QUALITY_GOVERNOR_H
@@ -0,0 +1,21 @@
+#ifndef RADIAL_BARS_H
+#define RADIAL_BARS_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+// Spectrum bars standing out from a circle, one per analyser band. All bars
+// are quads in a single triangle array, so any number of them is one draw.
+class RadialBars {
+public:
+  // levels are in [0, 1]; barHeight is the length of a full-scale bar in px
+  void update(const std::vector<float> &levels, float hue, float rotationAngle,
+              float width, float height, float radiusFactor, float barHeight,
+              float opacity = 1.0f);
+  void render(sf::RenderTarget &target) const;
+
+private:
+  sf::VertexArray vertices{sf::Triangles};
+};
+
+#endif // RADIAL_BARS_H
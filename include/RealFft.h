@@ -0,0 +1,45 @@
+#ifndef REAL_FFT_H
+#define REAL_FFT_H
+
+#include <cstddef>
+#include <fftw3.h>
+#include <mutex>
+#include <string>
+
+// FFTW's planner is not thread safe; every plan creation and destruction in
+// the app goes through this lock. Executing plans needs no lock.
+std::mutex &fftwPlannerMutex();
+
+// Plans are measured once per machine and kept as FFTW wisdom. Importing is
+// quick and may run on any thread; sizes planned before their wisdom is
+// known fall back to estimated plans. saveFftWisdom() measures those sizes
+// and rewrites the file; it belongs at shutdown, off the startup path.
+bool loadFftWisdom(const std::string &path);
+bool saveFftWisdom(const std::string &path);
+
+// Real-to-complex FFT of a fixed size with its own aligned buffers and plan.
+// Fill input(), call execute(), read size() / 2 + 1 bins from output().
+class RealFft {
+public:
+  explicit RealFft(size_t size);
+  ~RealFft();
+
+  RealFft(const RealFft &) = delete;
+  RealFft &operator=(const RealFft &) = delete;
+
+  size_t size() const { return fftSize; }
+  size_t bins() const { return fftSize / 2 + 1; }
+
+  double *input() { return in; }
+  const fftw_complex *output() const { return out; }
+
+  void execute() { fftw_execute(plan); }
+
+private:
+  size_t fftSize;
+  double *in = nullptr;
+  fftw_complex *out = nullptr;
+  fftw_plan plan = nullptr;
+};
+
+#endif // REAL_FFT_H
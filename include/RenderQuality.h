@@ -0,0 +1,13 @@
+#ifndef RENDER_QUALITY_H
+#define RENDER_QUALITY_H
+
+// Rendering settings that trade detail for frame time. The defaults are
+// full quality; QualityGovernor lowers them when frames run over budget.
+struct RenderQuality {
+  int pointMultiplier = 10;  // Interpolated points per mirrored sample
+  float thickStep = 0.5f;    // Radial spacing of the thick pass lines (px)
+  float trailScale = 1.0f;   // Trail texture resolution relative to the view
+  int jitterSamples = 8;     // Pixelation samples per axis in fade_blur.frag
+};
+
+#endif // RENDER_QUALITY_H
@@ -0,0 +1,49 @@
+#ifndef SESSION_FILE_H
+#define SESSION_FILE_H
+
+#include <cstdint>
+
+// Layout of a recorded session. After the file header the file is a flat
+// sequence of chunks, each a ChunkHeader followed by its payload, in the
+// order they were recorded. Fields are in native byte order; sessions are
+// replayed on the kind of machine that recorded them.
+namespace session {
+
+constexpr char MAGIC[8] = {'A', 'T', 'S', 'E', 'S', 'S', 'N', '\0'};
+constexpr std::uint32_t VERSION = 1;
+
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t reserved;
+};
+
+enum class ChunkType : std::uint32_t {
+  Audio = 1,  // AudioChunk, then frames * channels interleaved floats
+  Config = 2, // ConfigChunk, then the preset as JSON
+};
+
+struct ChunkHeader {
+  ChunkType type;
+  std::uint32_t payloadBytes;
+};
+
+constexpr std::uint32_t AUDIO_SILENT = 1; // No samples follow
+
+// One capture packet as the device delivered it
+struct AudioChunk {
+  std::int64_t captureTimeNs; // steady_clock time of the first frame
+  std::uint32_t sampleRate;
+  std::uint32_t channels;
+  std::uint32_t frames;
+  std::uint32_t flags;
+};
+
+// The complete visualizer state after a change
+struct ConfigChunk {
+  std::int64_t timeNs; // steady_clock time of the change
+};
+
+} // namespace session
+
+#endif // SESSION_FILE_H
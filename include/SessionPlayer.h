@@ -0,0 +1,55 @@
+#ifndef SESSION_PLAYER_H
+#define SESSION_PLAYER_H
+
+#include "AudioCapture.h"
+#include "SessionFile.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Replays a recorded session (see SessionRecorder) as an audio source.
+// Packets come out with their recorded sizes and spacing, and go through
+// the same downmix, packet callback and resampling as live capture.
+// Recorded configuration changes are queued for the main thread at the
+// point in the replay where they happened.
+class SessionPlayer : public capture::AudioSource {
+public:
+  explicit SessionPlayer(const std::string &path);
+
+  bool initialize() override;
+  bool captureAudio(std::vector<float> &monoFrames) override;
+  UINT32 getSampleRate() const override { return sampleRate; }
+
+  // Preset JSON for every configuration change that has come due
+  std::vector<std::string> takeConfigChanges();
+
+  bool isFinished() const { return finished.load(); }
+
+private:
+  // Read the next chunk into the pending fields; false at the end
+  bool readChunk();
+  std::int64_t pendingTimeNs() const;
+
+  std::string path;
+  std::ifstream file;
+  UINT32 sampleRate = 0;
+
+  session::ChunkHeader header{};
+  std::vector<std::uint8_t> payload;
+  bool hasPending = false;
+  std::atomic<bool> finished{false};
+
+  // Recorded time of the first chunk and when replay of it began
+  std::int64_t recordedOriginNs = 0;
+  std::chrono::steady_clock::time_point replayOrigin;
+  bool started = false;
+
+  std::mutex configMutex;
+  std::vector<std::string> configChanges;
+};
+
+#endif // SESSION_PLAYER_H
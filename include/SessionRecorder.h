@@ -0,0 +1,79 @@
+#ifndef SESSION_RECORDER_H
+#define SESSION_RECORDER_H
+
+#include "SessionFile.h"
+#include "SpscRingBuffer.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records capture packets and configuration changes to a session file for
+// replay (see SessionPlayer). The capture thread and one other thread each
+// write chunks into their own lock-free ring; a writer thread moves whole
+// chunks from the rings to disk in large blocks. Neither producer ever
+// blocks or touches the file: when a ring is full the chunk is dropped and
+// counted.
+class SessionRecorder {
+public:
+  SessionRecorder();
+  ~SessionRecorder();
+
+  SessionRecorder(const SessionRecorder &) = delete;
+  SessionRecorder &operator=(const SessionRecorder &) = delete;
+
+  bool start(const std::string &path);
+  void stop();
+  bool isRecording() const { return recording.load(std::memory_order_acquire); }
+
+  // Capture thread only. data is interleaved, or null for a silent packet.
+  void recordPacket(const float *data, std::uint32_t frames,
+                    std::uint32_t channels, std::uint32_t sampleRate,
+                    std::int64_t captureTimeNs);
+
+  // One thread other than capture, typically the UI
+  void recordConfig(const std::string &presetJson, std::int64_t timeNs);
+
+  const std::string &getPath() const { return path; }
+  std::uint64_t getBytesWritten() const { return bytesWritten.load(); }
+  std::uint64_t getDroppedChunks() const { return droppedChunks.load(); }
+
+private:
+  // One producer's chunks and the writer's position within them
+  struct Stream {
+    explicit Stream(size_t capacity) : ring(capacity) {}
+
+    SpscRingBuffer<std::uint8_t> ring;
+    session::ChunkHeader header{};
+    bool hasHeader = false;
+  };
+
+  // Reserve room for a whole chunk, then write its parts; false if full
+  bool beginChunk(Stream &stream, session::ChunkType type,
+                  std::uint32_t payloadBytes);
+  void writeLoop();
+  void drain(Stream &stream);
+  void writeStaged(bool all);
+
+  Stream audio;
+  Stream events;
+
+  std::atomic<bool> recording{false};
+  std::atomic<int> producers{0}; // Producers between checking and writing
+  std::atomic<std::uint64_t> bytesWritten{0};
+  std::atomic<std::uint64_t> droppedChunks{0};
+
+  std::string path;
+  std::FILE *file = nullptr;
+  std::vector<std::uint8_t> staging; // Whole chunks waiting for a block
+  std::thread writer;
+  std::mutex wakeMutex;
+  std::condition_variable wake;
+  bool stopping = false;
+};
+
+#endif // SESSION_RECORDER_H
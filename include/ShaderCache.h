@@ -0,0 +1,21 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <SFML/Graphics.hpp>
+#include <string>
+
+namespace shaders {
+
+// Loads a single-stage shader from a source file like
+// sf::Shader::loadFromFile, but reuses the program binary saved by an
+// earlier run when the source and the driver are unchanged, skipping the
+// driver's compile and link. Falls back to compiling the source whenever
+// program binaries are unavailable or the cached one is rejected, and
+// saves the result under cache/shaders for next time. Needs an active
+// context.
+bool loadCached(sf::Shader &shader, const std::string &path,
+                sf::Shader::Type type);
+
+} // namespace shaders
+
+#endif // SHADER_CACHE_H
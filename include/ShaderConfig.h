@@ -1,6 +1,7 @@
 #ifndef SHADER_CONFIG_H
 #define SHADER_CONFIG_H
 
+#include "JsonReader.h"
 #include <string>
 #include <sstream>
 
@@ -19,17 +20,17 @@ struct ShaderConfig {
     std::string indentStr(indent, ' ');
     std::ostringstream oss;
     oss << indentStr << "{\n";
-    oss << indentStr << "  \"fadeFactor\": " << fadeFactor << ",\n";
+    oss << indentStr << "  \"fadeFactor\": " << json::number(fadeFactor) << ",\n";
     oss << indentStr << "  \"pixelSize\": " << pixelSize << ",\n";
-    oss << indentStr << "  \"blendFactor\": " << blendFactor << ",\n";
-    oss << indentStr << "  \"fadeThreshold\": " << fadeThreshold << ",\n";
-    oss << indentStr << "  \"saturationBoost\": " << saturationBoost << ",\n";
-    oss << indentStr << "  \"ditherStrength\": " << ditherStrength << "\n";
+    oss << indentStr << "  \"blendFactor\": " << json::number(blendFactor) << ",\n";
+    oss << indentStr << "  \"fadeThreshold\": " << json::number(fadeThreshold) << ",\n";
+    oss << indentStr << "  \"saturationBoost\": " << json::number(saturationBoost) << ",\n";
+    oss << indentStr << "  \"ditherStrength\": " << json::number(ditherStrength) << "\n";
     oss << indentStr << "}";
     return oss.str();
   }
   
-  void fromJSON(const std::string& json);
+  bool fromJSON(json::Reader &reader);
 };
 
 #endif // SHADER_CONFIG_H
@@ -0,0 +1,81 @@
+#ifndef SHARED_ANALYSIS_LAYOUT_H
+#define SHARED_ANALYSIS_LAYOUT_H
+
+/*
+ * Layout of the shared-memory analysis ring written by
+ * SharedMemoryPublisher and read by tools/shm_reader. Plain C so readers in
+ * other languages can map it directly.
+ *
+ * The region is one atshm_header followed by slot_count atshm_frame slots.
+ * Frame n (counting from 1) is written to slot (n - 1) % slot_count. Each
+ * slot is a seqlock: its sequence is odd while the slot is being written
+ * and 2 * n once frame n is complete, so a reader that sees the same even
+ * sequence before and after reading has a consistent frame. The header's
+ * frame count is raised after the slot is complete.
+ *
+ * The sequence and frame count are 64-bit aligned and accessed
+ * atomically; everything else is only read between two sequence checks.
+ * On POSIX the region outlives the writer, and a restarted writer continues
+ * the frame count, so readers can stay attached.
+ */
+
+#include <stdint.h>
+
+#define ATSHM_MAGIC 0x4D485341u /* "ASHM" */
+#define ATSHM_VERSION 1u
+
+/* shm_open name on POSIX; on Windows the mapping is named "Local\" plus the
+   name without its leading slash */
+#define ATSHM_DEFAULT_NAME "/audiothing-analysis"
+
+#define ATSHM_SLOT_COUNT 8u
+#define ATSHM_MAX_SAMPLES 4096u
+#define ATSHM_MAX_BINS 4097u
+#define ATSHM_MAX_BANDS 256u
+
+typedef struct atshm_header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t slot_count;
+  uint32_t frame_bytes; /* sizeof(atshm_frame) */
+  uint64_t frame_count; /* Frames published; atomic */
+  uint64_t writer_pid;
+  uint64_t reserved[4];
+} atshm_header;
+
+typedef struct atshm_frame {
+  uint64_t sequence; /* Odd while written, 2 * frame number when complete */
+  int64_t time_ns;   /* Publisher's steady clock */
+
+  /* Conditioned waveform at the visual rate; multiply by gain to get the
+     displayed level */
+  uint32_t sample_rate;
+  uint32_t sample_count;
+  float peak;
+  float rms;
+  float gain;
+  uint32_t silent;
+
+  /* Linear STFT magnitudes, 1.0 = full scale; bin_count = fft_size / 2 + 1
+     when the spectrum fits */
+  uint32_t fft_size;
+  uint32_t bin_count;
+
+  /* Smoothed log-spaced band levels in [0, 1] */
+  uint32_t band_count;
+
+  /* Beat tracking. beat_phase is the position within the current beat in
+     [0, 1), or -1 when no beat is tracked. Counts only ever increase. */
+  float bpm;
+  float beat_confidence;
+  float beat_phase;
+  uint64_t beat_count;
+  uint64_t onset_count;
+  int64_t last_beat_ns;
+
+  float samples[ATSHM_MAX_SAMPLES];
+  float spectrum[ATSHM_MAX_BINS];
+  float bands[ATSHM_MAX_BANDS];
+} atshm_frame;
+
+#endif /* SHARED_ANALYSIS_LAYOUT_H */
@@ -0,0 +1,69 @@
+#ifndef SHARED_MEMORY_PUBLISHER_H
+#define SHARED_MEMORY_PUBLISHER_H
+
+#include "SharedAnalysisLayout.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// One frame of analysis to export; spans may be empty
+struct SharedAnalysis {
+  std::int64_t timeNs = 0;
+
+  const double *samples = nullptr;
+  size_t sampleCount = 0;
+  unsigned int sampleRate = 0;
+  float peak = 0.0f;
+  float rms = 0.0f;
+  float gain = 1.0f;
+  bool silent = true;
+
+  const float *spectrum = nullptr; // fftSize / 2 + 1 magnitudes
+  size_t fftSize = 0;
+
+  const float *bands = nullptr;
+  size_t bandCount = 0;
+
+  float bpm = 0.0f;
+  float beatConfidence = 0.0f;
+  float beatPhase = -1.0f;
+  std::uint64_t beatCount = 0;
+  std::uint64_t onsetCount = 0;
+  std::int64_t lastBeatNs = 0;
+};
+
+// Writes analysis frames into a named shared-memory ring (POSIX shm_open,
+// or a named file mapping on Windows) for other local processes. Each slot
+// is guarded by a seqlock, so publishing never waits on readers and any
+// number of them can read in place without syscalls; see
+// SharedAnalysisLayout.h and the C reader in tools/shm_reader.
+class SharedMemoryPublisher {
+public:
+  SharedMemoryPublisher() = default;
+  ~SharedMemoryPublisher();
+
+  SharedMemoryPublisher(const SharedMemoryPublisher &) = delete;
+  SharedMemoryPublisher &operator=(const SharedMemoryPublisher &) = delete;
+
+  bool open(const std::string &name = ATSHM_DEFAULT_NAME);
+  void close();
+  bool isOpen() const { return header != nullptr; }
+
+  // Single writer thread
+  void publish(const SharedAnalysis &analysis);
+
+  const std::string &getName() const { return name; }
+  std::uint64_t getFramesPublished() const { return framesPublished; }
+
+private:
+  std::string name;
+  void *mapping = nullptr; // Windows mapping handle
+  void *view = nullptr;
+  size_t viewBytes = 0;
+
+  atshm_header *header = nullptr;
+  atshm_frame *slots = nullptr;
+  std::uint64_t framesPublished = 0;
+};
+
+#endif // SHARED_MEMORY_PUBLISHER_H
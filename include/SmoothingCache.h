@@ -0,0 +1,55 @@
+#ifndef SMOOTHING_CACHE_H
+#define SMOOTHING_CACHE_H
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+// Smoothing shared by every waveform for one audio frame. build() mirrors
+// the audio buffer and takes a single prefix sum over it, after which a box
+// average of any radius costs O(1) per sample. Smoothed buffers are kept
+// until the next build(), so waveforms with the same settings share them.
+//
+// Repeated box passes approach a Gaussian: 1 pass is a box filter, 2 a
+// triangle, 3 or more are close to bell shaped.
+class SmoothingCache {
+public:
+  static constexpr int MAX_PASSES = 4;
+
+  // Start a new frame from audio scaled by gain
+  void build(const std::vector<double> &audioBuffer, double gain = 1.0);
+
+  // The mirrored buffer waveforms are drawn from
+  const std::vector<double> &samples() const { return mirrored; }
+
+  // Average of samples()[index - radius .. index + radius], clamped to the
+  // buffer like smoothAudioData()
+  double boxAt(size_t index, int radius) const;
+
+  // samples() after the given number of box passes. A radius or pass count
+  // of zero returns samples() itself. Valid until the next build().
+  const std::vector<double> &smoothed(int radius, int passes = 1);
+
+private:
+  struct Entry {
+    int radius = 0;
+    int passes = 0;
+    std::vector<double> data;
+  };
+
+  static void buildPrefix(const std::vector<double> &data,
+                          std::vector<double> &prefixOut);
+  static void boxFilter(const std::vector<double> &prefixSums, int radius,
+                        std::vector<double> &out);
+
+  std::vector<double> mirrored;
+  std::vector<double> prefix; // prefix[k] = sum of mirrored[0 .. k)
+  std::vector<double> passPrefix; // Scratch for passes after the first
+
+  // Entries beyond entryCount are stale but keep their allocations. A deque
+  // so returned references survive later insertions.
+  std::deque<Entry> entries;
+  size_t entryCount = 0;
+};
+
+#endif // SMOOTHING_CACHE_H
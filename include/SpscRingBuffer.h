@@ -0,0 +1,77 @@
+#ifndef SPSC_RING_BUFFER_H
+#define SPSC_RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Lock-free ring buffer for exactly one producer thread and one consumer
+// thread. Capacity is rounded up to a power of two. The producer never
+// blocks; writes that do not fit are cut short and the caller decides what
+// to drop.
+template <typename T> class SpscRingBuffer {
+public:
+  explicit SpscRingBuffer(size_t minCapacity) {
+    size_t capacity = 1;
+    while (capacity < minCapacity) {
+      capacity <<= 1;
+    }
+    buffer.resize(capacity);
+    mask = capacity - 1;
+  }
+
+  SpscRingBuffer(const SpscRingBuffer &) = delete;
+  SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+  size_t capacity() const { return buffer.size(); }
+
+  // Producer side. Returns how many items were written.
+  size_t write(const T *items, size_t count) {
+    const size_t writePos = head.load(std::memory_order_relaxed);
+    const size_t readPos = tail.load(std::memory_order_acquire);
+    const size_t space = buffer.size() - (writePos - readPos);
+    if (count > space) {
+      count = space;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      buffer[(writePos + i) & mask] = items[i];
+    }
+    head.store(writePos + count, std::memory_order_release);
+    return count;
+  }
+
+  bool push(const T &item) { return write(&item, 1) == 1; }
+
+  // Consumer side. Returns how many items were read.
+  size_t read(T *items, size_t maxCount) {
+    const size_t readPos = tail.load(std::memory_order_relaxed);
+    const size_t writePos = head.load(std::memory_order_acquire);
+    size_t count = writePos - readPos;
+    if (count > maxCount) {
+      count = maxCount;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      items[i] = buffer[(readPos + i) & mask];
+    }
+    tail.store(readPos + count, std::memory_order_release);
+    return count;
+  }
+
+  bool pop(T &item) { return read(&item, 1) == 1; }
+
+  // Items waiting; exact only when called from the consumer
+  size_t size() const {
+    return head.load(std::memory_order_acquire) -
+           tail.load(std::memory_order_acquire);
+  }
+
+private:
+  std::vector<T> buffer;
+  size_t mask = 0;
+
+  // Kept on separate cache lines so the two threads don't share one
+  alignas(64) std::atomic<size_t> head{0}; // Next write, owned by producer
+  alignas(64) std::atomic<size_t> tail{0}; // Next read, owned by consumer
+};
+
+#endif // SPSC_RING_BUFFER_H
@@ -0,0 +1,103 @@
+#ifndef STFT_ENGINE_H
+#define STFT_ENGINE_H
+
+#include "RealFft.h"
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Streaming short-time Fourier transform over a mono stream.
+//
+// Samples go into a history ring stored twice over, so the latest window
+// is always contiguous and each hop is one windowed copy and one FFT with a
+// plan made once up front. A new spectrum is emitted every hopSize samples.
+//
+// A few bins can also be tracked sample by sample with a sliding DFT, for
+// features that need more time resolution than the hop gives them. Streams
+// with no tracked bins take a loop without the update, so they pay nothing
+// for it.
+class StftEngine {
+public:
+  // windowSize is the FFT length; hopSize must not exceed it
+  StftEngine(size_t windowSize, size_t hopSize);
+
+  size_t getWindowSize() const { return windowSize; }
+  size_t getHopSize() const { return hopSize; }
+  size_t getBinCount() const { return magnitudes.size(); }
+
+  // Samples consumed since construction
+  std::uint64_t getPosition() const { return position; }
+
+  // Feed samples; onFrame(magnitudes) runs after every hop with the
+  // Hann-windowed magnitude spectrum, scaled so a full-scale sine reads 1.0
+  // in its bin
+  template <typename OnFrame>
+  void process(const float *samples, size_t count, OnFrame &&onFrame) {
+    if (tracked.empty()) {
+      processSamples<false>(samples, count, onFrame);
+    } else {
+      processSamples<true>(samples, count, onFrame);
+    }
+  }
+
+  // Bins updated every sample by the sliding DFT. Each must lie in
+  // [1, windowSize / 2); others are clamped. Their state starts from the
+  // current window, so they read correctly straight away. Call between
+  // process() calls, not from onFrame.
+  void setTrackedBins(const std::vector<size_t> &bins);
+  size_t getTrackedBinCount() const { return tracked.size(); }
+
+  // Hann-windowed magnitude of a tracked bin as of the latest sample, on
+  // the same scale as the frame magnitudes
+  float getTrackedMagnitude(size_t index) const;
+
+private:
+  template <bool Track, typename OnFrame>
+  void processSamples(const float *samples, size_t count, OnFrame &onFrame) {
+    for (size_t i = 0; i < count; ++i) {
+      push<Track>(samples[i]);
+      if (++pendingSamples == hopSize) {
+        pendingSamples = 0;
+        transform();
+        onFrame(static_cast<const std::vector<float> &>(magnitudes));
+      }
+    }
+  }
+
+  template <bool Track> void push(float sample) {
+    float oldest = history[historyPos];
+    history[historyPos] = sample;
+    history[historyPos + windowSize] = sample;
+    if (++historyPos == windowSize) {
+      historyPos = 0;
+    }
+    ++position;
+
+    if constexpr (Track) {
+      slide(static_cast<double>(sample) - oldest);
+    }
+  }
+
+  void transform();
+  void slide(double difference);
+
+  size_t windowSize;
+  size_t hopSize;
+  std::unique_ptr<RealFft> fft;
+  std::vector<double> window; // Hann coefficients
+
+  std::vector<float> history; // Ring of windowSize samples, stored twice
+  size_t historyPos = 0;      // Oldest sample; next to be overwritten
+  size_t pendingSamples = 0;  // Samples since the last hop
+  std::uint64_t position = 0;
+  std::vector<float> magnitudes;
+
+  // Sliding DFT state: for each tracked bin k, bins k - 1, k and k + 1, so
+  // the Hann window can be applied in the frequency domain
+  std::vector<size_t> tracked;
+  std::vector<std::complex<double>> slidingBins;
+  std::vector<std::complex<double>> twiddles;
+};
+
+#endif // STFT_ENGINE_H
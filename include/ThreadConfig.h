@@ -0,0 +1,49 @@
+#ifndef THREAD_CONFIG_H
+#define THREAD_CONFIG_H
+
+#include <cstdint>
+#include <string>
+
+// Scheduling for the application's long-lived threads. Each thread applies
+// its role's policy itself, at startup and again whenever the policy
+// changes, so policies can be edited at runtime from any thread.
+enum class ThreadRole { Capture, Analysis, Geometry, Render, Count };
+
+enum class ThreadPriority {
+  Normal,
+  High,    // Above normal; a negative nice value on Linux
+  RealTime // MMCSS "Pro Audio" on Windows, SCHED_FIFO on Linux
+};
+
+struct ThreadPolicy {
+  ThreadPriority priority = ThreadPriority::Normal;
+  int core = -1; // Pinned core, or -1 to run on any
+};
+
+namespace threading {
+
+constexpr size_t ROLE_COUNT = static_cast<size_t>(ThreadRole::Count);
+
+const char *roleName(ThreadRole role);
+const char *priorityName(ThreadPriority priority);
+
+ThreadPolicy getPolicy(ThreadRole role);
+void setPolicy(ThreadRole role, const ThreadPolicy &policy);
+
+// Apply the role's policy to the calling thread. Whatever the OS refuses
+// falls back to the next lower priority and is logged; the thread keeps
+// running either way. Returns false if anything fell back.
+bool applyPolicy(ThreadRole role);
+
+// For thread loops: applies the policy the first time and after every
+// change. seenVersion starts at 0 and is owned by the calling thread.
+void refreshPolicy(ThreadRole role, std::uint64_t &seenVersion);
+
+// What the OS actually granted the role's thread, for display
+std::string getAppliedState(ThreadRole role);
+
+unsigned int getCoreCount();
+
+} // namespace threading
+
+#endif // THREAD_CONFIG_H
@@ -0,0 +1,76 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Chrome trace-event recording for offline analysis in Perfetto or
+// chrome://tracing. Each thread writes complete events into its own
+// lock-free ring; a background thread drains the rings into a JSON file
+// while a trace runs. When no trace is running a scope costs one relaxed
+// load, so instrumentation can stay in release builds.
+//
+// Event and thread names must be string literals or otherwise outlive the
+// trace; only the pointer is recorded.
+namespace trace {
+
+namespace detail {
+extern std::atomic<bool> enabled;
+}
+
+inline bool isEnabled() {
+  return detail::enabled.load(std::memory_order_relaxed);
+}
+
+// Begin writing a trace to path, replacing any file there. Returns false
+// if a trace is already running or the file cannot be opened.
+bool start(const std::string &path);
+
+// Flush the remaining events and close the file
+void stop();
+
+// Path of the running or most recent trace
+std::string getPath();
+
+// Events lost to full thread rings since the trace started
+std::uint64_t getDroppedEvents();
+
+// Name shown for the calling thread's track
+void setThreadName(const char *name);
+
+void record(const char *name, std::chrono::steady_clock::time_point begin,
+            std::chrono::steady_clock::time_point end);
+
+// Records the enclosing scope as one complete event
+class Scope {
+public:
+  explicit Scope(const char *name) : name(name), active(isEnabled()) {
+    if (active) {
+      begin = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~Scope() {
+    if (active) {
+      record(name, begin, std::chrono::steady_clock::now());
+    }
+  }
+
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+private:
+  const char *name;
+  bool active;
+  std::chrono::steady_clock::time_point begin;
+};
+
+} // namespace trace
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#endif // TRACER_H
@@ -0,0 +1,42 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free hand-off of the latest value from one producer thread to one
+// consumer thread. The producer fills its back buffer and publishes it; the
+// consumer picks up whatever was published most recently. With a third
+// buffer in the middle neither side ever waits or sees a torn value, and
+// intermediate values are simply skipped if the consumer is slower.
+template <typename T> class TripleBuffer {
+public:
+  // Producer only
+  T &writeBuffer() { return buffers[back]; }
+  void publish() {
+    back = middle.exchange(static_cast<std::uint8_t>(back | FRESH),
+                           std::memory_order_acq_rel) &
+           INDEX_MASK;
+  }
+
+  // Consumer only. True if a newer value was taken into readBuffer().
+  bool acquire() {
+    if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+      return false;
+    }
+    front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+    return true;
+  }
+  const T &readBuffer() const { return buffers[front]; }
+
+private:
+  static constexpr std::uint8_t INDEX_MASK = 0x3;
+  static constexpr std::uint8_t FRESH = 0x4;
+
+  T buffers[3];
+  std::uint8_t back = 0;
+  std::atomic<std::uint8_t> middle{1};
+  std::uint8_t front = 2;
+};
+
+#endif // TRIPLE_BUFFER_H
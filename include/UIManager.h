@@ -4,12 +4,21 @@
 #include "VisualizerConfig.h"
 #include "ShaderConfig.h"
 #include "ConfigSerializer.h"
+#include "PerfTimers.h"
+#include "PresetLibrary.h"
+#include <array>
+#include <cstdint>
 #include <imgui.h>
 #include <string>
 #include <vector>
 
-// Forward declaration
+// Forward declarations
 class AudioVisualizer;
+class FrameScheduler;
+class QualityGovernor;
+class SessionRecorder;
+class SharedMemoryPublisher;
+class VideoRecorder;
 
 class UIManager {
 public:
@@ -18,27 +27,74 @@ public:
 
   void drawUI(float fps, float frameTime, AudioVisualizer *visualizer = nullptr);
 
+  // Stage rates and costs are shown and edited when set
+  void setScheduler(FrameScheduler *frameScheduler) {
+    scheduler = frameScheduler;
+  }
+
+  // Session recording can be started and stopped when set
+  void setSessionRecorder(SessionRecorder *sessionRecorder) {
+    recorder = sessionRecorder;
+  }
+
+  // Video recording of the output can be started and stopped when set
+  void setVideoRecorder(VideoRecorder *recorder) { videoRecorder = recorder; }
+
+  // Shared-memory analysis export can be turned on and off when set
+  void setSharedMemoryPublisher(SharedMemoryPublisher *sharedPublisher) {
+    publisher = sharedPublisher;
+  }
+
+  // Quality level and target are shown and edited when set
+  void setQualityGovernor(QualityGovernor *qualityGovernor) {
+    governor = qualityGovernor;
+  }
+
 private:
   VisualizerConfig &config; // Reference to the shared configuration
   ShaderConfig &shaderConfig; // Reference to shader configuration
 
+  FrameScheduler *scheduler = nullptr;
+  QualityGovernor *governor = nullptr;
+  SessionRecorder *recorder = nullptr;
+  VideoRecorder *videoRecorder = nullptr;
+  SharedMemoryPublisher *publisher = nullptr;
+
+  // Stages shown in the timing plot, and scratch for their samples
+  std::array<bool, perf::TIMER_COUNT> plottedTimers{};
+  std::vector<float> timingSamples;
+
   int selectedWaveformIndex = 0; // Currently selected waveform in UI
   
   // Preset management
+  PresetLibrary presetLibrary;
+  std::uint64_t presetListVersion = 0;
+  std::string activePresetFile;  // Re-applied live when its file changes
+  std::string suppressReloadOf;  // Our own save; don't re-apply it
   std::vector<std::string> availablePresets;
   int selectedPresetIndex = -1;
   char presetNameBuffer[256] = "MyPreset";
   bool showSaveDialog = false;
   bool showLoadDialog = false;
+  float presetCrossfadeTime = 0.0f; // Seconds; 0 swaps on the next frame
   
   // Helper methods for drawing sections within the single window
-  void drawPerformanceSection(float fps, float frameTime);
+  void drawPerformanceSection(float fps, float frameTime,
+                              AudioVisualizer *visualizer);
+  void drawTimingSection(AudioVisualizer *visualizer);
+  void drawSchedulerSection();
+  void drawThreadSection();
+  void drawQualitySection(AudioVisualizer *visualizer);
   void drawShaderEffectsSection();
+  void drawSpectrumBarsSection();
+  void drawBeatSection(AudioVisualizer *visualizer);
   void drawWaveformListSection(AudioVisualizer *visualizer);
   void drawWaveformSettingsSection(AudioVisualizer *visualizer);
+  void drawModulationSection(AudioVisualizer *visualizer);
   void drawPresetManagerSection(AudioVisualizer *visualizer);
   
   // Preset operations
+  void syncPresetLibrary(AudioVisualizer *visualizer);
   void refreshPresetList();
   void saveCurrentPreset(AudioVisualizer *visualizer, const std::string& name);
   void loadPreset(AudioVisualizer *visualizer, const std::string& filename);
@@ -0,0 +1,106 @@
+#ifndef VIDEO_RECORDER_H
+#define VIDEO_RECORDER_H
+
+#include "SpscRingBuffer.h"
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records the visualizer's output to a Y4M file. Each captured frame is
+// read back into one of a ring of pixel buffer objects and fenced; the
+// pixels are only mapped once the fence has passed, frames later, so the
+// render thread never waits on the GPU. Mapped frames go to a writer
+// thread that converts and writes them. If every buffer is still in
+// flight, or the writer has fallen behind, the frame is dropped instead.
+// A texture resized mid-recording, as adaptive quality does to the trail,
+// is scaled back to the recorded size on the GPU before readback.
+class VideoRecorder {
+public:
+  VideoRecorder();
+  ~VideoRecorder();
+
+  VideoRecorder(const VideoRecorder &) = delete;
+  VideoRecorder &operator=(const VideoRecorder &) = delete;
+
+  // Needs an active context the first time
+  static bool isAvailable();
+
+  // Begin recording frames of the given size at framesPerSecond. Frames
+  // are taken at that rate; gaps left by dropped frames repeat the
+  // previous frame so the video keeps real time.
+  bool start(const std::string &path, sf::Vector2u size,
+             unsigned int framesPerSecond);
+  void stop();
+  bool isRecording() const { return recording; }
+
+  // Render thread, after the texture is displayed
+  void capture(sf::RenderTexture &texture);
+
+  const std::string &getPath() const { return path; }
+  std::uint64_t getFramesWritten() const { return framesWritten.load(); }
+  std::uint64_t getFramesRepeated() const { return framesRepeated.load(); }
+  std::uint64_t getFramesDropped() const { return framesDropped; }
+  float getReadbackMs() const { return readbackMs; } // Mean, issue to map
+
+private:
+  struct Frame {
+    std::vector<std::uint8_t> pixels; // RGBA, bottom row first
+    std::int64_t index = 0;           // Position in the video
+  };
+
+  // One asynchronous readback
+  struct Transfer {
+    unsigned int buffer = 0;
+    void *fence = nullptr;
+    std::int64_t index = 0;
+    std::chrono::steady_clock::time_point issued;
+  };
+
+  bool collect(Transfer &transfer, bool wait);
+  bool scaleToRecordedSize(const sf::RenderTexture &texture);
+  void releaseTransfers();
+  void writeLoop();
+  void writeFrame(const Frame &frame);
+
+  static constexpr size_t TRANSFER_COUNT = 3;
+  static constexpr size_t FRAME_COUNT = 4;
+
+  std::array<Transfer, TRANSFER_COUNT> transfers;
+  size_t nextTransfer = 0;   // Next to issue
+  size_t oldestTransfer = 0; // Next to collect
+  size_t inFlight = 0;
+
+  // Frames travel render thread -> writer through full and back through
+  // empty, so neither side allocates or locks
+  std::vector<Frame> frames;
+  SpscRingBuffer<Frame *> full{FRAME_COUNT};
+  SpscRingBuffer<Frame *> empty{FRAME_COUNT};
+
+  std::string path;
+  std::FILE *file = nullptr;
+  sf::Vector2u size;
+  sf::RenderTexture scaled; // Resized frames, at the recorded size
+  std::vector<std::uint8_t> planes; // Writer's Y, Cb and Cr planes
+
+  bool recording = false;
+  std::atomic<bool> writing{false};
+  std::thread writer;
+
+  std::chrono::steady_clock::time_point origin;
+  std::chrono::steady_clock::duration period{};
+  std::int64_t nextIndex = 0;
+
+  std::int64_t writtenIndex = -1; // Writer only
+  std::atomic<std::uint64_t> framesWritten{0};
+  std::atomic<std::uint64_t> framesRepeated{0};
+  std::uint64_t framesDropped = 0;
+  float readbackMs = 0.0f;
+};
+
+#endif // VIDEO_RECORDER_H
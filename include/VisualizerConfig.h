@@ -1,6 +1,7 @@
 #ifndef VISUALIZER_CONFIG_H
 #define VISUALIZER_CONFIG_H
 
+#include "JsonReader.h"
 #include <string>
 #include <sstream>
 
@@ -16,25 +17,41 @@ struct VisualizerConfig {
   // Global animation settings
   float hue = 0.0f;     // Current hue value (updated by visualizer)
   float hueRotationSpeed = 0.5f; // Speed of hue rotation
+  float beatPulse = 0.0f; // Radius kick on each tracked beat (0 = off)
+
+  // Spectrum bars
+  bool bars = false;         // Draw log-frequency bars around the circle
+  int barCount = 64;         // Number of bands
+  float barHeight = 200.0f;  // Length of a full-scale bar
+  float barRadiusFactor = 0.6f; // Inner radius of the bars
+  float barAttack = 0.01f;   // Band rise time constant (seconds)
+  float barRelease = 0.25f;  // Band fall time constant (seconds)
   
   // Serialization methods
   std::string toJSON(int indent = 0) const {
     std::string indentStr(indent, ' ');
     std::ostringstream oss;
     oss << indentStr << "{\n";
-    oss << indentStr << "  \"smoothness\": " << smoothness << ",\n";
-    oss << indentStr << "  \"rotationSpeed\": " << rotationSpeed << ",\n";
-    oss << indentStr << "  \"waveformHeight\": " << waveformHeight << ",\n";
-    oss << indentStr << "  \"radiusFactor\": " << radiusFactor << ",\n";
-    oss << indentStr << "  \"thickness\": " << thickness << ",\n";
-    oss << indentStr << "  \"hueOffset\": " << hueOffset << ",\n";
-    oss << indentStr << "  \"hue\": " << hue << ",\n";
-    oss << indentStr << "  \"hueRotationSpeed\": " << hueRotationSpeed << "\n";
+    oss << indentStr << "  \"smoothness\": " << json::number(smoothness) << ",\n";
+    oss << indentStr << "  \"rotationSpeed\": " << json::number(rotationSpeed) << ",\n";
+    oss << indentStr << "  \"waveformHeight\": " << json::number(waveformHeight) << ",\n";
+    oss << indentStr << "  \"radiusFactor\": " << json::number(radiusFactor) << ",\n";
+    oss << indentStr << "  \"thickness\": " << json::number(thickness) << ",\n";
+    oss << indentStr << "  \"hueOffset\": " << json::number(hueOffset) << ",\n";
+    oss << indentStr << "  \"hue\": " << json::number(hue) << ",\n";
+    oss << indentStr << "  \"hueRotationSpeed\": " << json::number(hueRotationSpeed) << ",\n";
+    oss << indentStr << "  \"beatPulse\": " << json::number(beatPulse) << ",\n";
+    oss << indentStr << "  \"bars\": " << (bars ? "true" : "false") << ",\n";
+    oss << indentStr << "  \"barCount\": " << barCount << ",\n";
+    oss << indentStr << "  \"barHeight\": " << json::number(barHeight) << ",\n";
+    oss << indentStr << "  \"barRadiusFactor\": " << json::number(barRadiusFactor) << ",\n";
+    oss << indentStr << "  \"barAttack\": " << json::number(barAttack) << ",\n";
+    oss << indentStr << "  \"barRelease\": " << json::number(barRelease) << "\n";
     oss << indentStr << "}";
     return oss.str();
   }
   
-  void fromJSON(const std::string& json);
+  bool fromJSON(json::Reader &reader);
 };
 
 #endif // VISUALIZER_CONFIG_H
@@ -2,39 +2,55 @@
 #define WAVEFORM_CONFIG_H
 
 #include <SFML/Graphics.hpp>
+#include "JsonReader.h"
 #include <string>
 #include <sstream>
 
+// Curve drawn between mirrored samples; stored in WaveformConfig as an int
+enum class Interpolation { None, Linear, Cubic, CatmullRom, Count };
+
 struct WaveformConfig {
     float displayHeight = 30.0f;
     int smoothness = 5;
+    int smoothingPasses = 1; // Box passes: 1 box, 2 triangle, 3+ near Gaussian
     float rotationSpeed = 1.0f;
     float radiusFactor = 0.3f;
     float thickness = 5.0f;
     float hueOffset = 0.5f;
     sf::Uint8 alpha = 255;
-    sf::Uint8 thickAlpha = 255;
+    sf::Uint8 thickAlpha = 255; // 0 skips the thick pass entirely
+    int interpolation = static_cast<int>(Interpolation::Cubic);
     bool enabled = true;
+
+    Interpolation getInterpolation() const {
+        if (interpolation < 0 ||
+            interpolation >= static_cast<int>(Interpolation::Count)) {
+            return Interpolation::Cubic;
+        }
+        return static_cast<Interpolation>(interpolation);
+    }
     
     // Serialization methods
     std::string toJSON(int indent = 0) const {
     std::string indentStr(indent, ' ');
   std::ostringstream oss;
         oss << indentStr << "{\n";
-        oss << indentStr << "  \"displayHeight\": " << displayHeight << ",\n";
-        oss << indentStr << "  \"smoothness\": " << smoothness << ",\n";
-        oss << indentStr << "  \"rotationSpeed\": " << rotationSpeed << ",\n";
-        oss << indentStr << "  \"radiusFactor\": " << radiusFactor << ",\n";
-        oss << indentStr << "  \"thickness\": " << thickness << ",\n";
-        oss << indentStr << "  \"hueOffset\": " << hueOffset << ",\n";
+        oss << indentStr << "  \"displayHeight\": " << json::number(displayHeight) << ",\n";
+        oss << indentStr << "  \"smoothness\": " << json::number(smoothness) << ",\n";
+        oss << indentStr << "  \"smoothingPasses\": " << smoothingPasses << ",\n";
+        oss << indentStr << "  \"rotationSpeed\": " << json::number(rotationSpeed) << ",\n";
+        oss << indentStr << "  \"radiusFactor\": " << json::number(radiusFactor) << ",\n";
+        oss << indentStr << "  \"thickness\": " << json::number(thickness) << ",\n";
+        oss << indentStr << "  \"hueOffset\": " << json::number(hueOffset) << ",\n";
         oss << indentStr << "  \"alpha\": " << static_cast<int>(alpha) << ",\n";
 oss << indentStr << "  \"thickAlpha\": " << static_cast<int>(thickAlpha) << ",\n";
+        oss << indentStr << "  \"interpolation\": " << interpolation << ",\n";
         oss << indentStr << "  \"enabled\": " << (enabled ? "true" : "false") << "\n";
         oss << indentStr << "}";
         return oss.str();
     }
     
-    void fromJSON(const std::string& json);
+    bool fromJSON(json::Reader &reader);
 };
 
 #endif // WAVEFORM_CONFIG_H
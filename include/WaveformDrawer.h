@@ -2,6 +2,7 @@
 #define WAVEFORM_DRAWER_H
 
 #include "AudioUtils.h"
+#include "WaveformConfig.h"
 #include <algorithm>
 #include <cmath>
 #include <SFML/Graphics.hpp>
@@ -59,237 +60,46 @@ inline sf::Color hsvToRgb(float hue, float saturation, float value) {
   }
 }
 
-// Cubic interpolation function
-inline double cubicInterpolate(double y0, double y1, double y2, double y3,
-                               double mu) {
-  double mu2 = mu * mu;
-  double a0 = y3 - y2 - y0 + y1;
-  double a1 = y0 - y1 - a0;
-  double a2 = y2 - y0;
-  double a3 = y1;
+// Interpolated points drawn per extended-buffer sample at full quality
+constexpr int WAVEFORM_POINT_MULTIPLIER = 10;
 
-  return (a0 * mu * mu2 + a1 * mu2 + a2 * mu + a3);
-}
-
-// Function to draw the waveform
-inline void
-drawWaveform(const std::vector<double> &buffer, sf::VertexArray &waveform,
-             sf::VertexArray &thickWaveform, float displayHeight,
-             int smoothness, float rotationAngle, float radiusFactor,
-             float width, float height, float hue, float thickness,
-             float thickWaveformHueOffset = 0.5f, sf::Uint8 waveformAlpha = 255,
-             sf::Uint8 thickWaveformAlpha = 255) {
-  if (buffer.empty()) {
-    return;
-  }
-
-  // Use static vectors to avoid repeated allocations
-  static std::vector<double> extendedBuffer;
-  static std::vector<double> smoothedAudioBuffer;
-  static std::vector<float> cosCache;
-  static std::vector<float> sinCache;
-
-  // Reserve capacity to avoid reallocations
-  const size_t requiredSize = buffer.size() * 2;
-  if (extendedBuffer.capacity() < requiredSize) {
-    extendedBuffer.reserve(requiredSize *
-                           1.5); // Reserve extra to reduce future reallocations
-  }
-
-  extendedBuffer.resize(requiredSize);
-  std::copy(buffer.begin(), buffer.end(), extendedBuffer.begin());
-  std::copy(buffer.rbegin(), buffer.rend(),
-            extendedBuffer.begin() + buffer.size());
-
-  // Ensure continuity at the join point to avoid artifacts
-  if (!buffer.empty()) {
-    // Set the join point to the average of the two ends
-    double avg = 0.5 * (buffer.front() + buffer.back());
-    extendedBuffer[buffer.size() - 1] = avg;
-    extendedBuffer[buffer.size()] = avg;
-  }
-
-  const int pointMultiplier = 10;
-  const size_t numPoints = extendedBuffer.size() * pointMultiplier;
-  waveform.resize(numPoints);
-
-  // Pre-calculate exact thick waveform vertex count
-  const size_t thicknessSteps = static_cast<size_t>((thickness + 1.0f) / 0.5f);
-  const size_t totalThickVertices = numPoints * thicknessSteps;
-  thickWaveform.resize(totalThickVertices);
-
-  float centerX = width / 2.0f;
-  float centerY = height / 2.0f;
-  float radius = std::min(centerX, centerY) * radiusFactor;
-
-  // Smooth the audio data - reuses existing allocation
-  smoothAudioData(extendedBuffer, smoothedAudioBuffer, smoothness);
-
-  // Pre-compute values
-  float hueOffset = -rotationAngle / (2.0f * static_cast<float>(M_PI));
-  // Normalize thickHue to [0, 1] range
-  float thickHue = hue + thickWaveformHueOffset;
-  thickHue = thickHue - std::floor(thickHue);
-  if (thickHue < 0.0f)
-    thickHue += 1.0f;
-
-  // Cache size calculations to avoid repeating them
-  const size_t extSize = extendedBuffer.size();
-  const size_t smoothSize = smoothedAudioBuffer.size();
-
-  // Pre-compute sin/cos for all angles to avoid redundant calculations
-  cosCache.resize(numPoints);
-  sinCache.resize(numPoints);
-  for (size_t i = 0; i < numPoints; ++i) {
-    float angle = static_cast<float>(i) / static_cast<float>(numPoints) * 2.0f *
-                      static_cast<float>(M_PI) +
-                  rotationAngle;
-    cosCache[i] = std::cos(angle);
-    sinCache[i] = std::sin(angle);
-  }
-
-  // Draw normal waveform using cached trig values
-  for (size_t i = 0; i < numPoints; ++i) {
-    float cosAngle = cosCache[i];
-    float sinAngle = sinCache[i];
-
-    size_t index = (i / pointMultiplier) % extSize;
-    float fraction = static_cast<float>(i % pointMultiplier) /
-                     static_cast<float>(pointMultiplier);
-
-    // Optimized wraparound using conditionals instead of modulo
-    size_t idx0, idx1, idx2, idx3;
-
-    // idx0 = index - 2 with wraparound
-    if (index >= 2) {
-      idx0 = index - 2;
-    } else {
-      idx0 = index + extSize - 2;
-    }
-
-    // idx1 = index - 1 with wraparound
-    if (index >= 1) {
-      idx1 = index - 1;
-    } else {
-      idx1 = index + extSize - 1;
-    }
-
-    // idx2 = index + 1 with wraparound
-    idx2 = index + 1;
-    if (idx2 >= extSize) {
-      idx2 -= extSize;
-    }
+// Radial spacing of the thick pass lines at full quality, in pixels
+constexpr float WAVEFORM_THICK_STEP = 0.5f;
 
-    // idx3 = index + 2 with wraparound
-    idx3 = index + 2;
-    if (idx3 >= extSize) {
-      idx3 -= extSize;
-    }
-
-    float sampleValue = static_cast<float>(
-        cubicInterpolate(extendedBuffer[idx0], extendedBuffer[idx1],
-                         extendedBuffer[idx2], extendedBuffer[idx3], fraction));
-
-    float r = radius + sampleValue * displayHeight;
-    float x = centerX + r * cosAngle;
-    float y = centerY + r * sinAngle;
-
-    // Normalize hue value to [0, 1] range
-    float normalizedHue =
-        hue + hueOffset + static_cast<float>(i) / static_cast<float>(numPoints);
-    normalizedHue = normalizedHue - std::floor(normalizedHue);
-    if (normalizedHue < 0.0f)
-      normalizedHue += 1.0f;
-
-    sf::Color color = hsvToRgb(normalizedHue, 1.0f, 0.7f);
-    color.a = waveformAlpha;
-    waveform[i].position = sf::Vector2f(x, y);
-    waveform[i].color = color;
-  }
-
-  // Prevent vertical line artifact by not connecting last to first if
-  // discontinuous
-  if (waveform.getVertexCount() > 1) {
-    sf::Vector2f first = waveform[0].position;
-    sf::Vector2f last = waveform[waveform.getVertexCount() - 1].position;
-    float dist = std::hypot(first.x - last.x, first.y - last.y);
-    float threshold = radius * 0.5f; // Heuristic: half the radius
-    if (dist > threshold) {
-      // Overwrite last vertex to match first, breaking the line
-      waveform[waveform.getVertexCount() - 1].position = first;
-    }
-  }
-
-  // Process thick waveform using cached trig values
-  size_t thickVertexIndex = 0;
-  for (size_t i = 0; i < numPoints; ++i) {
-    float cosAngle = cosCache[i];
-    float sinAngle = sinCache[i];
-
-    size_t index = (i / pointMultiplier) % smoothSize;
-    float fraction = static_cast<float>(i % pointMultiplier) /
-                     static_cast<float>(pointMultiplier);
-
-    // Optimized wraparound using conditionals instead of modulo
-    size_t idx0, idx1, idx2, idx3;
-
-    // idx0 = index - 2 with wraparound
-    if (index >= 2) {
-      idx0 = index - 2;
-    } else {
-      idx0 = index + smoothSize - 2;
-    }
-
-    // idx1 = index - 1 with wraparound
-    if (index >= 1) {
-      idx1 = index - 1;
-    } else {
-      idx1 = index + smoothSize - 1;
-    }
-
-    // idx2 = index + 1 with wraparound
-    idx2 = index + 1;
-    if (idx2 >= smoothSize) {
-      idx2 -= smoothSize;
-    }
-
-    // idx3 = index + 2 with wraparound
-    idx3 = index + 2;
-    if (idx3 >= smoothSize) {
-      idx3 -= smoothSize;
-    }
-
-    float sampleValue = static_cast<float>(cubicInterpolate(
-        smoothedAudioBuffer[idx0], smoothedAudioBuffer[idx1],
-        smoothedAudioBuffer[idx2], smoothedAudioBuffer[idx3], fraction));
-
-    float r = radius + sampleValue * displayHeight;
-
-    // Normalize hue value to [0, 1] range
-    float normalizedThickHue =
-        thickHue + hueOffset +
-        static_cast<float>(i) / static_cast<float>(numPoints);
-    normalizedThickHue = normalizedThickHue - std::floor(normalizedThickHue);
-    if (normalizedThickHue < 0.0f)
-      normalizedThickHue += 1.0f;
-
-    sf::Color color = hsvToRgb(normalizedThickHue, 1.0f, 1.0f);
-    color.a = thickWaveformAlpha;
-
-    // Use index-based access instead of append - CRITICAL OPTIMIZATION
-    for (float offset = -thickness / 2.0f; offset <= thickness / 2.0f;
-         offset += 0.5f) {
-      float offsetRadius = r + offset;
-      sf::Vector2f thickPoint(centerX + offsetRadius * cosAngle,
-                              centerY + offsetRadius * sinAngle);
-      thickWaveform[thickVertexIndex].position = thickPoint;
-      thickWaveform[thickVertexIndex].color = color;
-      ++thickVertexIndex;
-    }
-  }
+// Vertices drawWaveform writes to the normal pass for a given length of the
+// mirrored buffer (see mirrorAudioBuffer)
+inline size_t waveformPointCount(size_t mirroredSize,
+                                 int pointMultiplier = WAVEFORM_POINT_MULTIPLIER) {
+  return mirroredSize * static_cast<size_t>(std::max(pointMultiplier, 1));
+}
 
-  // Resize to actual vertex count to remove any uninitialized vertices
-  thickWaveform.resize(thickVertexIndex);
+// Radial steps (thickStep px apart) drawn per point by the thick pass
+inline size_t thickStepCount(float thickness,
+                             float thickStep = WAVEFORM_THICK_STEP) {
+  return static_cast<size_t>(std::max(thickness, 0.0f) /
+                             std::max(thickStep, 0.1f)) +
+         1;
 }
 
+// Function to draw the waveform from the mirrored audio buffer and its
+// smoothed copy (both shared per frame through SmoothingCache). The caller
+// provides storage for exactly waveformPointCount() normal vertices and
+// waveformPointCount() * thickStepCount() thick vertices (for the same
+// pointMultiplier and thickStep), so many waveforms
+// can share one contiguous array; a LineStrip over each range draws one pass.
+// A null thickOut skips the thick pass. Each combination of interpolation,
+// thick pass and the quality ladder's point multipliers has its own
+// compiled kernel; other multipliers take a generic one.
+void drawWaveform(const std::vector<double> &extendedBuffer,
+                  const std::vector<double> &smoothedAudioBuffer,
+                  sf::Vertex *normalOut, sf::Vertex *thickOut,
+                  float displayHeight, float rotationAngle, float radiusFactor,
+                  float width, float height, float hue, float thickness,
+                  float thickWaveformHueOffset = 0.5f,
+                  sf::Uint8 waveformAlpha = 255,
+                  sf::Uint8 thickWaveformAlpha = 255,
+                  int pointMultiplier = WAVEFORM_POINT_MULTIPLIER,
+                  float thickStep = WAVEFORM_THICK_STEP,
+                  Interpolation interpolation = Interpolation::Cubic);
+
 #endif // WAVEFORM_DRAWER_H
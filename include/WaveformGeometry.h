@@ -0,0 +1,85 @@
+#ifndef WAVEFORM_GEOMETRY_H
+#define WAVEFORM_GEOMETRY_H
+
+#include "RenderQuality.h"
+#include "SmoothingCache.h"
+#include "WaveformConfig.h"
+#include <SFML/Graphics.hpp>
+#include <utility>
+#include <vector>
+
+// CPU construction of a scene's waveform geometry, shared by WaveformStore
+// and the GeometryProducer thread, and the inputs of the GPU path that
+// builds it in waveform.vert instead. Only touches its arguments.
+
+// Transparent vertices joining one pass's LineStrip to the next
+constexpr size_t BRIDGE_VERTICES = 2;
+
+// Where one waveform's vertices live in the store's shared vertex array
+struct GeometryRange {
+  size_t normalOffset = 0;
+  size_t normalCount = 0;
+  size_t thickOffset = 0;
+  size_t thickCount = 0;
+};
+
+// Lay out every enabled waveform as [normal][bridge][thick][bridge], or
+// [normal][bridge] when its thick pass is transparent, and return the total
+// vertex count
+size_t layoutGeometry(const std::vector<WaveformConfig> &configs,
+                      size_t pointCount, float thickStep,
+                      std::vector<GeometryRange> &ranges);
+
+// Join each pass to the next with transparent bridge vertices
+void writeBridges(const std::vector<GeometryRange> &ranges,
+                  std::vector<sf::Vertex> &vertices);
+
+// Fill vertices (already sized to the layout's total) with every enabled
+// waveform's normal and thick passes and the bridges between them
+void buildCpuGeometry(const std::vector<WaveformConfig> &configs,
+                      const std::vector<float> &rotationAngles,
+                      const std::vector<GeometryRange> &ranges,
+                      SmoothingCache &samples, float globalHue, float width,
+                      float height, float opacity, float radiusScale,
+                      const RenderQuality &quality,
+                      std::vector<sf::Vertex> &vertices);
+
+// Everything waveform.vert reads besides the index vertices, packed on the
+// CPU each frame as RGBA8 texels, which is all SFML textures hold. Samples
+// are 16-bit fixed point in red and green: row 0 raw, then one smoothed row
+// per distinct smoothing setting. Each waveform's parameters fill one row
+// of the waveform texture as 24-bit fixed point in RGB, with its smoothed
+// row, interpolation and last thick pass step in the alpha bytes.
+struct GpuGeometryFrame {
+  std::vector<sf::Uint8> samplePixels;
+  sf::Vector2u sampleSize;
+  std::vector<sf::Uint8> waveformPixels;
+  sf::Vector2u waveformSize;
+  std::vector<std::pair<int, int>> rowSmoothing; // Radius, passes per row
+  size_t pointCount = 0;
+  float pointMultiplier = 1.0f;
+  float thickStep = 0.5f;
+  float hue = 0.0f;
+  sf::Vector2f center;
+};
+
+// Index vertices for waveform.vert of every waveform from first on, and
+// every bridge. Vertices before the first waveform are left as they are.
+void writeGpuIndexVertices(const std::vector<GeometryRange> &ranges,
+                           size_t first, std::vector<sf::Vertex> &vertices);
+
+// Pack this frame's samples and waveform parameters for waveform.vert
+void packGpuGeometry(const std::vector<WaveformConfig> &configs,
+                     const std::vector<float> &rotationAngles,
+                     const std::vector<GeometryRange> &ranges,
+                     SmoothingCache &samples, float globalHue, float width,
+                     float height, float opacity, float radiusScale,
+                     const RenderQuality &quality, GpuGeometryFrame &frame);
+
+// Point waveform.vert at a frame whose pixels have been uploaded to the
+// two textures. The textures may be larger than the frame.
+void setGpuGeometryUniforms(sf::Shader &shader, const GpuGeometryFrame &frame,
+                            const sf::Texture &sampleTexture,
+                            const sf::Texture &waveformTexture);
+
+#endif // WAVEFORM_GEOMETRY_H
@@ -0,0 +1,159 @@
+#ifndef WAVEFORM_STORE_H
+#define WAVEFORM_STORE_H
+
+#include "GeometryProducer.h"
+#include "WaveformConfig.h"
+#include "WaveformGeometry.h"
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class ModulationMatrix;
+class SmoothingCache;
+
+// Stable reference to a waveform in a WaveformStore. Remains valid while
+// other waveforms are added or removed, and a removed waveform's handle
+// never resolves to a waveform added later.
+struct WaveformHandle {
+  static constexpr std::uint32_t INVALID = 0xFFFFFFFFu;
+
+  std::uint32_t slot = INVALID;
+  std::uint32_t generation = 0;
+
+  bool operator==(const WaveformHandle &other) const {
+    return slot == other.slot && generation == other.generation;
+  }
+  bool operator!=(const WaveformHandle &other) const {
+    return !(*this == other);
+  }
+};
+
+// Data-oriented storage for all waveforms of a scene. Per-waveform state is
+// kept in parallel dense arrays (index i of each belongs to the same
+// waveform, in draw order) and all geometry is packed into one contiguous
+// vertex array, so update and render are linear sweeps without per-object
+// allocations. Handles map through a slot table to the dense index.
+//
+// The vertex array is a single LineStrip: each waveform's normal and thick
+// passes are joined to their neighbours by pairs of fully transparent
+// bridge vertices, so the whole scene is drawn with one call from a
+// streaming GPU vertex buffer that is re-uploaded only after update().
+//
+// With a geometry shader set, the vertices only hold indices and stay
+// unchanged while the layout does; each frame uploads just the mirrored
+// samples and one row of parameters per waveform as two small textures,
+// and waveform.vert computes positions and colours. Without one, geometry is built on the CPU by drawWaveform(),
+// by default on a GeometryProducer thread while the previous frame draws.
+class WaveformStore {
+public:
+  WaveformHandle add(const WaveformConfig &config);
+  void remove(WaveformHandle handle);
+  void clear();
+
+  size_t size() const { return configs.size(); }
+  bool empty() const { return configs.empty(); }
+
+  // Dense access in draw order
+  WaveformConfig &getConfig(size_t index) { return configs[index]; }
+  const WaveformConfig &getConfig(size_t index) const { return configs[index]; }
+  WaveformHandle getHandle(size_t index) const;
+
+  // Dense index of a live handle, or size() if it is stale
+  size_t indexOf(WaveformHandle handle) const;
+
+  // Advance rotation and regenerate geometry for every enabled waveform
+  // from the frame's shared samples. Opacity scales both alphas and is used
+  // to crossfade between scenes; radiusScale multiplies every radius.
+  void update(SmoothingCache &samples, float globalHue,
+              float deltaTime, float width, float height,
+              float opacity = 1.0f, float radiusScale = 1.0f);
+
+  // Draw every enabled waveform's normal and thick passes. Uploads geometry
+  // first if update() changed it since the last render.
+  void render(sf::RenderTarget &target);
+
+  // Build geometry on the GPU with the waveform.vert shader, or on the CPU
+  // if null. Takes effect at the next update().
+  void setGeometryShader(sf::Shader *shader) { geometryShader = shader; }
+
+  // Build CPU geometry on a producer thread, one frame behind update(), or
+  // inline. Takes effect at the next update().
+  void setGeometryPipelined(bool enabled) { pipelineEnabled = enabled; }
+
+  // Offsets from an evaluated matrix are applied to copies of the configs
+  // for each frame, or none if null. Takes effect at the next update().
+  void setModulation(const ModulationMatrix *matrix) { modulation = matrix; }
+
+  // Point density and thick pass spacing. Takes effect at the next update().
+  void setQuality(const RenderQuality &renderQuality) {
+    quality = renderQuality;
+  }
+
+private:
+  // Dense arrays, one element per live waveform
+  std::vector<WaveformConfig> configs;
+  std::vector<float> rotationAngles;
+  std::vector<GeometryRange> ranges;
+  std::vector<std::uint32_t> denseToSlot;
+
+  // Slot table indexed by handle slot
+  std::vector<std::uint32_t> slotToDense;
+  std::vector<std::uint32_t> slotGenerations;
+  std::vector<std::uint32_t> freeSlots;
+
+  // Configs this frame is built from: modulated copies, or the stored ones
+  const ModulationMatrix *modulation = nullptr;
+  std::vector<WaveformConfig> modulatedConfigs;
+  bool modulating = false;
+  const std::vector<WaveformConfig> &frameConfigs() const {
+    return modulating ? modulatedConfigs : configs;
+  }
+
+  // What the GPU path lays out while modulating: room for the thickest
+  // pass the routes can reach, so its index vertices stay put while the
+  // shader draws each frame's thickness
+  std::vector<WaveformConfig> layoutConfigs;
+
+  void buildInlineGeometry(SmoothingCache &samples, size_t total,
+                           float globalHue, float width, float height,
+                           float opacity, float radiusScale);
+  void submitGeometry(SmoothingCache &samples, size_t total, float globalHue,
+                      float width, float height, float opacity,
+                      float radiusScale);
+  void buildGpuGeometry(SmoothingCache &samples, size_t total,
+                        float globalHue, float width, float height,
+                        float opacity, float radiusScale);
+  void uploadGeometry(const std::vector<sf::Vertex> &source);
+  bool renderProduced(sf::RenderTarget &target); // False before any frame
+
+  // Geometry of all waveforms, packed back to back in draw order
+  std::vector<sf::Vertex> vertices;
+
+  // GPU copy of vertices, created lazily on the render thread. Held by
+  // pointer so moving a store never copies GPU memory.
+  std::unique_ptr<sf::VertexBuffer> vertexBuffer;
+  size_t dirtyBegin = 0; // Vertex range changed since the last upload
+  size_t dirtyEnd = 0;
+
+  RenderQuality quality;
+
+  // Pipelined CPU geometry. The producer is started on first use and its
+  // latest finished frame is drawn instead of vertices.
+  bool pipelineEnabled = true;
+  bool pipelined = false;
+  GeometryProducerSlot producer; // Never joined on the render thread
+  GeometryJob job;
+  bool bufferHoldsProduced = false; // vertexBuffer has the producer's frame
+
+  // GPU geometry state. builtRanges is the layout the index vertices were
+  // written for; they are rewritten only when it changes.
+  sf::Shader *geometryShader = nullptr;
+  bool gpuGeometry = false;
+  std::vector<GeometryRange> builtRanges;
+  GpuGeometryFrame gpuFrame;
+  std::unique_ptr<sf::Texture> sampleTexture;
+  std::unique_ptr<sf::Texture> waveformTexture;
+};
+
+#endif // WAVEFORM_STORE_H
@@ -1,4 +1,6 @@
 #include "AudioCapture.h"
+#include "AudioUtils.h"
+#include <chrono>
 #include <iostream>
 #include <numeric> // Include this header for std::accumulate
 
@@ -103,7 +105,9 @@ bool AudioCapture::initialize() {
   return true;
 }
 
-bool AudioCapture::captureAudio(std::vector<double> &audioBuffer) {
+bool AudioCapture::captureAudio(std::vector<float> &monoFrames) {
+  monoFrames.clear();
+
   UINT32 packetLength = 0;
   hr = pCaptureClient->GetNextPacketSize(&packetLength);
   if (FAILED(hr)) {
@@ -116,29 +120,47 @@ bool AudioCapture::captureAudio(std::vector<double> &audioBuffer) {
     BYTE *pData = nullptr;
     UINT32 numFramesAvailable = 0;
     DWORD flags = 0;
+    UINT64 qpcPosition = 0;
 
     hr = pCaptureClient->GetBuffer(&pData, &numFramesAvailable, &flags, nullptr,
- nullptr);
+ &qpcPosition);
     if (FAILED(hr)) {
       std::cerr << "Failed to get buffer. Error: " << std::hex << hr
            << std::endl;
       return false;
     }
 
-    // Ensure buffer is large enough once
-    if (audioBuffer.size() < numFramesAvailable) {
-      audioBuffer.resize(numFramesAvailable, 0.0);
+    // Append after earlier packets; the data is interleaved by channel
+    size_t start = monoFrames.size();
+    monoFrames.resize(start + numFramesAvailable, 0.0f);
+    if (!(flags & AUDCLNT_BUFFERFLAGS_SILENT)) {
+      downmixToMono(reinterpret_cast<const float *>(pData),
+                    numFramesAvailable, pwfx->nChannels,
+                    monoFrames.data() + start);
     }
 
-    if (flags & AUDCLNT_BUFFERFLAGS_SILENT) {
-      std::fill(audioBuffer.begin(), audioBuffer.begin() + numFramesAvailable,
-     0.0);
-      // Optionally log silence only in debug mode
-    } else {
- const float *floatData = reinterpret_cast<const float *>(pData);
-      for (UINT32 i = 0; i < numFramesAvailable; ++i) {
-        audioBuffer[i] = static_cast<double>(floatData[i]);
+    if (packetCallback) {
+      AudioPacket packet;
+      packet.data = (flags & AUDCLNT_BUFFERFLAGS_SILENT)
+                        ? nullptr
+                        : reinterpret_cast<const float *>(pData);
+      packet.frames = numFramesAvailable;
+      packet.channels = pwfx->nChannels;
+      packet.sampleRate = pwfx->nSamplesPerSec;
+
+      // The QPC position is in 100 ns units, on the same counter as
+      // steady_clock; estimate from the packet length if it is missing
+      if (qpcPosition != 0 && !(flags & AUDCLNT_BUFFERFLAGS_TIMESTAMP_ERROR)) {
+        packet.captureTimeNs = static_cast<INT64>(qpcPosition) * 100;
+      } else {
+        INT64 now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count();
+        packet.captureTimeNs =
+            now - static_cast<INT64>(numFramesAvailable) * 1000000000 /
+                      pwfx->nSamplesPerSec;
       }
+      packetCallback(packet);
     }
 
   hr = pCaptureClient->ReleaseBuffer(numFramesAvailable);
@@ -0,0 +1,76 @@
+#include "AudioConditioner.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cmath>
+
+// Below one 24-bit step counts as digital silence
+static constexpr double SILENCE_THRESHOLD = 1.0 / (1 << 24);
+
+// Quiet input is not boosted beyond this, so noise stays noise
+static constexpr double MAX_GAIN = 64.0;
+
+// Copy count samples from input to output, returning the peak absolute value
+// and the sum of squares
+static void copyWithStats(const double *input, double *output, size_t count,
+                          double &peak, double &sumSquares) {
+  size_t i = 0;
+  double peakValue = 0.0;
+  double sum = 0.0;
+
+#ifdef HAS_SSE2
+  const __m128d signMask = _mm_set1_pd(-0.0);
+  __m128d peak2 = _mm_setzero_pd();
+  __m128d sum2 = _mm_setzero_pd();
+  for (; i + 2 <= count; i += 2) {
+    __m128d value = _mm_loadu_pd(input + i);
+    _mm_storeu_pd(output + i, value);
+    peak2 = _mm_max_pd(peak2, _mm_andnot_pd(signMask, value));
+    sum2 = _mm_add_pd(sum2, _mm_mul_pd(value, value));
+  }
+
+  double lanes[2];
+  _mm_storeu_pd(lanes, peak2);
+  peakValue = std::max(lanes[0], lanes[1]);
+  _mm_storeu_pd(lanes, sum2);
+  sum = lanes[0] + lanes[1];
+#endif
+
+  for (; i < count; ++i) {
+    double value = input[i];
+    output[i] = value;
+    peakValue = std::max(peakValue, std::abs(value));
+    sum += value * value;
+  }
+
+  peak = peakValue;
+  sumSquares = sum;
+}
+
+AudioConditioner::AudioConditioner(size_t frameSize) {
+  frame.samples.assign(frameSize, 0.0);
+}
+
+const AnalysisFrame &AudioConditioner::process(const std::vector<double> &input,
+                                               float deltaTime) {
+  const size_t frameSize = frame.samples.size();
+  const size_t count = std::min(input.size(), frameSize);
+
+  double sumSquares = 0.0;
+  copyWithStats(input.data(), frame.samples.data(), count, frame.peak,
+                sumSquares);
+  std::fill(frame.samples.begin() + count, frame.samples.end(), 0.0);
+
+  frame.rms = frameSize > 0 ? std::sqrt(sumSquares / frameSize) : 0.0;
+  frame.silent = frame.peak <= SILENCE_THRESHOLD;
+
+  // Hold the envelope through silence so playback resumes at the old level
+  if (!frame.silent) {
+    float time = frame.peak > envelope ? attackTime : releaseTime;
+    double coefficient =
+        time > 0.0f ? 1.0 - std::exp(-deltaTime / time) : 1.0;
+    envelope += (frame.peak - envelope) * coefficient;
+  }
+
+  frame.gain = envelope > 0.0 ? std::min(1.0 / envelope, MAX_GAIN) : 1.0;
+  return frame;
+}
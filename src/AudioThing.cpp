@@ -1,20 +1,33 @@
 #include "AudioCaptureRAII.h"
-#include "AudioUtils.h"
+#include "BeatAnalyzer.h"
 #include "AudioVisualizer.h"
+#include "ConditioningThread.h"
+#include "FrameScheduler.h"
 #include "ImGuiRAII.h"
+#include "PerfTimers.h"
+#include "QualityGovernor.h"
+#include "RealFft.h"
+#include "SessionPlayer.h"
+#include "SessionRecorder.h"
+#include "SharedMemoryPublisher.h"
 #include "ShaderConfig.h"
+#include "ThreadConfig.h"
+#include "Tracer.h"
 #include "UIManager.h"
+#include "VideoRecorder.h"
 #include "VisualizerConfig.h"
 #include <atomic>
 #include <chrono>
 #include <cmath>
 #include <complex>
 #include <fftw3.h>
+#include <future>
 #include <iostream>
 #include <mutex>
 #include <numeric>
 #include <SFML/Audio.hpp>
 #include <SFML/Graphics.hpp>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -22,9 +35,12 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+// Measured FFT plans, kept between runs
+static constexpr const char *FFT_WISDOM_FILE = "cache/fftw.wisdom";
+
 // Process all window events
 void processEvents(sf::RenderWindow &window, AudioVisualizer &visualizer,
-                   ImGuiRAII &imguiManager) {
+                   ImGuiRAII &imguiManager, sf::RenderTexture &uiTexture) {
   sf::Event event;
   while (window.pollEvent(event)) {
     imguiManager.processEvent(event);
@@ -39,134 +55,332 @@ void processEvents(sf::RenderWindow &window, AudioVisualizer &visualizer,
       sf::FloatRect visibleArea(0, 0, static_cast<float>(event.size.width),
                                 static_cast<float>(event.size.height));
       window.setView(sf::View(visibleArea));
+      uiTexture.create(event.size.width, event.size.height);
     }
   }
 }
 
-// Process audio data from capture thread to render thread
-void processAudioData(std::mutex &audioBufferMutex,
-                      std::condition_variable &audioBufferCV,
-                      std::vector<double> &audioBuffer,
-                      std::vector<double> &renderBuffer, bool &bufferReady) {
-  // Wait for new audio data
-  std::unique_lock<std::mutex> lock(audioBufferMutex);
-  if (!bufferReady) {
-    audioBufferCV.wait(lock, [&bufferReady] { return bufferReady; });
-  }
-
-  // Swap buffers and mark as processed
-  std::swap(renderBuffer, audioBuffer);
-  bufferReady = false;
-
-  // Process audio data
-  if (isAudioPlaying(renderBuffer)) {
-    trimTrailingZeros(renderBuffer);
-  }
-  normalizeAudioData(renderBuffer);
-}
-
-// Perform visualization update and rendering
-void updateAndRender(sf::RenderWindow &window, AudioVisualizer &visualizer,
-                     const std::vector<double> &renderBuffer, float deltaTime) {
-  // Clear the window
-  window.clear();
-
-  // Update and render the visualizer
-  visualizer.update(renderBuffer, deltaTime);
-  visualizer.render(window);
-}
-
-// Update and render UI
-void updateUI(UIManager &uiManager, ImGuiRAII &imguiManager, float deltaTime,
+// Update and render UI into its own texture, composited every frame
+void updateUI(UIManager &uiManager, ImGuiRAII &imguiManager,
+              sf::RenderTexture &uiTexture, float deltaTime, float fps,
               AudioVisualizer *visualizer = nullptr) {
   // Update ImGui
   imguiManager.update(deltaTime);
 
   // Draw UI with performance metrics
-  float fps = 1.0f / deltaTime;
-  float frameTime = deltaTime * 1000.0f;
+  float frameTime = fps > 0.0f ? 1000.0f / fps : 0.0f;
   uiManager.drawUI(fps, frameTime, visualizer);
 
   // Render ImGui
-  imguiManager.render();
+  uiTexture.clear(sf::Color::Transparent);
+  imguiManager.renderPremultiplied(uiTexture);
+  uiTexture.display();
+}
+
+static std::int64_t steadyNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Export the frame's analysis to other processes. Beat and onset counts
+// accumulate across calls.
+static void publishAnalysis(SharedMemoryPublisher &publisher,
+                            const AnalysisFrame &frame,
+                            const AudioVisualizer &visualizer,
+                            const BeatAnalyzer &beatAnalyzer,
+                            std::uint64_t beatCount,
+                            std::uint64_t onsetCount) {
+  SharedAnalysis analysis;
+  analysis.timeNs = steadyNowNs();
+  analysis.samples = frame.samples.data();
+  analysis.sampleCount = frame.samples.size();
+  analysis.sampleRate = VISUAL_SAMPLE_RATE;
+  analysis.peak = static_cast<float>(frame.peak);
+  analysis.rms = static_cast<float>(frame.rms);
+  analysis.gain = static_cast<float>(frame.gain);
+  analysis.silent = frame.silent;
+
+  const std::vector<float> &spectrum = visualizer.getSpectrum();
+  if (visualizer.getSpectrumFftSize() / 2 + 1 == spectrum.size()) {
+    analysis.spectrum = spectrum.data();
+    analysis.fftSize = visualizer.getSpectrumFftSize();
+  }
+  analysis.bands = visualizer.getBandLevels().data();
+  analysis.bandCount = visualizer.getBandLevels().size();
+
+  analysis.bpm = beatAnalyzer.getBpm();
+  analysis.beatConfidence = beatAnalyzer.getConfidence();
+  analysis.beatPhase = visualizer.getBeatPhase();
+  analysis.beatCount = beatCount;
+  analysis.onsetCount = onsetCount;
+  if (const BeatEvent *beat = visualizer.getLastBeat()) {
+    analysis.lastBeatNs = beat->timeNs;
+  }
+  publisher.publish(analysis);
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+  trace::setThreadName("Main");
+
+  // --replay <session> plays a recorded session instead of capturing;
+  // --share publishes analysis to shared memory from the start
+  std::string replayPath;
+  bool shareAnalysis = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string argument = argv[i];
+    if (argument == "--replay" && i + 1 < argc) {
+      replayPath = argv[++i];
+    } else if (argument == "--share") {
+      shareAnalysis = true;
+    } else {
+      std::cerr << "Unknown argument: " << argument << std::endl;
+      std::cerr << "Usage: AudioThing [--replay <session file>] [--share]"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
   try {
-    constexpr int BUFFER_SIZE = 1024;
+    const auto startupBegin = std::chrono::steady_clock::now();
+
+    // Plans measured by earlier runs; analysis falls back to estimated plans
+    // for any size planned before this finishes
+    std::future<bool> wisdomLoaded = std::async(
+        std::launch::async, [] { return loadFftWisdom(FFT_WISDOM_FILE); });
+
+    // Analysis window at the visual rate; capture resamples to it
+    const size_t windowSamples =
+        samplesForMs(ANALYSIS_WINDOW_MS, VISUAL_SAMPLE_RATE);
 
     // Resources managed with RAII patterns
-    std::vector<double> audioBuffer(BUFFER_SIZE);
-    std::vector<double> renderBuffer(BUFFER_SIZE);
+    std::vector<double> audioBuffer(windowSamples);
     std::mutex audioBufferMutex;
     std::condition_variable audioBufferCV;
     std::atomic<bool> capturingAudio(true);
     bool bufferReady = false;
 
+    // Level analysis of each window as capture hands it over, off the
+    // render thread
+    ConditioningThread conditioning(windowSamples, audioBuffer,
+                                    audioBufferMutex, audioBufferCV,
+                                    bufferReady);
+
+    // Onset and beat analysis on its own thread, fed every capture packet
+    BeatAnalyzer beatAnalyzer;
+
+    // Records what capture saw, and the configuration, when started from
+    // the UI; outlives the capture thread that feeds it
+    SessionRecorder recorder;
+    std::string recordedConfig;
+
+    std::unique_ptr<SessionPlayer> player;
+    SessionPlayer *replay = nullptr;
+    if (!replayPath.empty()) {
+      player = std::make_unique<SessionPlayer>(replayPath);
+      replay = player.get();
+    }
+
+    // Create audio capture with RAII (automatically starts capture thread).
+    // Nothing below needs audio, so the device opens while the window,
+    // shaders and UI are set up.
+    AudioCaptureRAII audioCaptureRAII(
+        static_cast<int>(windowSamples), audioBuffer, audioBufferMutex,
+        audioBufferCV, capturingAudio, bufferReady,
+        [&beatAnalyzer, &recorder](const capture::AudioPacket &packet) {
+          recorder.recordPacket(packet.data, packet.frames, packet.channels,
+                                packet.sampleRate, packet.captureTimeNs);
+          beatAnalyzer.pushPacket(packet.data, packet.frames, packet.channels,
+                                  packet.sampleRate, packet.captureTimeNs);
+        },
+        std::move(player));
+
+    // Create configuration objects and the UI manager, whose preset library
+    // indexes the preset directory on its own thread
+    VisualizerConfig config;
+    ShaderConfig shaderConfig;
+    UIManager uiManager(config, shaderConfig);
+    uiManager.setSessionRecorder(&recorder);
+
     // Set up SFML window with RAII (SFML already handles resources this way)
+    // The render stage is timed off vsync so display() waits only briefly,
+    // leaving the other stages their own rates
     sf::ContextSettings settings;
     settings.antialiasingLevel = 8;
     sf::RenderWindow window(sf::VideoMode(2560, 1440), "Audio Spectrum",
                             sf::Style::Default, settings);
-    window.setFramerateLimit(60);
     window.setVerticalSyncEnabled(true);
 
-    // Create configuration objects
-    VisualizerConfig config;
-    ShaderConfig shaderConfig;
+    // Show something while the rest of startup finishes
+    window.clear();
+    window.display();
+
+    // Shaders come from the binary cache when this driver has built them
+    // before
     AudioVisualizer visualizer(config, shaderConfig);
     if (!visualizer.initialize(1920, 1080)) {
       throw std::runtime_error("Failed to initialize visualizer");
     }
-
-    // Create UI manager
-    UIManager uiManager(config, shaderConfig);
+    visualizer.setBeatAnalyzer(&beatAnalyzer);
 
     // Initialize ImGui with RAII
     ImGuiRAII imguiManager(window);
+    sf::RenderTexture uiTexture;
+    if (!uiTexture.create(window.getSize().x, window.getSize().y)) {
+      throw std::runtime_error("Failed to create UI texture");
+    }
 
-    // Create audio capture with RAII (automatically starts capture thread)
-    AudioCaptureRAII audioCaptureRAII(BUFFER_SIZE, audioBuffer,
-                                      audioBufferMutex, audioBufferCV,
-                                      capturingAudio, bufferReady);
+    // Records the output from the render stage when started from the UI
+    VideoRecorder videoRecorder;
+    visualizer.setVideoRecorder(&videoRecorder);
+    uiManager.setVideoRecorder(&videoRecorder);
 
-    sf::Clock deltaClock;
-    float waveformUpdateInterval = 1.0f / 30.0f;
-    float waveformUpdateAccumulator = 0.0f;
+    // Analysis for other local processes, published by the geometry stage
+    // once per new analysis frame
+    SharedMemoryPublisher publisher;
+    if (shareAnalysis) {
+      publisher.open();
+    }
+    uiManager.setSharedMemoryPublisher(&publisher);
+    std::uint64_t publishedBeats = 0;
+    std::uint64_t publishedOnsets = 0;
 
-    // Main application loop
-    while (window.isOpen()) {
-      // Process window events
-      processEvents(window, visualizer, imguiManager);
+    // The render thread's stages each run at their own rate. Analysis
+    // arrives from the conditioning thread.
+    FrameScheduler scheduler;
+    bool hasAnalysis = false;
+    size_t renderStage = 0;
 
-      // Calculate frame time
-      float deltaTime = deltaClock.restart().asSeconds();
-      waveformUpdateAccumulator += deltaTime;
+    scheduler.addStage("Geometry", 60.0f, 4.0f, [&](float deltaTime) {
+      // Configuration changes from a replayed session, in recorded order.
+      // Edits apply in place; only a changed waveform count rebuilds.
+      if (replay) {
+        for (const std::string &json : replay->takeConfigChanges()) {
+          VisualizerPreset preset;
+          if (preset.fromJSON(json) &&
+              !visualizer.applyPresetInPlace(preset)) {
+            visualizer.applyPresetAsync(preset, 0.0f);
+          }
+        }
+      }
 
-      // Clear the window
-      window.clear();
+      // Apply any finished preset swap before anything reads the scene
+      visualizer.beginFrame(deltaTime);
 
-      // Update waveform at fixed interval
-      if (waveformUpdateAccumulator >= waveformUpdateInterval) {
-        // Process audio data
-        processAudioData(audioBufferMutex, audioBufferCV, audioBuffer,
-                         renderBuffer, bufferReady);
+      // Smoothing is rebuilt only for new audio; rotation and decay keep
+      // moving in between
+      const bool newAnalysis = conditioning.acquire();
+      if (newAnalysis) {
+        hasAnalysis = true;
+        visualizer.setAnalysisFrame(conditioning.frame());
+      }
+      if (!hasAnalysis) {
+        return;
+      }
+      visualizer.setSpectrumRequired(publisher.isOpen());
+      visualizer.update(deltaTime);
 
-        visualizer.update(renderBuffer, waveformUpdateAccumulator);
-        waveformUpdateAccumulator = 0.0f;
+      // Beats are counted on every frame, but the analysis is only
+      // published again once there is a new frame of it
+      if (publisher.isOpen()) {
+        for (const BeatEvent &event : visualizer.getBeatEvents()) {
+          ++(event.type == BeatEvent::Type::Beat ? publishedBeats
+                                                 : publishedOnsets);
+        }
+        if (newAnalysis) {
+          publishAnalysis(publisher, conditioning.frame(), visualizer,
+                          beatAnalyzer, publishedBeats, publishedOnsets);
+        }
       }
+    });
 
-      // Always render the visualizer
-      visualizer.render(window);
+    scheduler.addStage("UI", 30.0f, 3.0f, [&](float deltaTime) {
+      TRACE_SCOPE("ImGui");
+      perf::ScopedTimer timer(perf::Timer::ImGui);
+      updateUI(uiManager, imguiManager, uiTexture, deltaTime,
+               scheduler.getStage(renderStage).measuredHz, &visualizer);
+
+      // Record the whole configuration whenever the UI has changed it. The
+      // hue is left out, as it moves every frame without any edit.
+      if (!recorder.isRecording()) {
+        recordedConfig.clear();
+      } else {
+        VisualizerPreset snapshot = visualizer.getCurrentPreset("Session");
+        snapshot.visualizerConfig.hue = 0.0f;
+        std::string json = snapshot.toJSON();
+        if (json != recordedConfig) {
+          recorder.recordConfig(json, steadyNowNs());
+          recordedConfig = std::move(json);
+        }
+      }
+    });
 
-      // Update and render UI
-      updateUI(uiManager, imguiManager, deltaTime, &visualizer);
+    renderStage = scheduler.addStage("Render", 60.0f, 6.0f, [&](float deltaTime) {
+      // The first interval only measures startup
+      if (scheduler.getStage(renderStage).runs > 0) {
+        perf::cpuTimes(perf::Timer::Frame).record(deltaTime * 1000.0f);
+      }
 
-      // Display the frame
+      window.clear();
+      visualizer.render(window);
+
+      // The UI texture holds premultiplied colour
+      TRACE_SCOPE("Present");
+      perf::ScopedTimer timer(perf::Timer::Present);
+      window.draw(sf::Sprite(uiTexture.getTexture()),
+                  sf::RenderStates(sf::BlendMode(sf::BlendMode::One,
+                                                 sf::BlendMode::OneMinusSrcAlpha)));
+    });
+    scheduler.setPresent(renderStage, [&] {
       window.display();
+
+      if (scheduler.getStage(renderStage).runs == 1) {
+        std::cout << "Started in "
+                  << std::chrono::duration<float, std::milli>(
+                         std::chrono::steady_clock::now() - startupBegin)
+                         .count()
+                  << " ms" << std::endl;
+      }
+    });
+
+    uiManager.setScheduler(&scheduler);
+
+    // Trades detail for time when the work per rendered frame runs over
+    QualityGovernor governor;
+    uiManager.setQualityGovernor(&governor);
+    std::uint64_t renderedFrames = 0;
+    std::uint64_t policyVersion = 0;
+
+    // Main application loop
+    while (window.isOpen()) {
+      // Geometry, UI and render stages run on this thread, so it takes the
+      // render policy
+      threading::refreshPolicy(ThreadRole::Render, policyVersion);
+
+      // Process window events
+      processEvents(window, visualizer, imguiManager, uiTexture);
+
+      scheduler.runDueStages();
+
+      // Charge everything done since the last frame to the frame just shown
+      const FrameScheduler::Stage &render = scheduler.getStage(renderStage);
+      if (render.runs != renderedFrames) {
+        renderedFrames = render.runs;
+        if (governor.addFrame(scheduler.takeBusyMs())) {
+          visualizer.setQuality(governor.getQuality());
+        }
+      }
+      sf::sleep(sf::seconds(scheduler.secondsUntilNextStage()));
     }
 
-    // ... (existing cleanup code)
+    // Close a running trace and recording so the files are complete
+    trace::stop();
+    recorder.stop();
+    videoRecorder.stop();
+
+    // Measures plans this run had no wisdom for; only after a change of
+    // machine or analysis size
+    saveFftWisdom(FFT_WISDOM_FILE);
 
   } catch (const std::exception &e) {
     std::cerr << "Error: " << e.what() << std::endl;
@@ -48,44 +48,39 @@ void smoothAudioData(const std::vector<double> &audioData,
   }
 }
 
-void trimTrailingZeros(std::vector<double> &audioBuffer) {
-  while (!audioBuffer.empty() && audioBuffer.back() == 0.0) {
-    audioBuffer.pop_back();
+void mirrorAudioBuffer(const std::vector<double> &buffer,
+                       std::vector<double> &extendedBuffer, double gain) {
+  // Reserve capacity to avoid reallocations
+  const size_t size = buffer.size();
+  const size_t requiredSize = size * 2;
+  if (extendedBuffer.capacity() < requiredSize) {
+    extendedBuffer.reserve(requiredSize *
+                           1.5); // Reserve extra to reduce future reallocations
   }
-}
-
-bool isAudioPlaying(const std::vector<double> &audioBuffer) {
-  for (double value : audioBuffer) {
-    if (value != 0.0) {
-      return true;
-    }
-  }
-  return false;
-}
 
-// Optimized to find min and max in single pass
-void normalizeAudioData(std::vector<double> &audioBuffer) {
-  if (audioBuffer.empty()) {
-    return;
+  extendedBuffer.resize(requiredSize);
+  for (size_t i = 0; i < size; ++i) {
+    double value = buffer[i] * gain;
+    extendedBuffer[i] = value;
+    extendedBuffer[requiredSize - 1 - i] = value;
   }
 
-  // Find min and max in a single pass
-  double maxVal = audioBuffer[0];
-  double minVal = audioBuffer[0];
-
-  for (size_t i = 1; i < audioBuffer.size(); ++i) {
-    if (audioBuffer[i] > maxVal) {
-      maxVal = audioBuffer[i];
-    }
-    if (audioBuffer[i] < minVal) {
-      minVal = audioBuffer[i];
-    }
+  // Ensure continuity at the join point to avoid artifacts
+  if (size > 0) {
+    double avg = 0.5 * (buffer.front() + buffer.back()) * gain;
+    extendedBuffer[size - 1] = avg;
+    extendedBuffer[size] = avg;
   }
+}
 
-  double absMax = std::max(std::abs(maxVal), std::abs(minVal));
-  if (absMax > 0.0) {
-    for (auto &sample : audioBuffer) {
-      sample /= absMax;
+void downmixToMono(const float *interleaved, size_t frames, size_t channels,
+                   float *mono) {
+  const float scale = 1.0f / static_cast<float>(channels);
+  for (size_t i = 0; i < frames; ++i) {
+    float sum = 0.0f;
+    for (size_t c = 0; c < channels; ++c) {
+      sum += interleaved[i * channels + c];
     }
+    mono[i] = sum * scale;
   }
 }
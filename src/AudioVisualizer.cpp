@@ -1,4 +1,10 @@
 #include "AudioVisualizer.h"
+#include "PerfTimers.h"
+#include "ShaderCache.h"
+#include "Tracer.h"
+#include "VideoRecorder.h"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <iostream>
 
@@ -6,6 +12,32 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+// Build the complete scene for a preset. Runs on a worker thread, so it must
+// not touch any visualizer state.
+static std::unique_ptr<SceneState> buildScene(const VisualizerPreset &preset) {
+  TRACE_SCOPE("Build scene");
+  auto scene = std::make_unique<SceneState>();
+  scene->name = preset.name;
+  scene->visualizerConfig = preset.visualizerConfig;
+  scene->shaderConfig = preset.shaderConfig;
+  for (const auto &waveConfig : preset.waveforms) {
+    scene->waveforms.add(waveConfig);
+  }
+  scene->modulation = preset.modulation;
+  return scene;
+}
+
+static float lerp(float a, float b, float t) { return a + (b - a) * t; }
+
+// Decay time of the beat pulse, in seconds
+static constexpr float BEAT_PULSE_DECAY = 0.12f;
+
+static std::int64_t steadyNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
 AudioVisualizer::AudioVisualizer(VisualizerConfig &config, ShaderConfig &shaderConfig)
     : config(config), shaderConfig(shaderConfig), rotationAngle(0.0f) {
   // Create a default waveform with settings from global config
@@ -19,59 +51,148 @@ AudioVisualizer::AudioVisualizer(VisualizerConfig &config, ShaderConfig &shaderC
   waveConfig.alpha = 255;
   waveConfig.thickAlpha = 255;
 
-  waveforms.push_back(new Waveform(waveConfig));
+  waveforms.add(waveConfig);
 }
 
 AudioVisualizer::~AudioVisualizer() {
-  // Clean up waveforms
-  for (size_t i = 0; i < waveforms.size(); ++i) {
-    delete waveforms[i];
+  // Let an in-flight scene build finish before members go away
+  if (pendingScene.valid()) {
+    pendingScene.wait();
   }
-  waveforms.clear();
 }
 
 bool AudioVisualizer::initialize(unsigned int width, unsigned int height) {
   // Create render texture
-  if (!renderTexture.create(width, height)) {
+  viewSize = sf::Vector2u(width, height);
+  if (!createTrailTexture()) {
     std::cerr << "Failed to create render texture" << std::endl;
     return false;
   }
-  renderTexture.clear(sf::Color::Black);
 
   // Load shader
-  if (!shader.loadFromFile("fade_blur.frag", sf::Shader::Fragment)) {
+  if (!shaders::loadCached(shader, "fade_blur.frag", sf::Shader::Fragment)) {
     std::cerr << "Failed to load shader" << std::endl;
     return false;
   }
 
   // Initialize shader uniforms
-  shader.setUniform("fadeFactor", shaderConfig.fadeFactor);
-  shader.setUniform("resolution", sf::Vector2f(static_cast<float>(width),
-                                               static_cast<float>(height)));
-  shader.setUniform("blendFactor", shaderConfig.blendFactor);
-  shader.setUniform("pixelSize", static_cast<float>(shaderConfig.pixelSize));
-  shader.setUniform("fadeThreshold", shaderConfig.fadeThreshold);
-  
-  // Initialize enhancement effect uniforms
-  shader.setUniform("saturationBoost", shaderConfig.saturationBoost);
-  shader.setUniform("ditherStrength", shaderConfig.ditherStrength);
+  applyShaderUniforms(shaderConfig);
   shader.setUniform("time", 0.0f);
 
+  // Optional; without it waveform geometry is built on the CPU
+  gpuGeometryAvailable =
+      sf::Shader::isAvailable() &&
+      shaders::loadCached(waveformShader, "waveform.vert", sf::Shader::Vertex);
+  if (!gpuGeometryAvailable) {
+    std::cerr << "Failed to load waveform shader, building waveforms on the CPU"
+              << std::endl;
+  }
+
   return true;
 }
 
 void AudioVisualizer::handleResize(unsigned int width, unsigned int height) {
-  // Resize render texture
-  renderTexture.create(width, height);
+  viewSize = sf::Vector2u(width, height);
+  createTrailTexture();
+}
+
+bool AudioVisualizer::createTrailTexture() {
+  // Trails may run below view resolution; everything is drawn in view
+  // coordinates and scaled up when composited
+  sf::Vector2u size(
+      std::max(1u, static_cast<unsigned int>(viewSize.x * quality.trailScale)),
+      std::max(1u, static_cast<unsigned int>(viewSize.y * quality.trailScale)));
+  if (!renderTexture.create(size.x, size.y)) {
+    return false;
+  }
+  // Their queries went with the old texture's context
+  trailGpuTimer.abandon();
+  waveformGpuTimer.abandon();
   renderTexture.clear(sf::Color::Black);
+  trailView = sf::View(sf::FloatRect(0.0f, 0.0f, static_cast<float>(viewSize.x),
+                                     static_cast<float>(viewSize.y)));
+
+  shader.setUniform("resolution", sf::Vector2f(static_cast<float>(size.x),
+                                               static_cast<float>(size.y)));
+  return true;
+}
+
+void AudioVisualizer::setQuality(const RenderQuality &renderQuality) {
+  bool resize = renderQuality.trailScale != quality.trailScale;
+  quality = renderQuality;
+  if (resize && viewSize.x > 0) {
+    createTrailTexture();
+  }
+}
+
+void AudioVisualizer::beginFrame(float deltaTime) {
+  if (beatAnalyzer) {
+    beatEvents.clear();
+    beatAnalyzer->pollEvents(beatEvents);
+    for (const BeatEvent &event : beatEvents) {
+      if (event.type == BeatEvent::Type::Beat) {
+        lastBeat = event;
+        hasBeat = true;
+      }
+    }
+  }
+
+  // Commit a finished scene build; never block waiting for one
+  if (pendingScene.valid() &&
+      pendingScene.wait_for(std::chrono::seconds(0)) ==
+          std::future_status::ready) {
+    std::unique_ptr<SceneState> scene = pendingScene.get();
+    if (scene) {
+      commitScene(std::move(scene));
+    }
 
-  // Update shader resolution
-  shader.setUniform("resolution", sf::Vector2f(static_cast<float>(width),
-                                               static_cast<float>(height)));
+    // Start the most recent request that arrived during the build
+    if (queuedBuilder) {
+      SceneBuilder builder;
+      std::swap(builder, queuedBuilder);
+      startSceneBuild(std::move(builder), queuedCrossfade);
+    }
+  }
+
+  if (!isCrossfading()) {
+    return;
+  }
+
+  crossfadeElapsed += deltaTime;
+  if (crossfadeElapsed >= crossfadeDuration) {
+    fadingWaveforms.clear();
+    crossfadeDuration = 0.0f;
+  }
 }
 
-void AudioVisualizer::update(const std::vector<double> &audioBuffer,
-                             float deltaTime) {
+ShaderConfig AudioVisualizer::crossfadeShader() const {
+  ShaderConfig blended = shaderConfig;
+  if (!isCrossfading()) {
+    return blended;
+  }
+
+  float t = std::min(crossfadeElapsed / crossfadeDuration, 1.0f);
+  blended.fadeFactor = lerp(fadeFromShader.fadeFactor, shaderConfig.fadeFactor, t);
+  blended.blendFactor = lerp(fadeFromShader.blendFactor, shaderConfig.blendFactor, t);
+  blended.fadeThreshold = lerp(fadeFromShader.fadeThreshold, shaderConfig.fadeThreshold, t);
+  blended.saturationBoost = lerp(fadeFromShader.saturationBoost, shaderConfig.saturationBoost, t);
+  blended.ditherStrength = lerp(fadeFromShader.ditherStrength, shaderConfig.ditherStrength, t);
+  blended.pixelSize = static_cast<int>(std::lround(lerp(
+      static_cast<float>(fadeFromShader.pixelSize),
+      static_cast<float>(shaderConfig.pixelSize), t)));
+  return blended;
+}
+
+void AudioVisualizer::setAnalysisFrame(const AnalysisFrame &frame) {
+  TRACE_SCOPE("Smoothing");
+  perf::ScopedTimer timer(perf::Timer::Smoothing);
+  smoothing.build(frame.samples, frame.gain);
+  analysisRms = static_cast<float>(frame.rms);
+  analysisPeak = static_cast<float>(frame.peak);
+}
+
+void AudioVisualizer::update(float deltaTime) {
+  TRACE_SCOPE("Visualizer update");
   // Update rotation angle for global hue
   rotationAngle += config.rotationSpeed * deltaTime;
 
@@ -80,22 +201,65 @@ void AudioVisualizer::update(const std::vector<double> &audioBuffer,
             (2.0 * M_PI));
 
   // Update all waveforms
-  float width = static_cast<float>(renderTexture.getSize().x);
-  float height = static_cast<float>(renderTexture.getSize().y);
+  float width = static_cast<float>(viewSize.x);
+  float height = static_cast<float>(viewSize.y);
 
-  for (size_t i = 0; i < waveforms.size(); ++i) {
-    waveforms[i]->update(audioBuffer, config.hue, deltaTime, width, height);
+  configureStore(waveforms);
+  configureStore(fadingWaveforms);
+
+  if (config.bars || spectrumRequired || modulation.usesBands()) {
+    updateSpectrum(deltaTime);
+  }
+  if (config.bars) {
+    radialBars.update(bands.getLevels(), config.hue, rotationAngle, width,
+                      height, config.barRadiusFactor, config.barHeight);
   }
 
-  // Update shader uniforms
-  shader.setUniform("fadeFactor", shaderConfig.fadeFactor);
-  shader.setUniform("pixelSize", static_cast<float>(shaderConfig.pixelSize));
-  shader.setUniform("blendFactor", shaderConfig.blendFactor);
-  shader.setUniform("fadeThreshold", shaderConfig.fadeThreshold);
-  
-  // Update enhancement effect uniforms
-  shader.setUniform("saturationBoost", shaderConfig.saturationBoost);
-  shader.setUniform("ditherStrength", shaderConfig.ditherStrength);
+  // Envelope that decays from each tracked beat; kicks the radius
+  float beatEnvelope = 0.0f;
+  float beatPhase = getBeatPhase();
+  if (beatPhase >= 0.0f) {
+    float sinceBeat = beatPhase * 60.0f / lastBeat.bpm;
+    beatEnvelope = std::exp(-sinceBeat / BEAT_PULSE_DECAY);
+  }
+  radiusScale = 1.0f + config.beatPulse * beatEnvelope;
+
+  {
+    TRACE_SCOPE("Modulation");
+    perf::ScopedTimer timer(perf::Timer::Modulation);
+    ModulationInputs inputs;
+    inputs.rms = analysisRms;
+    inputs.peak = analysisPeak;
+    inputs.beatPhase = beatPhase;
+    inputs.beatPulse = beatEnvelope;
+    inputs.bands = bands.getLevels().data();
+    inputs.bandCount = bands.getBandCount();
+    modulation.evaluate(inputs, waveforms.size(), deltaTime);
+    if (isCrossfading()) {
+      fadingModulation.evaluate(inputs, fadingWaveforms.size(), deltaTime);
+    }
+  }
+  waveforms.setModulation(&modulation);
+  fadingWaveforms.setModulation(&fadingModulation);
+
+  perf::ScopedTimer timer(perf::Timer::Geometry);
+
+  // While crossfading, both scenes update with complementary opacity
+  float incomingOpacity = 1.0f;
+  if (isCrossfading()) {
+    incomingOpacity = std::min(crossfadeElapsed / crossfadeDuration, 1.0f);
+    fadingWaveforms.update(smoothing, config.hue, deltaTime, width, height,
+                           1.0f - incomingOpacity, radiusScale);
+  }
+
+  waveforms.update(smoothing, config.hue, deltaTime, width, height,
+                   incomingOpacity, radiusScale);
+
+  // Update shader uniforms; the crossfade and modulation apply to this
+  // frame only
+  ShaderConfig frameShader = crossfadeShader();
+  modulation.applyToShader(frameShader);
+  applyShaderUniforms(frameShader);
   
   // Update time for temporal dithering
   static float timeAccumulator = 0.0f;
@@ -103,32 +267,223 @@ void AudioVisualizer::update(const std::vector<double> &audioBuffer,
   shader.setUniform("time", timeAccumulator);
 }
 
-void AudioVisualizer::addWaveform(const WaveformConfig &config) {
-  waveforms.push_back(new Waveform(config));
+void AudioVisualizer::configureStore(WaveformStore &store) {
+  store.setGeometryShader(gpuGeometryAvailable && gpuGeometryEnabled
+                              ? &waveformShader
+                              : nullptr);
+  store.setGeometryPipelined(geometryPipelined);
+  store.setQuality(quality);
+}
+
+void AudioVisualizer::updateSpectrum(float deltaTime) {
+  size_t fftSize = 0;
+  unsigned int sampleRate = 0;
+  if (!beatAnalyzer ||
+      !beatAnalyzer->takeSpectrum(magnitudes, fftSize, sampleRate)) {
+    return;
+  }
+
+  size_t bandCount = static_cast<size_t>(std::max(config.barCount, 1));
+  if (!bands.matches(fftSize, sampleRate, bandCount)) {
+    bands.configure(fftSize, sampleRate, bandCount);
+  }
+
+  spectrumFftSize = fftSize;
+  bands.process(magnitudes.data(), deltaTime, config.barAttack,
+                config.barRelease);
+}
+
+float AudioVisualizer::getBeatPhase() const {
+  if (!hasBeat || lastBeat.bpm <= 0.0f) {
+    return -1.0f;
+  }
+
+  // Extrapolate from the last beat so the phase keeps moving between
+  // events; give up once two beats have been missed
+  double periodNs = 60.0e9 / lastBeat.bpm;
+  double elapsed = static_cast<double>(steadyNowNs() - lastBeat.timeNs);
+  if (elapsed < 0.0 || elapsed > 3.0 * periodNs) {
+    return -1.0f;
+  }
+  return static_cast<float>(std::fmod(elapsed, periodNs) / periodNs);
+}
+
+void AudioVisualizer::applyShaderUniforms(const ShaderConfig &shaderSettings) {
+  shader.setUniform("fadeFactor", shaderSettings.fadeFactor);
+  shader.setUniform("pixelSize", std::max(1.0f, shaderSettings.pixelSize *
+                                                     quality.trailScale));
+  shader.setUniform("jitterSamples",
+                    static_cast<float>(quality.jitterSamples));
+  shader.setUniform("blendFactor", shaderSettings.blendFactor);
+  shader.setUniform("fadeThreshold", shaderSettings.fadeThreshold);
+
+  // Enhancement effect uniforms
+  shader.setUniform("saturationBoost", shaderSettings.saturationBoost);
+  shader.setUniform("ditherStrength", shaderSettings.ditherStrength);
+}
+
+WaveformHandle AudioVisualizer::addWaveform(const WaveformConfig &config) {
+  return waveforms.add(config);
 }
 
 void AudioVisualizer::removeWaveform(size_t index) {
   if (index < waveforms.size()) {
-    delete waveforms[index];
-    waveforms.erase(waveforms.begin() + index);
+    waveforms.remove(waveforms.getHandle(index));
+    modulation.removeWaveform(index);
+  }
+}
+
+VisualizerPreset AudioVisualizer::getCurrentPreset(const std::string &name) const {
+  VisualizerPreset preset;
+  preset.name = name;
+  preset.visualizerConfig = config;
+  preset.shaderConfig = shaderConfig;
+  for (size_t i = 0; i < waveforms.size(); ++i) {
+    preset.waveforms.push_back(waveforms.getConfig(i));
+  }
+  preset.modulation = modulation.getSettings();
+  return preset;
+}
+
+void AudioVisualizer::loadPresetAsync(const std::string &filepath,
+                                      float crossfadeSeconds) {
+  startSceneBuild(
+      [filepath]() -> std::unique_ptr<SceneState> {
+        trace::setThreadName("Preset Loader");
+        TRACE_SCOPE("Load preset");
+        VisualizerPreset preset;
+        if (!ConfigSerializer::loadPreset(filepath, preset)) {
+          return nullptr;
+        }
+        return buildScene(preset);
+      },
+      crossfadeSeconds);
+}
+
+void AudioVisualizer::applyPresetAsync(const VisualizerPreset &preset,
+                                       float crossfadeSeconds) {
+  startSceneBuild(
+      [preset]() {
+        trace::setThreadName("Preset Loader");
+        return buildScene(preset);
+      },
+      crossfadeSeconds);
+}
+
+bool AudioVisualizer::applyPresetInPlace(const VisualizerPreset &preset) {
+  if (pendingScene.valid() || isCrossfading() ||
+      preset.waveforms.size() != waveforms.size()) {
+    return false;
+  }
+
+  float hue = config.hue;
+  config = preset.visualizerConfig;
+  config.hue = hue;
+  shaderConfig = preset.shaderConfig;
+  for (size_t i = 0; i < preset.waveforms.size(); ++i) {
+    waveforms.getConfig(i) = preset.waveforms[i];
   }
+  modulation.setSettings(preset.modulation);
+  return true;
+}
+
+void AudioVisualizer::startSceneBuild(SceneBuilder builder,
+                                      float crossfadeSeconds) {
+  // Only one build runs at a time; keep the latest request for afterwards
+  if (pendingScene.valid()) {
+    queuedBuilder = std::move(builder);
+    queuedCrossfade = crossfadeSeconds;
+    return;
+  }
+
+  pendingCrossfade = crossfadeSeconds;
+  pendingScene = std::async(std::launch::async, std::move(builder));
+}
+
+void AudioVisualizer::commitScene(std::unique_ptr<SceneState> scene) {
+  TRACE_SCOPE("Commit scene");
+  // A crossfade interrupted by another swap drops its outgoing scene, and
+  // the shader fades on from wherever it had reached
+  ShaderConfig shownShader = crossfadeShader();
+  fadingWaveforms.clear();
+  crossfadeDuration = 0.0f;
+
+  if (pendingCrossfade > 0.0f) {
+    fadingWaveforms = std::move(waveforms);
+    fadingModulation = modulation;
+    fadeFromShader = shownShader;
+    crossfadeDuration = pendingCrossfade;
+    crossfadeElapsed = 0.0f;
+  }
+  shaderConfig = scene->shaderConfig;
+
+  // Build the incoming scene's first frame inline from the current audio,
+  // so it is drawn straight away instead of waiting for the producer
+  float hue = config.hue;
+  float incomingOpacity = crossfadeDuration > 0.0f ? 0.0f : 1.0f;
+  configureStore(scene->waveforms);
+  scene->waveforms.setGeometryPipelined(false);
+  scene->waveforms.update(smoothing, hue, 0.0f, static_cast<float>(viewSize.x),
+                          static_cast<float>(viewSize.y), incomingOpacity,
+                          radiusScale);
+  scene->waveforms.setGeometryPipelined(geometryPipelined);
+
+  config = scene->visualizerConfig;
+  config.hue = hue;
+  waveforms = std::move(scene->waveforms);
+  // LFOs keep their phase across the swap
+  modulation.setSettings(scene->modulation);
+
+  std::cout << "Preset applied: " << scene->name << std::endl;
 }
 
 void AudioVisualizer::render(sf::RenderWindow &window) {
+  TRACE_SCOPE("Visualizer render");
   // Create sprite from render texture
   sf::Sprite sprite(renderTexture.getTexture());
 
-  // Apply shader to create trail effect
-  renderTexture.draw(sprite, &shader);
+  // GPU timer queries are issued on the trail texture's context
+  renderTexture.setActive(true);
 
-  // Render all waveforms
-  for (size_t i = 0; i < waveforms.size(); ++i) {
-    waveforms[i]->render(renderTexture);
+  // Apply shader to create trail effect, texel for texel
+  {
+    perf::ScopedTimer timer(perf::Timer::TrailShader);
+    trailGpuTimer.begin();
+    renderTexture.setView(renderTexture.getDefaultView());
+    renderTexture.draw(sprite, &shader);
+    trailGpuTimer.end();
+  }
+
+  {
+    perf::ScopedTimer timer(perf::Timer::Waveforms);
+    waveformGpuTimer.begin();
+
+    // Geometry is in view coordinates whatever the trail resolution
+    renderTexture.setView(trailView);
+
+    if (config.bars) {
+      radialBars.render(renderTexture);
+    }
+
+    // Render the outgoing scene underneath the incoming one
+    fadingWaveforms.render(renderTexture);
+
+    // Render all waveforms
+    waveforms.render(renderTexture);
+
+    waveformGpuTimer.end();
   }
 
   renderTexture.display();
 
-  // Draw accumulated texture to window
+  if (videoRecorder) {
+    videoRecorder->capture(renderTexture);
+  }
+
+  // Draw accumulated texture to window at view size
   sf::Sprite accumulatedSprite(renderTexture.getTexture());
+  accumulatedSprite.setScale(
+      static_cast<float>(viewSize.x) / renderTexture.getSize().x,
+      static_cast<float>(viewSize.y) / renderTexture.getSize().y);
   window.draw(accumulatedSprite);
 }
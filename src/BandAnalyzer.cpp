@@ -0,0 +1,96 @@
+#include "BandAnalyzer.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cmath>
+
+// Band levels map this range of dB below full scale onto [0, 1]
+static constexpr float FLOOR_DB = -60.0f;
+
+void BandAnalyzer::configure(size_t fftSize, unsigned int sampleRate,
+                             size_t bandCount, float minFrequency,
+                             float maxFrequency) {
+  configuredFftSize = fftSize;
+  configuredRate = sampleRate;
+
+  const size_t bins = fftSize / 2 + 1;
+  const double binWidth = static_cast<double>(sampleRate) / fftSize;
+  const double nyquist = sampleRate / 2.0;
+  const double low = std::max<double>(minFrequency, binWidth);
+  const double high = std::max(low * 2.0, std::min<double>(maxFrequency, nyquist));
+
+  // Centres are log spaced; each band's triangle reaches its neighbours'
+  std::vector<double> centres(bandCount + 2);
+  for (size_t b = 0; b < centres.size(); ++b) {
+    double t = (static_cast<double>(b) - 0.5) / bandCount;
+    centres[b] = low * std::pow(high / low, t);
+  }
+
+  firstBin.assign(bandCount, 0);
+  weightOffset.assign(bandCount + 1, 0);
+  weights.clear();
+  levels.assign(bandCount, 0.0f);
+
+  for (size_t b = 0; b < bandCount; ++b) {
+    const double left = centres[b];
+    const double centre = centres[b + 1];
+    const double right = centres[b + 2];
+
+    size_t begin = static_cast<size_t>(std::ceil(left / binWidth));
+    size_t end = std::min(bins, static_cast<size_t>(std::floor(right / binWidth)) + 1);
+    weightOffset[b] = weights.size();
+
+    double total = 0.0;
+    if (begin < end) {
+      firstBin[b] = begin;
+      for (size_t k = begin; k < end; ++k) {
+        double frequency = k * binWidth;
+        double weight = frequency <= centre
+                            ? (frequency - left) / (centre - left)
+                            : (right - frequency) / (right - centre);
+        weights.push_back(static_cast<float>(std::max(weight, 0.0)));
+        total += weights.back();
+      }
+    }
+
+    if (total <= 0.0) {
+      // Narrower than a bin at low frequencies: interpolate between the two
+      // bins around the centre instead
+      weights.resize(weightOffset[b]);
+      double position = std::min(centre / binWidth, static_cast<double>(bins - 1));
+      size_t lower = std::min(static_cast<size_t>(position), bins - 2);
+      double fraction = position - lower;
+      firstBin[b] = lower;
+      weights.push_back(static_cast<float>(1.0 - fraction));
+      weights.push_back(static_cast<float>(fraction));
+      total = 1.0;
+    }
+
+    // Normalise so a band reads the average magnitude under its triangle
+    for (size_t i = weightOffset[b]; i < weights.size(); ++i) {
+      weights[i] = static_cast<float>(weights[i] / total);
+    }
+  }
+  weightOffset[bandCount] = weights.size();
+}
+
+void BandAnalyzer::process(const float *magnitudes, float deltaTime,
+                           float attack, float release) {
+  const float attackCoefficient =
+      attack > 0.0f ? 1.0f - std::exp(-deltaTime / attack) : 1.0f;
+  const float releaseCoefficient =
+      release > 0.0f ? 1.0f - std::exp(-deltaTime / release) : 1.0f;
+
+  for (size_t b = 0; b < levels.size(); ++b) {
+    const size_t offset = weightOffset[b];
+    float magnitude =
+        dotProduct(weights.data() + offset, magnitudes + firstBin[b],
+                   weightOffset[b + 1] - offset);
+
+    float db = 20.0f * std::log10(magnitude + 1e-9f);
+    float target = std::max(0.0f, std::min(1.0f, 1.0f - db / FLOOR_DB));
+
+    float coefficient =
+        target > levels[b] ? attackCoefficient : releaseCoefficient;
+    levels[b] += (target - levels[b]) * coefficient;
+  }
+}
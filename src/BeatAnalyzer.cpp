@@ -0,0 +1,218 @@
+#include "BeatAnalyzer.h"
+#include "ThreadConfig.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+// About 1.4 s of 48 kHz audio and plenty of packets and events in flight
+static constexpr size_t SAMPLE_CAPACITY = 1 << 16;
+static constexpr size_t STAMP_CAPACITY = 1024;
+static constexpr size_t EVENT_CAPACITY = 256;
+
+// Stamps kept for mapping event positions back to capture times
+static constexpr size_t RECENT_STAMPS = 64;
+
+// Spectrum display STFT: about 43 ms windows every 2.7 ms at 48 kHz
+static constexpr double SPECTRUM_WINDOW_SECONDS = 0.04;
+static constexpr size_t SPECTRUM_HOPS_PER_WINDOW = 16;
+
+// The maximum delay shown covers this trailing period
+static constexpr std::int64_t MAX_DELAY_WINDOW_NS = 5'000'000'000;
+
+static std::int64_t steadyNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+BeatAnalyzer::BeatAnalyzer()
+    : samples(SAMPLE_CAPACITY), stamps(STAMP_CAPACITY),
+      events(EVENT_CAPACITY) {
+  analysisThread = std::thread(&BeatAnalyzer::analysisLoop, this);
+}
+
+BeatAnalyzer::~BeatAnalyzer() {
+  running = false;
+  if (analysisThread.joinable()) {
+    analysisThread.join();
+  }
+}
+
+void BeatAnalyzer::pushPacket(const float *data, size_t frames,
+                              unsigned int channels, unsigned int sampleRate,
+                              std::int64_t captureTimeNs) {
+  if (frames == 0 || channels == 0) {
+    return;
+  }
+
+  // Mix down to mono here so the ring carries a single channel
+  monoScratch.resize(frames);
+  if (!data) {
+    std::fill(monoScratch.begin(), monoScratch.end(), 0.0f);
+  } else {
+    const float scale = 1.0f / static_cast<float>(channels);
+    for (size_t i = 0; i < frames; ++i) {
+      float sum = 0.0f;
+      for (unsigned int c = 0; c < channels; ++c) {
+        sum += data[i * channels + c];
+      }
+      monoScratch[i] = sum * scale;
+    }
+  }
+
+  PacketStamp stamp;
+  stamp.firstSample = samplesPushed;
+  stamp.timeNs = captureTimeNs;
+  stamp.sampleRate = sampleRate;
+  if (!stamps.push(stamp)) {
+    droppedSamples += frames;
+    return;
+  }
+
+  size_t written = samples.write(monoScratch.data(), frames);
+  samplesPushed += written;
+  droppedSamples += frames - written;
+}
+
+void BeatAnalyzer::pollEvents(std::vector<BeatEvent> &out) {
+  BeatEvent event;
+  while (events.pop(event)) {
+    out.push_back(event);
+  }
+}
+
+bool BeatAnalyzer::takeSpectrum(std::vector<float> &magnitudes,
+                                size_t &fftSize, unsigned int &sampleRate) {
+  std::lock_guard<std::mutex> lock(spectrumMutex);
+  if (!spectrumFresh) {
+    return false;
+  }
+  std::swap(magnitudes, sharedSpectrum);
+  fftSize = sharedFftSize;
+  sampleRate = sharedSampleRate;
+  spectrumFresh = false;
+  return true;
+}
+
+void BeatAnalyzer::publishSpectrum(const std::vector<float> &peaks,
+                                   unsigned int rate) {
+  std::lock_guard<std::mutex> lock(spectrumMutex);
+  if (!spectrumFresh || sharedSpectrum.size() != peaks.size()) {
+    sharedSpectrum.assign(peaks.begin(), peaks.end());
+  } else {
+    // Not taken yet; keep the loudest of both
+    for (size_t k = 0; k < peaks.size(); ++k) {
+      sharedSpectrum[k] = std::max(sharedSpectrum[k], peaks[k]);
+    }
+  }
+  sharedFftSize = spectrum->getWindowSize();
+  sharedSampleRate = rate;
+  spectrumFresh = true;
+}
+
+std::int64_t BeatAnalyzer::sampleTime(std::uint64_t sample) const {
+  // Latest packet starting at or before the sample
+  for (auto it = recentStamps.rbegin(); it != recentStamps.rend(); ++it) {
+    if (it->firstSample <= sample) {
+      double offsetNs = static_cast<double>(sample - it->firstSample) * 1e9 /
+                        it->sampleRate;
+      return it->timeNs + static_cast<std::int64_t>(offsetNs);
+    }
+  }
+  return recentStamps.empty() ? steadyNowNs() : recentStamps.front().timeNs;
+}
+
+void BeatAnalyzer::recordDelay(std::int64_t delayNs) {
+  float delayMs = static_cast<float>(delayNs) / 1e6f;
+
+  float mean = meanDelayMs.load();
+  meanDelayMs = mean == 0.0f ? delayMs : mean + (delayMs - mean) * 0.1f;
+
+  std::int64_t now = steadyNowNs();
+  if (now - maxWindowStartNs > MAX_DELAY_WINDOW_NS) {
+    maxWindowStartNs = now;
+    maxWindowDelayMs = 0.0f;
+  }
+  maxWindowDelayMs = std::max(maxWindowDelayMs, delayMs);
+  maxDelayMs = maxWindowDelayMs;
+}
+
+void BeatAnalyzer::analysisLoop() {
+  std::vector<float> chunk(4096);
+  std::vector<BeatEvent> detected;
+  std::uint64_t samplesRead = 0;
+  std::uint64_t detectorOrigin = 0; // Stream position of detector sample 0
+  std::uint64_t policyVersion = 0;
+  trace::setThreadName("Beat Analysis");
+
+  while (running) {
+    threading::refreshPolicy(ThreadRole::Analysis, policyVersion);
+    PacketStamp stamp;
+    while (stamps.pop(stamp)) {
+      recentStamps.push_back(stamp);
+      if (!detector || detector->getSampleRate() != stamp.sampleRate) {
+        std::cout << "Beat analysis running at " << stamp.sampleRate << " Hz"
+                  << std::endl;
+        detector = std::make_unique<BeatDetector>(stamp.sampleRate);
+        detectorOrigin = samplesRead;
+
+        size_t windowSize = 256;
+        while (windowSize < stamp.sampleRate * SPECTRUM_WINDOW_SECONDS) {
+          windowSize <<= 1;
+        }
+        spectrum = std::make_unique<StftEngine>(
+            windowSize, windowSize / SPECTRUM_HOPS_PER_WINDOW);
+      }
+    }
+    if (recentStamps.size() > RECENT_STAMPS) {
+      recentStamps.erase(recentStamps.begin(),
+                         recentStamps.end() - RECENT_STAMPS);
+    }
+
+    size_t count = samples.read(chunk.data(), chunk.size());
+    if (count == 0 || !detector) {
+      // A hop is a few milliseconds; polling at 1 ms keeps well inside it
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+    samplesRead += count;
+
+    TRACE_SCOPE("Beat analysis");
+    detected.clear();
+    detector->process(chunk.data(), count, detected);
+    bpm = detector->getBpm();
+    confidence = detector->getConfidence();
+
+    // Fold every hop of this chunk into one peak spectrum, then publish once
+    bool hopped = false;
+    spectrum->process(chunk.data(), count,
+                      [&](const std::vector<float> &magnitudes) {
+                        if (!hopped) {
+                          spectrumPeaks.assign(magnitudes.begin(),
+                                               magnitudes.end());
+                          hopped = true;
+                          return;
+                        }
+                        for (size_t k = 0; k < magnitudes.size(); ++k) {
+                          spectrumPeaks[k] =
+                              std::max(spectrumPeaks[k], magnitudes[k]);
+                        }
+                      });
+    if (hopped) {
+      publishSpectrum(spectrumPeaks, detector->getSampleRate());
+    }
+
+    std::int64_t now = steadyNowNs();
+    for (BeatEvent &event : detected) {
+      event.sample += detectorOrigin;
+      event.timeNs = sampleTime(event.sample);
+      if (event.type == BeatEvent::Type::Onset) {
+        recordDelay(now - event.timeNs);
+      }
+      if (!events.push(event)) {
+        break; // Renderer is not polling; drop the rest
+      }
+    }
+  }
+}
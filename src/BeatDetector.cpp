@@ -0,0 +1,216 @@
+#include "BeatDetector.h"
+#include <algorithm>
+#include <cmath>
+
+// Longest window in seconds; rounded down to a power of two in samples, so
+// 512 at 44.1 and 48 kHz. Rounding up would double it to about 21 ms.
+static constexpr double WINDOW_SECONDS = 0.011;
+static constexpr size_t HOPS_PER_WINDOW = 4;
+
+// Log compression applied to magnitudes before taking the flux
+static constexpr double COMPRESSION = 500.0;
+
+// Adaptive threshold: mean + THRESHOLD_DEVIATIONS * stddev over the last
+// THRESHOLD_SECONDS of flux, never below MIN_THRESHOLD
+static constexpr double THRESHOLD_SECONDS = 0.5;
+static constexpr double THRESHOLD_DEVIATIONS = 1.5;
+static constexpr double MIN_THRESHOLD = 0.05;
+static constexpr double MIN_ONSET_INTERVAL = 0.08; // Seconds
+
+// Tempo search range and how much onset history it looks at
+static constexpr double MIN_BPM = 60.0;
+static constexpr double MAX_BPM = 180.0;
+static constexpr double PREFERRED_BPM = 120.0;
+static constexpr double TEMPO_SECONDS = 6.0;
+static constexpr double TEMPO_UPDATE_SECONDS = 0.25;
+static constexpr float MIN_CONFIDENCE = 0.1f;
+
+// Fraction of the phase error removed by each onset near a predicted beat
+static constexpr double PHASE_CORRECTION = 0.2;
+static constexpr double PHASE_TOLERANCE = 0.2; // Of a beat period
+
+static size_t windowSizeFor(unsigned int sampleRate) {
+  size_t windowSize = 64;
+  while (windowSize * 2 <= sampleRate * WINDOW_SECONDS) {
+    windowSize <<= 1;
+  }
+  return windowSize;
+}
+
+BeatDetector::BeatDetector(unsigned int sampleRate)
+    : sampleRate(sampleRate),
+      stft(windowSizeFor(sampleRate),
+           windowSizeFor(sampleRate) / HOPS_PER_WINDOW) {
+  hopsPerSecond = static_cast<double>(sampleRate) / stft.getHopSize();
+  magnitudes.assign(stft.getBinCount(), 0.0);
+  previousMagnitudes.assign(stft.getBinCount(), 0.0);
+
+  fluxHistory.assign(
+      std::max<size_t>(1, static_cast<size_t>(THRESHOLD_SECONDS * hopsPerSecond)),
+      0.0);
+  envelope.assign(static_cast<size_t>(TEMPO_SECONDS * hopsPerSecond), 0.0f);
+}
+
+void BeatDetector::process(const float *samples, size_t count,
+                           std::vector<BeatEvent> &events) {
+  stft.process(samples, count, [&](const std::vector<float> &spectrum) {
+    analyseHop(spectrum, events);
+  });
+}
+
+void BeatDetector::analyseHop(const std::vector<float> &spectrum,
+                              std::vector<BeatEvent> &events) {
+  double flux = 0.0;
+  for (size_t k = 0; k < magnitudes.size(); ++k) {
+    magnitudes[k] = std::log1p(COMPRESSION * spectrum[k]);
+    flux += std::max(0.0, magnitudes[k] - previousMagnitudes[k]);
+  }
+  flux /= static_cast<double>(magnitudes.size());
+  std::swap(magnitudes, previousMagnitudes);
+
+  // Threshold from the history before this hop
+  double mean = fluxCount > 0 ? fluxSum / fluxCount : 0.0;
+  double variance =
+      fluxCount > 0 ? std::max(0.0, fluxSumSquares / fluxCount - mean * mean)
+                    : 0.0;
+  double threshold = std::max(
+      MIN_THRESHOLD, mean + THRESHOLD_DEVIATIONS * std::sqrt(variance));
+
+  double oldest = fluxHistory[fluxPos];
+  fluxHistory[fluxPos] = flux;
+  fluxPos = (fluxPos + 1) % fluxHistory.size();
+  if (fluxCount == fluxHistory.size()) {
+    fluxSum -= oldest;
+    fluxSumSquares -= oldest * oldest;
+  } else {
+    ++fluxCount;
+  }
+  fluxSum += flux;
+  fluxSumSquares += flux * flux;
+
+  // Pick on the rising edge rather than the peak, which would cost a hop of
+  // lookahead
+  bool above = flux > threshold;
+  bool onset = false;
+  std::uint64_t hopStart = stft.getPosition() - stft.getHopSize();
+  if (above && !wasAboveThreshold &&
+      hopStart - lastOnsetSample >= MIN_ONSET_INTERVAL * sampleRate) {
+    onset = true;
+    lastOnsetSample = hopStart;
+
+    BeatEvent event;
+    event.type = BeatEvent::Type::Onset;
+    event.sample = hopStart;
+    event.strength = static_cast<float>((flux - threshold) / threshold);
+    event.bpm = bpm;
+    events.push_back(event);
+  }
+  wasAboveThreshold = above;
+
+  envelope[envelopePos] = static_cast<float>(std::max(0.0, flux - mean));
+  envelopePos = (envelopePos + 1) % envelope.size();
+  envelopeCount = std::min(envelopeCount + 1, envelope.size());
+
+  if (++hopsSinceTempo >= TEMPO_UPDATE_SECONDS * hopsPerSecond) {
+    hopsSinceTempo = 0;
+    updateTempo();
+  }
+
+  trackBeats(onset, events);
+}
+
+void BeatDetector::updateTempo() {
+  const size_t minLag = static_cast<size_t>(hopsPerSecond * 60.0 / MAX_BPM);
+  const size_t maxLag = static_cast<size_t>(hopsPerSecond * 60.0 / MIN_BPM);
+  if (envelopeCount < maxLag * 2) {
+    return;
+  }
+
+  // Unwrap the oldest-first envelope into the autocorrelation scratch
+  const size_t size = envelopeCount;
+  const size_t start = (envelopePos + envelope.size() - size) % envelope.size();
+  auto at = [&](size_t i) { return envelope[(start + i) % envelope.size()]; };
+
+  double energy = 0.0;
+  for (size_t i = 0; i < size; ++i) {
+    energy += static_cast<double>(at(i)) * at(i);
+  }
+  if (energy <= 0.0) {
+    confidence = 0.0f;
+    return;
+  }
+
+  autocorrelation.assign(maxLag + 2, 0.0);
+  for (size_t lag = minLag - 1; lag <= maxLag + 1; ++lag) {
+    double sum = 0.0;
+    for (size_t i = lag; i < size; ++i) {
+      sum += static_cast<double>(at(i)) * at(i - lag);
+    }
+    autocorrelation[lag] = sum / (size - lag);
+  }
+
+  // Weight toward moderate tempos so half and double tempo lose ties
+  size_t bestLag = 0;
+  double bestScore = 0.0;
+  for (size_t lag = minLag; lag <= maxLag; ++lag) {
+    double lagBpm = 60.0 * hopsPerSecond / lag;
+    double octaves = std::log2(lagBpm / PREFERRED_BPM);
+    double score = autocorrelation[lag] * std::exp(-0.5 * octaves * octaves);
+    if (score > bestScore) {
+      bestScore = score;
+      bestLag = lag;
+    }
+  }
+  if (bestLag == 0) {
+    confidence = 0.0f;
+    return;
+  }
+
+  // Parabolic refinement for a fractional period
+  double left = autocorrelation[bestLag - 1];
+  double centre = autocorrelation[bestLag];
+  double right = autocorrelation[bestLag + 1];
+  double denominator = left - 2.0 * centre + right;
+  double offset = denominator < 0.0 ? 0.5 * (left - right) / denominator : 0.0;
+  double lag = static_cast<double>(bestLag) + std::max(-0.5, std::min(0.5, offset));
+
+  periodSamples = lag * stft.getHopSize();
+  bpm = static_cast<float>(60.0 * sampleRate / periodSamples);
+  confidence = static_cast<float>(centre / (energy / size));
+}
+
+void BeatDetector::trackBeats(bool onset, std::vector<BeatEvent> &events) {
+  if (confidence < MIN_CONFIDENCE || periodSamples <= 0.0) {
+    nextBeatSample = 0.0;
+    return;
+  }
+
+  const double now = static_cast<double>(stft.getPosition());
+  if (onset) {
+    const double onsetSample = static_cast<double>(lastOnsetSample);
+    if (nextBeatSample == 0.0) {
+      // Anchor the grid on the first onset once a tempo is known
+      nextBeatSample = onsetSample + periodSamples;
+    } else {
+      // Pull the nearest predicted beat toward the onset
+      double previous = nextBeatSample - periodSamples;
+      double error = onsetSample - nextBeatSample;
+      if (std::abs(onsetSample - previous) < std::abs(error)) {
+        error = onsetSample - previous;
+      }
+      if (std::abs(error) < PHASE_TOLERANCE * periodSamples) {
+        nextBeatSample += error * PHASE_CORRECTION;
+      }
+    }
+  }
+
+  while (nextBeatSample > 0.0 && nextBeatSample <= now) {
+    BeatEvent event;
+    event.type = BeatEvent::Type::Beat;
+    event.sample = static_cast<std::uint64_t>(nextBeatSample);
+    event.strength = confidence;
+    event.bpm = bpm;
+    events.push_back(event);
+    nextBeatSample += periodSamples;
+  }
+}
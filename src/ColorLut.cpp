@@ -0,0 +1,20 @@
+#include "ColorLut.h"
+#include "WaveformDrawer.h"
+
+ColorLut ColorLut::hsv(float saturation, float value) {
+  ColorLut lut;
+  for (size_t i = 0; i < SIZE; ++i) {
+    lut.colors[i] = hsvToRgb(static_cast<float>(i) / SIZE, saturation, value);
+  }
+  return lut;
+}
+
+const ColorLut &normalPassPalette() {
+  static const ColorLut palette = ColorLut::hsv(1.0f, 0.7f);
+  return palette;
+}
+
+const ColorLut &thickPassPalette() {
+  static const ColorLut palette = ColorLut::hsv(1.0f, 1.0f);
+  return palette;
+}
@@ -0,0 +1,58 @@
+#include "ConditioningThread.h"
+#include "PerfTimers.h"
+#include "ThreadConfig.h"
+#include "Tracer.h"
+#include <chrono>
+#include <utility>
+
+ConditioningThread::ConditioningThread(size_t windowSamples,
+                                       std::vector<double> &sharedBuffer,
+                                       std::mutex &bufferMutex,
+                                       std::condition_variable &bufferCV,
+                                       bool &bufferReady)
+    : sharedBuffer(sharedBuffer), bufferMutex(bufferMutex),
+      bufferCV(bufferCV), bufferReady(bufferReady), window(windowSamples),
+      conditioner(windowSamples) {
+  conditioningThread = std::thread(&ConditioningThread::conditionLoop, this);
+}
+
+ConditioningThread::~ConditioningThread() {
+  {
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    stopping = true;
+  }
+  bufferCV.notify_all();
+  if (conditioningThread.joinable()) {
+    conditioningThread.join();
+  }
+}
+
+void ConditioningThread::conditionLoop() {
+  trace::setThreadName("Conditioning");
+  std::uint64_t policyVersion = 0;
+  auto lastWindow = std::chrono::steady_clock::now();
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(bufferMutex);
+      bufferCV.wait(lock, [this] { return bufferReady || stopping; });
+      if (stopping) {
+        return;
+      }
+      std::swap(window, sharedBuffer);
+      bufferReady = false;
+    }
+
+    threading::refreshPolicy(ThreadRole::Analysis, policyVersion);
+
+    // The envelope advances by the time since the previous window
+    auto now = std::chrono::steady_clock::now();
+    float deltaTime = std::chrono::duration<float>(now - lastWindow).count();
+    lastWindow = now;
+
+    // Level analysis and gain in one pass, at a fixed frame length
+    TRACE_SCOPE("Conditioning");
+    perf::ScopedTimer timer(perf::Timer::Conditioning);
+    frames.writeBuffer() = conditioner.process(window, deltaTime);
+    frames.publish();
+  }
+}
@@ -3,6 +3,7 @@
 #include <sstream>
 #include <iostream>
 #include <filesystem>
+#include <system_error>
 #include <algorithm>
 
 namespace fs = std::filesystem;
@@ -11,7 +12,7 @@ namespace fs = std::filesystem;
 std::string VisualizerPreset::toJSON() const {
     std::ostringstream oss;
     oss << "{\n";
-    oss << "  \"name\": \"" << name << "\",\n";
+    oss << "  \"name\": \"" << json::escape(name) << "\",\n";
     oss << "  \"visualizerConfig\": " << visualizerConfig.toJSON(2) << ",\n";
     oss << "  \"shaderConfig\": " << shaderConfig.toJSON(2) << ",\n";
     oss << "  \"waveforms\": [\n";
@@ -24,53 +25,55 @@ std::string VisualizerPreset::toJSON() const {
         oss << "\n";
   }
     
-    oss << "  ]\n";
+    oss << "  ],\n";
+    oss << "  \"modulation\": " << modulation.toJSON(2) << "\n";
   oss << "}\n";
     return oss.str();
 }
 
-void VisualizerPreset::fromJSON(const std::string& json) {
-    // Parse name
-    name = ConfigSerializer::extractValue(json, "name");
-    
-    // Parse visualizer config
-    std::string vizConfigJson = ConfigSerializer::extractSection(json, "visualizerConfig");
-    visualizerConfig.fromJSON(vizConfigJson);
-    
-    // Parse shader config
-    std::string shaderConfigJson = ConfigSerializer::extractSection(json, "shaderConfig");
- shaderConfig.fromJSON(shaderConfigJson);
-    
-    // Parse waveforms array
-    waveforms.clear();
-    size_t waveformsStart = json.find("\"waveforms\"");
-    if (waveformsStart != std::string::npos) {
-        size_t arrayStart = json.find("[", waveformsStart);
-        size_t arrayEnd = json.rfind("]");
-        
-        if (arrayStart != std::string::npos && arrayEnd != std::string::npos) {
-      std::string arrayContent = json.substr(arrayStart + 1, arrayEnd - arrayStart - 1);
-            
-  // Parse each waveform object
-            int braceCount = 0;
-      size_t objStart = 0;
-      
-       for (size_t i = 0; i < arrayContent.length(); ++i) {
-           if (arrayContent[i] == '{') {
-     if (braceCount == 0) objStart = i;
-        braceCount++;
-                } else if (arrayContent[i] == '}') {
-         braceCount--;
-if (braceCount == 0) {
-      std::string waveJson = arrayContent.substr(objStart, i - objStart + 1);
-            WaveformConfig config;
-        config.fromJSON(waveJson);
-         waveforms.push_back(config);
+bool VisualizerPreset::fromJSON(std::string_view json, json::Error* error) {
+    json::Reader reader(json);
+    VisualizerPreset parsed;
+
+    if (reader.beginObject()) {
+        std::string_view key;
+        while (reader.nextKey(key)) {
+            bool ok;
+            if (key == "name") {
+                ok = reader.readString(parsed.name);
+            } else if (key == "visualizerConfig") {
+                ok = parsed.visualizerConfig.fromJSON(reader);
+            } else if (key == "shaderConfig") {
+                ok = parsed.shaderConfig.fromJSON(reader);
+            } else if (key == "modulation") {
+                ok = parsed.modulation.fromJSON(reader);
+            } else if (key == "waveforms") {
+                ok = reader.beginArray();
+                while (ok && reader.nextElement()) {
+                    WaveformConfig config;
+                    ok = config.fromJSON(reader);
+                    parsed.waveforms.push_back(config);
+                }
+                ok = ok && !reader.failed();
+            } else {
+                ok = reader.skipValue();
+            }
+
+            if (!ok) {
+                break;
+            }
         }
-   }
-   }
+    }
+
+    if (!reader.finish()) {
+        if (error) {
+            *error = reader.error();
         }
+        return false;
     }
+
+    *this = std::move(parsed);
+    return true;
 }
 
 // ConfigSerializer implementation
@@ -100,7 +103,12 @@ bool ConfigSerializer::loadPreset(const std::string& filepath, VisualizerPreset&
     std::string content = buffer.str();
     file.close();
 
-    preset.fromJSON(content);
+    json::Error error;
+    if (!preset.fromJSON(content, &error)) {
+        std::cerr << "Failed to parse preset " << filepath << " at byte "
+                  << error.offset << ": " << error.message << std::endl;
+        return false;
+    }
     
     std::cout << "Preset loaded from: " << filepath << std::endl;
     return true;
@@ -108,60 +116,28 @@ bool ConfigSerializer::loadPreset(const std::string& filepath, VisualizerPreset&
 
 std::vector<std::string> ConfigSerializer::getAvailablePresets(const std::string& directory) {
     std::vector<std::string> presets;
-    
-    if (!fs::exists(directory)) {
-        fs::create_directory(directory);
+    std::error_code error;
+
+    // An unreadable directory lists no presets rather than throwing
+    if (!fs::exists(directory, error)) {
+        if (!error) {
+            fs::create_directory(directory, error);
+        }
         return presets;
     }
 
-  for (const auto& entry : fs::directory_iterator(directory)) {
-     if (entry.is_regular_file() && entry.path().extension() == ".json") {
-            presets.push_back(entry.path().filename().string());
-     }
- }
+    fs::directory_iterator it(directory, error);
+    for (; !error && it != fs::directory_iterator(); it.increment(error)) {
+        if (it->is_regular_file(error) && it->path().extension() == ".json") {
+            presets.push_back(it->path().filename().string());
+        }
+    }
+    if (error) {
+        std::cerr << "Failed to list presets in " << directory << ": "
+                  << error.message() << std::endl;
+        return {};
+    }
 
     std::sort(presets.begin(), presets.end());
     return presets;
 }
-
-std::string ConfigSerializer::extractValue(const std::string& content, const std::string& key) {
-    std::string searchKey = "\"" + key + "\":";
-    size_t pos = content.find(searchKey);
-    if (pos == std::string::npos) return "";
-
-    pos += searchKey.length();
-    size_t endPos = content.find_first_of(",\n}", pos);
-    if (endPos == std::string::npos) return "";
-
-    std::string value = content.substr(pos, endPos - pos);
-    
-    // Trim whitespace and quotes
-    size_t first = value.find_first_not_of(" \t\n\r\"");
-    if (first == std::string::npos) return "";
-    size_t last = value.find_last_not_of(" \t\n\r\",\"");
-    return value.substr(first, last - first + 1);
-}
-
-std::string ConfigSerializer::extractSection(const std::string& content, const std::string& key) {
-    std::string searchKey = "\"" + key + "\":";
-    size_t pos = content.find(searchKey);
-    if (pos == std::string::npos) return "";
-    
-    size_t start = content.find("{", pos);
-    if (start == std::string::npos) return "";
-    
-    // Find matching closing brace
-    int braceCount = 1;
-  size_t end = start + 1;
- while (end < content.length() && braceCount > 0) {
-        if (content[end] == '{') braceCount++;
-        else if (content[end] == '}') braceCount--;
-        end++;
-  }
-    
-    if (braceCount == 0) {
-        return content.substr(start, end - start);
-    }
-    
-    return "";
-}
@@ -0,0 +1,235 @@
+#include "DirectoryWatcher.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+#if defined(_WIN32)
+
+// Overlapped ReadDirectoryChangesW on the directory handle
+class Win32DirectoryWatcher : public DirectoryWatcher {
+public:
+  ~Win32DirectoryWatcher() override {
+    if (directory != INVALID_HANDLE_VALUE) {
+      CancelIoEx(directory, &overlapped);
+      DWORD ignored = 0;
+      GetOverlappedResult(directory, &overlapped, &ignored, TRUE);
+      CloseHandle(directory);
+    }
+    if (overlapped.hEvent) {
+      CloseHandle(overlapped.hEvent);
+    }
+  }
+
+  bool open(const std::string &path) {
+    directory = CreateFileW(
+        fs::path(path).wstring().c_str(), FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+        nullptr);
+    if (directory == INVALID_HANDLE_VALUE) {
+      return false;
+    }
+
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    return overlapped.hEvent && issueRead();
+  }
+
+  bool waitForChanges(std::vector<FileChange> &changes,
+                      int timeoutMs) override {
+    DWORD result = WaitForSingleObject(overlapped.hEvent,
+                                       static_cast<DWORD>(timeoutMs));
+    if (result == WAIT_TIMEOUT) {
+      return true;
+    }
+    if (result != WAIT_OBJECT_0) {
+      return false;
+    }
+
+    DWORD bytes = 0;
+    if (!GetOverlappedResult(directory, &overlapped, &bytes, FALSE)) {
+      return false;
+    }
+
+    if (bytes == 0) {
+      // The notification buffer overflowed; changes were lost
+      changes.push_back({FileChange::Type::Overflow, std::string()});
+    } else {
+      const BYTE *cursor = buffer;
+      while (true) {
+        const auto *info =
+            reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(cursor);
+        std::wstring name(info->FileName,
+                          info->FileNameLength / sizeof(wchar_t));
+        bool removed = info->Action == FILE_ACTION_REMOVED ||
+                       info->Action == FILE_ACTION_RENAMED_OLD_NAME;
+        changes.push_back({removed ? FileChange::Type::Removed
+                                   : FileChange::Type::Modified,
+                           fs::path(name).string()});
+
+        if (info->NextEntryOffset == 0) {
+          break;
+        }
+        cursor += info->NextEntryOffset;
+      }
+    }
+
+    return issueRead();
+  }
+
+private:
+  bool issueRead() {
+    return ReadDirectoryChangesW(
+               directory, buffer, sizeof(buffer), FALSE,
+               FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE,
+               nullptr, &overlapped, nullptr) != 0;
+  }
+
+  HANDLE directory = INVALID_HANDLE_VALUE;
+  OVERLAPPED overlapped = {};
+  alignas(DWORD) BYTE buffer[64 * 1024];
+};
+
+#elif defined(__linux__)
+
+// inotify watch on the directory; only completed writes and renames are
+// reported so half-written files are never picked up
+class InotifyDirectoryWatcher : public DirectoryWatcher {
+public:
+  ~InotifyDirectoryWatcher() override {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+
+  bool open(const std::string &path) {
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+      return false;
+    }
+    return inotify_add_watch(fd, path.c_str(),
+                             IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM |
+                                 IN_DELETE) >= 0;
+  }
+
+  bool waitForChanges(std::vector<FileChange> &changes,
+                      int timeoutMs) override {
+    pollfd descriptor = {fd, POLLIN, 0};
+    int ready = poll(&descriptor, 1, timeoutMs);
+    if (ready <= 0) {
+      return ready == 0;
+    }
+
+    alignas(inotify_event) char buffer[16 * 1024];
+    while (true) {
+      ssize_t length = read(fd, buffer, sizeof(buffer));
+      if (length <= 0) {
+        break;
+      }
+
+      for (char *cursor = buffer; cursor < buffer + length;) {
+        const auto *event = reinterpret_cast<const inotify_event *>(cursor);
+        cursor += sizeof(inotify_event) + event->len;
+
+        if (event->mask & IN_Q_OVERFLOW) {
+          changes.push_back({FileChange::Type::Overflow, std::string()});
+        } else if (event->mask & IN_IGNORED) {
+          return false; // The directory itself went away
+        } else if (event->len > 0) {
+          bool removed = event->mask & (IN_DELETE | IN_MOVED_FROM);
+          changes.push_back({removed ? FileChange::Type::Removed
+                                     : FileChange::Type::Modified,
+                             std::string(event->name)});
+        }
+      }
+    }
+    return true;
+  }
+
+private:
+  int fd = -1;
+};
+
+#endif
+
+// Fallback that compares modification times on every wait. Each call costs
+// a scan of the directory, which for a presets folder is a few stats.
+class PollingDirectoryWatcher : public DirectoryWatcher {
+public:
+  explicit PollingDirectoryWatcher(const std::string &path) : path(path) {
+    std::vector<FileChange> ignored;
+    scan(ignored);
+  }
+
+  bool waitForChanges(std::vector<FileChange> &changes,
+                      int timeoutMs) override {
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+    scan(changes);
+    return true;
+  }
+
+private:
+  void scan(std::vector<FileChange> &changes) {
+    std::unordered_map<std::string, fs::file_time_type> current;
+    std::error_code ec;
+    for (const auto &entry : fs::directory_iterator(path, ec)) {
+      if (!entry.is_regular_file(ec)) {
+        continue;
+      }
+      std::string name = entry.path().filename().string();
+      fs::file_time_type time = entry.last_write_time(ec);
+      auto previous = known.find(name);
+      if (previous == known.end() || previous->second != time) {
+        changes.push_back({FileChange::Type::Modified, name});
+      }
+      current.emplace(std::move(name), time);
+    }
+
+    for (const auto &entry : known) {
+      if (current.find(entry.first) == current.end()) {
+        changes.push_back({FileChange::Type::Removed, entry.first});
+      }
+    }
+    known = std::move(current);
+  }
+
+  std::string path;
+  std::unordered_map<std::string, fs::file_time_type> known;
+};
+
+} // namespace
+
+std::unique_ptr<DirectoryWatcher>
+DirectoryWatcher::create(const std::string &directory) {
+#if defined(_WIN32)
+  auto watcher = std::make_unique<Win32DirectoryWatcher>();
+#elif defined(__linux__)
+  auto watcher = std::make_unique<InotifyDirectoryWatcher>();
+#endif
+
+#if defined(_WIN32) || defined(__linux__)
+  if (watcher->open(directory)) {
+    return watcher;
+  }
+  std::cerr << "Native file watching unavailable for " << directory
+            << ", falling back to polling" << std::endl;
+#endif
+
+  return std::make_unique<PollingDirectoryWatcher>(directory);
+}
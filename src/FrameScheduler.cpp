@@ -0,0 +1,163 @@
+#include "FrameScheduler.h"
+#include <algorithm>
+#include <cmath>
+
+using Clock = std::chrono::steady_clock;
+
+// Weight of the newest sample in the running cost and rate averages
+static constexpr float STATS_SMOOTHING = 0.05f;
+
+// A present that returns sooner than this did not wait for a refresh, as
+// without vsync or with a driver that queues frames ahead
+static constexpr float MIN_REFRESH_WAIT_MS = 0.25f;
+
+// Growth per run of the estimated display period, so a move to a slower
+// display is picked up
+static constexpr float DISPLAY_PERIOD_CREEP = 1.001f;
+
+// Time left between finishing a presented stage and the refresh it aims for
+static constexpr double PRESENT_MARGIN_SECONDS = 0.0015;
+
+static Clock::duration periodFor(float rateHz) {
+  if (rateHz <= 0.0f) {
+    return Clock::duration::zero();
+  }
+  return std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / rateHz));
+}
+
+size_t FrameScheduler::addStage(const std::string &name, float rateHz,
+                                float budgetMs, StageFunction run) {
+  Stage stage;
+  stage.name = name;
+  stage.rateHz = rateHz;
+  stage.budgetMs = budgetMs;
+  stage.run = std::move(run);
+  stage.lastRun = Clock::now();
+  stage.nextDue = stage.lastRun;
+  stages.push_back(std::move(stage));
+  return stages.size() - 1;
+}
+
+void FrameScheduler::setRate(size_t index, float rateHz) {
+  Stage &stage = stages[index];
+  stage.rateHz = rateHz;
+  stage.nextDue = std::min(stage.nextDue, Clock::now() + periodFor(rateHz));
+}
+
+void FrameScheduler::runDueStages() {
+  for (Stage &stage : stages) {
+    Clock::time_point start = Clock::now();
+    if (start < stage.nextDue) {
+      continue;
+    }
+
+    float lateMs =
+        std::chrono::duration<float, std::milli>(start - stage.nextDue).count();
+    stage.meanLateMs =
+        stage.runs == 0
+            ? lateMs
+            : stage.meanLateMs + (lateMs - stage.meanLateMs) * STATS_SMOOTHING;
+
+    float deltaTime =
+        std::chrono::duration<float>(start - stage.lastRun).count();
+    stage.run(deltaTime);
+    Clock::time_point end = Clock::now();
+
+    float costMs = std::chrono::duration<float, std::milli>(end - start).count();
+    stage.lastMs = costMs;
+    busyMs += costMs;
+    stage.meanMs = stage.runs == 0
+                       ? costMs
+                       : stage.meanMs + (costMs - stage.meanMs) * STATS_SMOOTHING;
+    // The first interval only measures startup
+    if (stage.runs == 1) {
+      stage.meanInterval = deltaTime;
+    } else if (stage.runs > 1) {
+      stage.meanInterval += (deltaTime - stage.meanInterval) * STATS_SMOOTHING;
+    }
+    stage.measuredHz = stage.meanInterval > 0.0f ? 1.0f / stage.meanInterval
+                                                 : 0.0f;
+    if (stage.budgetMs > 0.0f && costMs > stage.budgetMs) {
+      ++stage.overruns;
+    }
+    ++stage.runs;
+    stage.lastRun = start;
+
+    if (stage.present && schedulePresented(stage)) {
+      continue;
+    }
+
+    // Keep to the rate's grid; after a stall skip the missed runs rather
+    // than bursting through them
+    Clock::duration period = periodFor(stage.rateHz);
+    stage.nextDue += period;
+    if (stage.nextDue <= end) {
+      if (period > Clock::duration::zero()) {
+        stage.missed += static_cast<std::uint64_t>((end - stage.nextDue) / period);
+      }
+      stage.nextDue = end + period;
+    }
+  }
+}
+
+bool FrameScheduler::schedulePresented(Stage &stage) {
+  Clock::time_point waitStart = Clock::now();
+  stage.present();
+  Clock::time_point refresh = Clock::now();
+  if (std::chrono::duration<float, std::milli>(refresh - waitStart).count() <
+      MIN_REFRESH_WAIT_MS) {
+    stage.displayPeriod = 0.0f;
+    stage.lastRefresh = Clock::time_point();
+    return false;
+  }
+
+  // Refreshes come a whole number of display periods apart, so the
+  // shortest recent interval between them is the period
+  if (stage.lastRefresh != Clock::time_point()) {
+    float interval =
+        std::chrono::duration<float>(refresh - stage.lastRefresh).count();
+    stage.displayPeriod =
+        stage.displayPeriod > 0.0f
+            ? std::min(interval, stage.displayPeriod * DISPLAY_PERIOD_CREEP)
+            : interval;
+  }
+  stage.lastRefresh = refresh;
+  if (stage.displayPeriod <= 0.0f) {
+    stage.nextDue = refresh;
+    return true;
+  }
+
+  // Aim for the refresh nearest the stage's period, or the next one when
+  // it runs on every pass
+  const double displayPeriod = stage.displayPeriod;
+  double refreshes = 1.0;
+  if (stage.rateHz > 0.0f) {
+    refreshes = std::max(1.0, std::round(1.0 / (stage.rateHz * displayPeriod)));
+  }
+  double lead = std::min(displayPeriod * 0.75,
+                         stage.meanMs / 1000.0 + PRESENT_MARGIN_SECONDS);
+  stage.nextDue = refresh + std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double>(
+                                    refreshes * displayPeriod - lead));
+  return true;
+}
+
+float FrameScheduler::secondsUntilNextStage() const {
+  if (stages.empty()) {
+    return 0.0f;
+  }
+
+  Clock::time_point next = stages.front().nextDue;
+  for (const Stage &stage : stages) {
+    next = std::min(next, stage.nextDue);
+  }
+  return std::max(0.0f,
+                  std::chrono::duration<float>(next - Clock::now()).count());
+}
+
+float FrameScheduler::takeBusyMs() {
+  float result = busyMs;
+  busyMs = 0.0f;
+  return result;
+}
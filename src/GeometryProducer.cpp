@@ -0,0 +1,102 @@
+#include "GeometryProducer.h"
+#include "PerfTimers.h"
+#include "ThreadConfig.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <utility>
+
+GeometryProducer::GeometryProducer() {
+  producerThread = std::thread(&GeometryProducer::produceLoop, this);
+}
+
+GeometryProducer::~GeometryProducer() {
+  stop();
+  if (producerThread.joinable()) {
+    producerThread.join();
+  }
+}
+
+void GeometryProducer::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    running = false;
+  }
+  jobReady.notify_one();
+}
+
+void GeometryProducer::submit(GeometryJob &job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::swap(pending, job);
+    hasPending = true;
+  }
+  jobReady.notify_one();
+}
+
+void GeometryProducer::produceLoop() {
+  trace::setThreadName("Geometry Producer");
+  std::uint64_t policyVersion = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      jobReady.wait(lock, [this] { return hasPending || !running; });
+      if (!running) {
+        exited.store(true, std::memory_order_release);
+        return;
+      }
+      std::swap(working, pending);
+      hasPending = false;
+    }
+
+    threading::refreshPolicy(ThreadRole::Geometry, policyVersion);
+    TRACE_SCOPE("Produce geometry");
+    perf::ScopedTimer timer(perf::Timer::GeometryBuild);
+
+    // Capacity is kept from earlier frames, so this rarely reallocates
+    std::vector<sf::Vertex> &vertices = frames.writeBuffer();
+    vertices.resize(working.vertexCount);
+    buildCpuGeometry(working.configs, working.rotationAngles, working.ranges,
+                     working.samples, working.globalHue, working.width,
+                     working.height, working.opacity, working.radiusScale,
+                     working.quality, vertices);
+    frames.publish();
+  }
+}
+
+GeometryProducerSlot &
+GeometryProducerSlot::operator=(GeometryProducerSlot &&other) {
+  if (this != &other) {
+    retire();
+    for (std::unique_ptr<GeometryProducer> &producer : other.retired) {
+      retired.push_back(std::move(producer));
+    }
+    other.retired.clear();
+    current = std::move(other.current);
+  }
+  return *this;
+}
+
+GeometryProducer &GeometryProducerSlot::acquire() {
+  pruneRetired();
+  if (!current) {
+    current = std::make_unique<GeometryProducer>();
+  }
+  return *current;
+}
+
+void GeometryProducerSlot::retire() {
+  pruneRetired();
+  if (current) {
+    current->stop();
+    retired.push_back(std::move(current));
+  }
+}
+
+void GeometryProducerSlot::pruneRetired() {
+  // Producers whose thread has exited join without waiting
+  retired.erase(std::remove_if(retired.begin(), retired.end(),
+                               [](const std::unique_ptr<GeometryProducer> &p) {
+                                 return p->finished();
+                               }),
+                retired.end());
+}
@@ -0,0 +1,118 @@
+#include "GpuTimer.h"
+#include <SFML/Graphics.hpp>
+#include <SFML/OpenGL.hpp>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+// ARB_timer_query; core since OpenGL 3.3 but absent from the 1.1 headers
+static constexpr GLenum TIME_ELAPSED = 0x88BF;
+static constexpr GLenum QUERY_RESULT = 0x8866;
+static constexpr GLenum QUERY_RESULT_AVAILABLE = 0x8867;
+
+namespace {
+
+struct TimerQueryFunctions {
+  using GenQueries = void(APIENTRY *)(GLsizei, GLuint *);
+  using BeginQuery = void(APIENTRY *)(GLenum, GLuint);
+  using EndQuery = void(APIENTRY *)(GLenum);
+  using GetQueryObjectiv = void(APIENTRY *)(GLuint, GLenum, GLint *);
+  using GetQueryObjectui64v = void(APIENTRY *)(GLuint, GLenum,
+                                               unsigned long long *);
+
+  GenQueries genQueries = nullptr;
+  BeginQuery beginQuery = nullptr;
+  EndQuery endQuery = nullptr;
+  GetQueryObjectiv getQueryObjectiv = nullptr;
+  GetQueryObjectui64v getQueryObjectui64v = nullptr;
+  bool loaded = false;
+};
+
+const TimerQueryFunctions &timerQueries() {
+  static const TimerQueryFunctions functions = [] {
+    TimerQueryFunctions f;
+    if (!sf::Context::isExtensionAvailable("GL_ARB_timer_query")) {
+      return f;
+    }
+    f.genQueries = reinterpret_cast<TimerQueryFunctions::GenQueries>(
+        sf::Context::getFunction("glGenQueries"));
+    f.beginQuery = reinterpret_cast<TimerQueryFunctions::BeginQuery>(
+        sf::Context::getFunction("glBeginQuery"));
+    f.endQuery = reinterpret_cast<TimerQueryFunctions::EndQuery>(
+        sf::Context::getFunction("glEndQuery"));
+    f.getQueryObjectiv =
+        reinterpret_cast<TimerQueryFunctions::GetQueryObjectiv>(
+            sf::Context::getFunction("glGetQueryObjectiv"));
+    f.getQueryObjectui64v =
+        reinterpret_cast<TimerQueryFunctions::GetQueryObjectui64v>(
+            sf::Context::getFunction("glGetQueryObjectui64v"));
+    f.loaded = f.genQueries && f.beginQuery && f.endQuery &&
+               f.getQueryObjectiv && f.getQueryObjectui64v;
+    return f;
+  }();
+  return functions;
+}
+
+} // namespace
+
+bool GpuTimer::isAvailable() { return timerQueries().loaded; }
+
+void GpuTimer::begin() {
+  if (running || !isAvailable()) {
+    return;
+  }
+  const TimerQueryFunctions &gl = timerQueries();
+  if (!created) {
+    gl.genQueries(static_cast<GLsizei>(QUERY_COUNT), queries.data());
+    created = true;
+  }
+
+  collect();
+
+  // All queries still in flight; drop this measurement
+  if (pending[next]) {
+    return;
+  }
+  gl.beginQuery(TIME_ELAPSED, queries[next]);
+  running = true;
+}
+
+void GpuTimer::end() {
+  if (!running) {
+    return;
+  }
+  timerQueries().endQuery(TIME_ELAPSED);
+  pending[next] = true;
+  next = (next + 1) % QUERY_COUNT;
+  running = false;
+}
+
+void GpuTimer::collect() {
+  const TimerQueryFunctions &gl = timerQueries();
+
+  // Oldest first, stopping at the first result the GPU has not finished
+  for (size_t i = 0; i < QUERY_COUNT; ++i) {
+    size_t slot = (next + i) % QUERY_COUNT;
+    if (!pending[slot]) {
+      continue;
+    }
+    GLint available = 0;
+    gl.getQueryObjectiv(queries[slot], QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+      break;
+    }
+    unsigned long long nanoseconds = 0;
+    gl.getQueryObjectui64v(queries[slot], QUERY_RESULT, &nanoseconds);
+    histogram.record(static_cast<float>(nanoseconds) / 1.0e6f);
+    pending[slot] = false;
+  }
+}
+
+void GpuTimer::abandon() {
+  // The names died with their context, so there is nothing to delete
+  pending.fill(false);
+  next = 0;
+  created = false;
+  running = false;
+}
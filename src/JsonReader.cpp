@@ -0,0 +1,293 @@
+#include "JsonReader.h"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+
+namespace json {
+
+void Reader::skipWhitespace() {
+  while (pos < input.size()) {
+    char c = input[pos];
+    if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+      break;
+    }
+    ++pos;
+  }
+}
+
+bool Reader::fail(const char *message) {
+  if (!hasError) {
+    hasError = true;
+    err.offset = pos;
+    err.message = message;
+  }
+  return false;
+}
+
+bool Reader::expect(char c) {
+  if (hasError) {
+    return false;
+  }
+  skipWhitespace();
+  if (pos >= input.size() || input[pos] != c) {
+    char message[32];
+    std::snprintf(message, sizeof(message), "expected '%c'", c);
+    return fail(message);
+  }
+  ++pos;
+  return true;
+}
+
+bool Reader::beginObject() {
+  if (!expect('{')) {
+    return false;
+  }
+  if (++depth > MAX_DEPTH) {
+    return fail("nesting too deep");
+  }
+  firstMember = true;
+  return true;
+}
+
+bool Reader::nextKey(std::string_view &key) {
+  if (hasError) {
+    return false;
+  }
+
+  skipWhitespace();
+  if (pos < input.size() && input[pos] == '}') {
+    ++pos;
+    --depth;
+    firstMember = false;
+    return false;
+  }
+
+  if (!firstMember && !expect(',')) {
+    return false;
+  }
+
+  skipWhitespace();
+  firstMember = false;
+  return readRawString(key) && expect(':');
+}
+
+bool Reader::beginArray() {
+  if (!expect('[')) {
+    return false;
+  }
+  if (++depth > MAX_DEPTH) {
+    return fail("nesting too deep");
+  }
+  firstMember = true;
+  return true;
+}
+
+bool Reader::nextElement() {
+  if (hasError) {
+    return false;
+  }
+
+  skipWhitespace();
+  if (pos < input.size() && input[pos] == ']') {
+    ++pos;
+    --depth;
+    firstMember = false;
+    return false;
+  }
+
+  if (!firstMember && !expect(',')) {
+    return false;
+  }
+
+  firstMember = false;
+  return true;
+}
+
+bool Reader::readNumber(double &value) {
+  if (hasError) {
+    return false;
+  }
+
+  skipWhitespace();
+  const char *begin = input.data() + pos;
+  const char *end = input.data() + input.size();
+  if (begin == end || (*begin != '-' && (*begin < '0' || *begin > '9'))) {
+    return fail("expected number");
+  }
+
+  // from_chars also takes "-inf" and "-nan", which are not JSON
+  auto result = std::from_chars(begin, end, value);
+  if (result.ec != std::errc() || !std::isfinite(value)) {
+    return fail("invalid number");
+  }
+  pos += static_cast<size_t>(result.ptr - begin);
+  return true;
+}
+
+bool Reader::readBool(bool &value) {
+  if (hasError) {
+    return false;
+  }
+
+  skipWhitespace();
+  std::string_view rest = input.substr(pos);
+  if (rest.substr(0, 4) == "true") {
+    value = true;
+    pos += 4;
+  } else if (rest.substr(0, 5) == "false") {
+    value = false;
+    pos += 5;
+  } else {
+    return fail("expected true or false");
+  }
+  return true;
+}
+
+bool Reader::readRawString(std::string_view &raw) {
+  if (hasError) {
+    return false;
+  }
+
+  if (pos >= input.size() || input[pos] != '"') {
+    return fail("expected string");
+  }
+
+  size_t start = ++pos;
+  while (pos < input.size()) {
+    char c = input[pos];
+    if (c == '"') {
+      raw = input.substr(start, pos - start);
+      ++pos;
+      return true;
+    }
+    if (static_cast<unsigned char>(c) < 0x20) {
+      return fail("control character in string");
+    }
+    pos += (c == '\\') ? 2 : 1;
+  }
+
+  return fail("unterminated string");
+}
+
+bool Reader::readString(std::string &value) {
+  skipWhitespace();
+  size_t start = pos;
+  std::string_view raw;
+  if (!readRawString(raw)) {
+    return false;
+  }
+
+  value.clear();
+  value.reserve(raw.size());
+  for (size_t i = 0; i < raw.size(); ++i) {
+    if (raw[i] != '\\') {
+      value += raw[i];
+      continue;
+    }
+
+    switch (raw[++i]) {
+    case 'n': value += '\n'; break;
+    case 't': value += '\t'; break;
+    case 'r': value += '\r'; break;
+    case 'b': value += '\b'; break;
+    case 'f': value += '\f'; break;
+    case '"':
+    case '\\':
+    case '/':
+      value += raw[i];
+      break;
+    default:
+      // \uXXXX is not used by our files; report it rather than guess
+      pos = start + 1 + i;
+      return fail("unsupported escape sequence");
+    }
+  }
+  return true;
+}
+
+bool Reader::skipValue() {
+  if (hasError) {
+    return false;
+  }
+
+  skipWhitespace();
+  if (pos >= input.size()) {
+    return fail("unexpected end of input");
+  }
+
+  switch (input[pos]) {
+  case '{': {
+    if (!beginObject()) {
+      return false;
+    }
+    std::string_view key;
+    while (nextKey(key)) {
+      if (!skipValue()) {
+        return false;
+      }
+    }
+    return !hasError;
+  }
+  case '[':
+    if (!beginArray()) {
+      return false;
+    }
+    while (nextElement()) {
+      if (!skipValue()) {
+        return false;
+      }
+    }
+    return !hasError;
+  case '"': {
+    std::string_view raw;
+    return readRawString(raw);
+  }
+  case 't':
+  case 'f': {
+    bool ignored;
+    return readBool(ignored);
+  }
+  case 'n':
+    if (input.substr(pos, 4) == "null") {
+      pos += 4;
+      return true;
+    }
+    return fail("invalid literal");
+  default: {
+    double ignored;
+    return readNumber(ignored);
+  }
+  }
+}
+
+bool Reader::finish() {
+  if (hasError) {
+    return false;
+  }
+  skipWhitespace();
+  if (pos != input.size()) {
+    return fail("unexpected data after document");
+  }
+  return true;
+}
+
+std::string escape(std::string_view value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+  for (char c : value) {
+    switch (c) {
+    case '"': escaped += "\\\""; break;
+    case '\\': escaped += "\\\\"; break;
+    case '\n': escaped += "\\n"; break;
+    case '\t': escaped += "\\t"; break;
+    case '\r': escaped += "\\r"; break;
+    default:
+      if (static_cast<unsigned char>(c) >= 0x20) {
+        escaped += c;
+      }
+    }
+  }
+  return escaped;
+}
+
+} // namespace json
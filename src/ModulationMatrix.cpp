@@ -0,0 +1,468 @@
+#include "ModulationMatrix.h"
+#include "JsonReader.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <sstream>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Sources before the bands in the source vector
+static constexpr size_t SCALAR_SOURCE_COUNT =
+    static_cast<size_t>(ModSource::Band);
+static constexpr size_t CURVE_COUNT = static_cast<size_t>(ModCurve::Count);
+
+// Levels are mapped onto [0, 1] over this many dB below full scale, as the
+// bands are
+static constexpr float LEVEL_RANGE_DB = 60.0f;
+
+// Ranges match the UI sliders
+static constexpr ModTargetInfo TARGETS[] = {
+    {"Height", 0.0f, 500.0f},
+    {"Rotation Speed", -2.0f, 2.0f},
+    {"Radius", 0.0f, 2.0f},
+    {"Thickness", 1.0f, 30.0f},
+    {"Hue Offset", 0.0f, 1.0f},
+    {"Alpha", 0.0f, 255.0f},
+    {"Thick Alpha", 0.0f, 255.0f},
+    {"Fade", 0.0f, 1.0f},
+    {"Pixel Size", 1.0f, 100.0f},
+    {"Blend Factor", 0.0f, 1.0f},
+    {"Fade Threshold", 0.0f, 0.1f},
+    {"Saturation Boost", 1.0f, 2.0f},
+    {"Dither Strength", 0.0f, 0.05f},
+};
+static_assert(std::size(TARGETS) == static_cast<size_t>(ModTarget::Count),
+              "Every target needs a range");
+
+static constexpr const char *SOURCE_NAMES[] = {
+    "RMS",   "Peak",  "Beat Phase", "Beat Pulse", "LFO 1",
+    "LFO 2", "LFO 3", "LFO 4",      "Band"};
+static_assert(std::size(SOURCE_NAMES) == static_cast<size_t>(ModSource::Count),
+              "Every source needs a name");
+
+static constexpr const char *CURVE_NAMES[] = {"Linear", "Square", "Square Root",
+                                              "Smooth"};
+static_assert(std::size(CURVE_NAMES) == CURVE_COUNT,
+              "Every curve needs a name");
+
+const ModTargetInfo &targetInfo(ModTarget target) {
+  return TARGETS[static_cast<size_t>(target)];
+}
+
+const char *sourceName(ModSource source) {
+  return SOURCE_NAMES[static_cast<size_t>(source)];
+}
+
+const char *curveName(ModCurve curve) {
+  return CURVE_NAMES[static_cast<size_t>(curve)];
+}
+
+template <typename E> static E toEnum(int value, E fallback) {
+  if (value < 0 || value >= static_cast<int>(E::Count)) {
+    return fallback;
+  }
+  return static_cast<E>(value);
+}
+
+ModSource ModulationRoute::getSource() const {
+  return toEnum(source, ModSource::Rms);
+}
+
+ModCurve ModulationRoute::getCurve() const {
+  return toEnum(curve, ModCurve::Linear);
+}
+
+ModTarget ModulationRoute::getTarget() const {
+  return toEnum(target, ModTarget::DisplayHeight);
+}
+
+std::string ModulationRoute::toJSON(int indent) const {
+  std::string indentStr(indent, ' ');
+  std::ostringstream oss;
+  oss << indentStr << "{\"source\": " << source << ", \"band\": " << band
+      << ", \"curve\": " << curve << ", \"target\": " << target
+      << ", \"waveform\": " << waveform << ", \"depth\": " << json::number(depth)
+      << ", \"enabled\": " << (enabled ? "true" : "false") << "}";
+  return oss.str();
+}
+
+// Keys dispatched to members in a single pass over the object
+static constexpr json::Field<ModulationRoute> kRouteFields[] = {
+    {"source", &ModulationRoute::source},
+    {"band", &ModulationRoute::band},
+    {"curve", &ModulationRoute::curve},
+    {"target", &ModulationRoute::target},
+    {"waveform", &ModulationRoute::waveform},
+    {"depth", &ModulationRoute::depth},
+    {"enabled", &ModulationRoute::enabled},
+};
+
+bool ModulationRoute::fromJSON(json::Reader &reader) {
+  return json::readObject(reader, *this, kRouteFields);
+}
+
+std::string ModulationSettings::toJSON(int indent) const {
+  std::string indentStr(indent, ' ');
+  std::ostringstream oss;
+  oss << indentStr << "{\n";
+  oss << indentStr << "  \"lfoRates\": [";
+  for (size_t i = 0; i < LFO_COUNT; ++i) {
+    oss << (i > 0 ? ", " : "") << json::number(lfoRates[i]);
+  }
+  oss << "],\n";
+  oss << indentStr << "  \"routes\": [\n";
+  for (size_t i = 0; i < routes.size(); ++i) {
+    oss << routes[i].toJSON(indent + 4);
+    if (i < routes.size() - 1) {
+      oss << ",";
+    }
+    oss << "\n";
+  }
+  oss << indentStr << "  ]\n";
+  oss << indentStr << "}";
+  return oss.str();
+}
+
+bool ModulationSettings::fromJSON(json::Reader &reader) {
+  if (!reader.beginObject()) {
+    return false;
+  }
+
+  std::string_view key;
+  while (reader.nextKey(key)) {
+    bool ok;
+    if (key == "lfoRates") {
+      ok = reader.beginArray();
+      for (size_t i = 0; ok && reader.nextElement(); ++i) {
+        double rate = 0.0;
+        ok = reader.readNumber(rate);
+        if (i < LFO_COUNT) {
+          lfoRates[i] = static_cast<float>(rate);
+        }
+      }
+      ok = ok && !reader.failed();
+    } else if (key == "routes") {
+      ok = reader.beginArray();
+      while (ok && reader.nextElement()) {
+        ModulationRoute route;
+        ok = route.fromJSON(reader);
+        routes.push_back(route);
+      }
+      ok = ok && !reader.failed();
+    } else {
+      ok = reader.skipValue();
+    }
+
+    if (!ok) {
+      return false;
+    }
+  }
+  return !reader.failed();
+}
+
+// Level in [0, 1] on the same dB scale as the bands
+static float levelToUnit(float level) {
+  if (level <= 0.0f) {
+    return 0.0f;
+  }
+  float db = 20.0f * std::log10(level);
+  return std::clamp(1.0f + db / LEVEL_RANGE_DB, 0.0f, 1.0f);
+}
+
+static float shape(ModCurve curve, float value) {
+  switch (curve) {
+  case ModCurve::Square:
+    return value * value;
+  case ModCurve::SquareRoot:
+    return std::sqrt(value);
+  case ModCurve::Smooth:
+    return value * value * (3.0f - 2.0f * value);
+  case ModCurve::Linear:
+  default:
+    return value;
+  }
+}
+
+void ModulationMatrix::setSettings(const ModulationSettings &newSettings) {
+  settings = newSettings;
+  dirty = true;
+}
+
+void ModulationMatrix::removeWaveform(size_t index) {
+  const int removed = static_cast<int>(index);
+  auto &routes = settings.routes;
+  routes.erase(std::remove_if(routes.begin(), routes.end(),
+                              [removed](const ModulationRoute &route) {
+                                return !route.isShaderTarget() &&
+                                       route.waveform == removed;
+                              }),
+               routes.end());
+  for (ModulationRoute &route : routes) {
+    if (!route.isShaderTarget() && route.waveform > removed) {
+      --route.waveform;
+    }
+  }
+  dirty = true;
+}
+
+bool ModulationMatrix::usesBands() const {
+  return std::any_of(settings.routes.begin(), settings.routes.end(),
+                     [](const ModulationRoute &route) {
+                       return route.enabled &&
+                              route.getSource() == ModSource::Band;
+                     });
+}
+
+void ModulationMatrix::compile(size_t waveformCount, size_t bandCount) {
+  const size_t sourceCount = SCALAR_SOURCE_COUNT + bandCount;
+  const size_t shaderBase = waveformCount * WAVEFORM_TARGET_COUNT;
+
+  struct Compiled {
+    std::uint32_t source;
+    std::uint32_t destination;
+    float depth;
+  };
+  std::vector<Compiled> compiled;
+  compiled.reserve(settings.routes.size());
+
+  for (const ModulationRoute &route : settings.routes) {
+    if (!route.enabled || route.depth == 0.0f) {
+      continue;
+    }
+
+    size_t source = static_cast<size_t>(route.getSource());
+    if (route.getSource() == ModSource::Band) {
+      // Without a spectrum the route has nothing to follow
+      if (bandCount == 0) {
+        continue;
+      }
+      source += static_cast<size_t>(
+          std::clamp(route.band, 0, static_cast<int>(bandCount) - 1));
+    }
+    source += static_cast<size_t>(route.getCurve()) * sourceCount;
+
+    const ModTargetInfo &info = targetInfo(route.getTarget());
+    const float depth = route.depth * (info.maximum - info.minimum);
+    const size_t target = static_cast<size_t>(route.getTarget());
+
+    if (route.isShaderTarget()) {
+      compiled.push_back({static_cast<std::uint32_t>(source),
+                          static_cast<std::uint32_t>(
+                              shaderBase + target - WAVEFORM_TARGET_COUNT),
+                          depth});
+    } else if (route.waveform < 0) {
+      for (size_t wave = 0; wave < waveformCount; ++wave) {
+        compiled.push_back(
+            {static_cast<std::uint32_t>(source),
+             static_cast<std::uint32_t>(wave * WAVEFORM_TARGET_COUNT + target),
+             depth});
+      }
+    } else if (static_cast<size_t>(route.waveform) < waveformCount) {
+      compiled.push_back({static_cast<std::uint32_t>(source),
+                          static_cast<std::uint32_t>(
+                              route.waveform * WAVEFORM_TARGET_COUNT + target),
+                          depth});
+    }
+  }
+
+  // Grouped by destination, each offset is summed in one run
+  std::stable_sort(compiled.begin(), compiled.end(),
+                   [](const Compiled &a, const Compiled &b) {
+                     return a.destination < b.destination;
+                   });
+
+  // Shaped sources lie in [0, 1], so an offset peaks with every raising
+  // route at full depth
+  maxOffsets.assign(shaderBase + SHADER_TARGET_COUNT, 0.0f);
+  routeSources.resize(compiled.size());
+  routeDepths.resize(compiled.size());
+  runDestinations.clear();
+  runEnds.clear();
+  for (size_t i = 0; i < compiled.size(); ++i) {
+    routeSources[i] = compiled[i].source;
+    routeDepths[i] = compiled[i].depth;
+    maxOffsets[compiled[i].destination] += std::max(compiled[i].depth, 0.0f);
+    if (runDestinations.empty() ||
+        runDestinations.back() != compiled[i].destination) {
+      runDestinations.push_back(compiled[i].destination);
+      runEnds.push_back(static_cast<std::uint32_t>(i));
+    }
+    runEnds.back() = static_cast<std::uint32_t>(i + 1);
+  }
+
+  sources.assign(sourceCount, 0.0f);
+  shaped.assign(sourceCount * CURVE_COUNT, 0.0f);
+  offsets.assign(shaderBase + SHADER_TARGET_COUNT, 0.0f);
+  compiledWaveforms = waveformCount;
+  compiledBands = bandCount;
+  dirty = false;
+}
+
+void ModulationMatrix::evaluate(const ModulationInputs &inputs,
+                                size_t waveformCount, float deltaTime) {
+  for (size_t i = 0; i < ModulationSettings::LFO_COUNT; ++i) {
+    lfoPhases[i] += static_cast<double>(settings.lfoRates[i]) * deltaTime;
+    lfoPhases[i] -= std::floor(lfoPhases[i]);
+  }
+
+  const size_t bandCount = inputs.bands ? inputs.bandCount : 0;
+  if (dirty || waveformCount != compiledWaveforms ||
+      bandCount != compiledBands) {
+    compile(waveformCount, bandCount);
+  }
+
+  sources[static_cast<size_t>(ModSource::Rms)] = levelToUnit(inputs.rms);
+  sources[static_cast<size_t>(ModSource::Peak)] = levelToUnit(inputs.peak);
+  sources[static_cast<size_t>(ModSource::BeatPhase)] =
+      std::max(inputs.beatPhase, 0.0f);
+  sources[static_cast<size_t>(ModSource::BeatPulse)] =
+      std::clamp(inputs.beatPulse, 0.0f, 1.0f);
+  for (size_t i = 0; i < ModulationSettings::LFO_COUNT; ++i) {
+    // Starts at 0 and swings to 1 halfway through each cycle
+    sources[static_cast<size_t>(ModSource::Lfo1) + i] = static_cast<float>(
+        0.5 - 0.5 * std::cos(2.0 * M_PI * lfoPhases[i]));
+  }
+  std::copy(inputs.bands, inputs.bands + bandCount,
+            sources.begin() + SCALAR_SOURCE_COUNT);
+  if (routeSources.empty()) {
+    return;
+  }
+
+  // Each curve is applied once per source rather than once per route
+  const size_t sourceCount = sources.size();
+  for (size_t curve = 0; curve < CURVE_COUNT; ++curve) {
+    float *row = shaped.data() + curve * sourceCount;
+    for (size_t i = 0; i < sourceCount; ++i) {
+      row[i] = shape(static_cast<ModCurve>(curve), sources[i]);
+    }
+  }
+
+  // Parameters without routes keep a zero offset from compile()
+  const std::uint32_t *source = routeSources.data();
+  const float *depth = routeDepths.data();
+  const float *shapedValues = shaped.data();
+  float *offset = offsets.data();
+  std::uint32_t begin = 0;
+  for (size_t run = 0; run < runEnds.size(); ++run) {
+    const std::uint32_t end = runEnds[run];
+    float sum = 0.0f;
+    for (std::uint32_t i = begin; i < end; ++i) {
+      sum += depth[i] * shapedValues[source[i]];
+    }
+    offset[runDestinations[run]] = sum;
+    begin = end;
+  }
+}
+
+static float clampTarget(ModTarget target, float value) {
+  const ModTargetInfo &info = targetInfo(target);
+  return std::clamp(value, info.minimum, info.maximum);
+}
+
+static sf::Uint8 modulateAlpha(ModTarget target, sf::Uint8 base,
+                               float offset) {
+  return static_cast<sf::Uint8>(
+      std::lround(clampTarget(target, static_cast<float>(base) + offset)));
+}
+
+void ModulationMatrix::applyToWaveforms(const std::vector<WaveformConfig> &base,
+                                        std::vector<WaveformConfig> &out) const {
+  out = base;
+  if (!isActive()) {
+    return;
+  }
+
+  const size_t count = std::min(base.size(), compiledWaveforms);
+  for (size_t i = 0; i < count; ++i) {
+    const float *offset = offsets.data() + i * WAVEFORM_TARGET_COUNT;
+    WaveformConfig &config = out[i];
+    config.displayHeight =
+        clampTarget(ModTarget::DisplayHeight,
+                    config.displayHeight +
+                        offset[static_cast<size_t>(ModTarget::DisplayHeight)]);
+    config.rotationSpeed =
+        clampTarget(ModTarget::RotationSpeed,
+                    config.rotationSpeed +
+                        offset[static_cast<size_t>(ModTarget::RotationSpeed)]);
+    config.radiusFactor =
+        clampTarget(ModTarget::RadiusFactor,
+                    config.radiusFactor +
+                        offset[static_cast<size_t>(ModTarget::RadiusFactor)]);
+    config.thickness = clampTarget(
+        ModTarget::Thickness,
+        config.thickness + offset[static_cast<size_t>(ModTarget::Thickness)]);
+    // Hues wrap around the colour wheel rather than stopping at its ends
+    config.hueOffset += offset[static_cast<size_t>(ModTarget::HueOffset)];
+    config.alpha =
+        modulateAlpha(ModTarget::Alpha, config.alpha,
+                      offset[static_cast<size_t>(ModTarget::Alpha)]);
+    config.thickAlpha =
+        modulateAlpha(ModTarget::ThickAlpha, config.thickAlpha,
+                      offset[static_cast<size_t>(ModTarget::ThickAlpha)]);
+  }
+}
+
+void ModulationMatrix::applyLayoutBounds(
+    const std::vector<WaveformConfig> &base,
+    std::vector<WaveformConfig> &out) const {
+  out = base;
+  if (!isActive()) {
+    return;
+  }
+
+  const size_t count = std::min(base.size(), compiledWaveforms);
+  for (size_t i = 0; i < count; ++i) {
+    const float *reach = maxOffsets.data() + i * WAVEFORM_TARGET_COUNT;
+    WaveformConfig &config = out[i];
+    config.thickness = clampTarget(
+        ModTarget::Thickness,
+        config.thickness + reach[static_cast<size_t>(ModTarget::Thickness)]);
+    config.thickAlpha =
+        modulateAlpha(ModTarget::ThickAlpha, config.thickAlpha,
+                      reach[static_cast<size_t>(ModTarget::ThickAlpha)]);
+  }
+}
+
+void ModulationMatrix::applyToShader(ShaderConfig &shader) const {
+  if (!isActive()) {
+    return;
+  }
+
+  const float *offset =
+      offsets.data() + compiledWaveforms * WAVEFORM_TARGET_COUNT;
+  auto at = [offset](ModTarget target) {
+    return offset[static_cast<size_t>(target) - WAVEFORM_TARGET_COUNT];
+  };
+  shader.fadeFactor = clampTarget(ModTarget::FadeFactor,
+                                  shader.fadeFactor + at(ModTarget::FadeFactor));
+  shader.pixelSize = static_cast<int>(std::lround(
+      clampTarget(ModTarget::PixelSize,
+                  static_cast<float>(shader.pixelSize) +
+                      at(ModTarget::PixelSize))));
+  shader.blendFactor = clampTarget(
+      ModTarget::BlendFactor, shader.blendFactor + at(ModTarget::BlendFactor));
+  shader.fadeThreshold =
+      clampTarget(ModTarget::FadeThreshold,
+                  shader.fadeThreshold + at(ModTarget::FadeThreshold));
+  shader.saturationBoost =
+      clampTarget(ModTarget::SaturationBoost,
+                  shader.saturationBoost + at(ModTarget::SaturationBoost));
+  shader.ditherStrength =
+      clampTarget(ModTarget::DitherStrength,
+                  shader.ditherStrength + at(ModTarget::DitherStrength));
+}
+
+float ModulationMatrix::getSourceValue(ModSource source, int band) const {
+  size_t index = static_cast<size_t>(source);
+  if (source == ModSource::Band) {
+    if (compiledBands == 0) {
+      return 0.0f;
+    }
+    index += static_cast<size_t>(
+        std::clamp(band, 0, static_cast<int>(compiledBands) - 1));
+  }
+  return index < sources.size() ? sources[index] : 0.0f;
+}
@@ -0,0 +1,133 @@
+#include "PerfTimers.h"
+#include <algorithm>
+#include <cmath>
+
+namespace perf {
+
+// Buckets span 10 us to 1 s, about 13% wide each
+static constexpr float MIN_MS = 0.01f;
+static constexpr float MAX_MS = 1000.0f;
+
+static float bucketsPerDecade() {
+  static const float perDecade =
+      static_cast<float>(RollingHistogram::BUCKETS) /
+      std::log10(MAX_MS / MIN_MS);
+  return perDecade;
+}
+
+static size_t bucketFor(float milliseconds) {
+  if (!(milliseconds > MIN_MS)) {
+    return 0;
+  }
+  float position = std::log10(milliseconds / MIN_MS) * bucketsPerDecade();
+  return std::min(static_cast<size_t>(position),
+                  RollingHistogram::BUCKETS - 1);
+}
+
+static float bucketValue(float position) {
+  return MIN_MS * std::pow(10.0f, position / bucketsPerDecade());
+}
+
+void RollingHistogram::record(float milliseconds) {
+  std::uint64_t index = written.fetch_add(1, std::memory_order_acq_rel);
+  float evicted = samples[index % WINDOW].exchange(milliseconds,
+                                                   std::memory_order_relaxed);
+  counts[bucketFor(milliseconds)].fetch_add(1, std::memory_order_relaxed);
+  if (index >= WINDOW) {
+    counts[bucketFor(evicted)].fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+float RollingHistogram::percentile(float fraction) const {
+  std::array<std::int32_t, BUCKETS> snapshot;
+  std::int64_t total = 0;
+  for (size_t i = 0; i < BUCKETS; ++i) {
+    snapshot[i] = std::max(counts[i].load(std::memory_order_relaxed), 0);
+    total += snapshot[i];
+  }
+  if (total == 0) {
+    return 0.0f;
+  }
+
+  // Interpolate within the bucket holding the rank, in log space
+  float rank = std::max(0.0f, std::min(fraction, 1.0f)) *
+               static_cast<float>(total);
+  std::int64_t below = 0;
+  for (size_t i = 0; i < BUCKETS; ++i) {
+    if (snapshot[i] > 0 && static_cast<float>(below + snapshot[i]) >= rank) {
+      float within = (rank - static_cast<float>(below)) /
+                     static_cast<float>(snapshot[i]);
+      return bucketValue(static_cast<float>(i) + within);
+    }
+    below += snapshot[i];
+  }
+  return bucketValue(static_cast<float>(BUCKETS));
+}
+
+void RollingHistogram::copyRecent(std::vector<float> &out) const {
+  std::uint64_t end = written.load(std::memory_order_acquire);
+  std::uint64_t begin = end > WINDOW ? end - WINDOW : 0;
+  out.resize(static_cast<size_t>(end - begin));
+  for (std::uint64_t i = begin; i < end; ++i) {
+    out[static_cast<size_t>(i - begin)] =
+        samples[i % WINDOW].load(std::memory_order_relaxed);
+  }
+}
+
+float RollingHistogram::getLatest() const {
+  std::uint64_t count = written.load(std::memory_order_acquire);
+  if (count == 0) {
+    return 0.0f;
+  }
+  return samples[(count - 1) % WINDOW].load(std::memory_order_relaxed);
+}
+
+const char *timerName(Timer timer) {
+  switch (timer) {
+  case Timer::Capture:
+    return "Capture";
+  case Timer::Conditioning:
+    return "Conditioning";
+  case Timer::Smoothing:
+    return "Smoothing";
+  case Timer::Modulation:
+    return "Modulation";
+  case Timer::Geometry:
+    return "Geometry";
+  case Timer::GeometryBuild:
+    return "Geometry Build";
+  case Timer::Upload:
+    return "Upload";
+  case Timer::TrailShader:
+    return "Trail Shader";
+  case Timer::Waveforms:
+    return "Waveforms";
+  case Timer::ImGui:
+    return "ImGui";
+  case Timer::Present:
+    return "Present";
+  case Timer::Frame:
+    return "Frame";
+  default:
+    return "Unknown";
+  }
+}
+
+// Static storage, so timers need no setup and any thread can reach them
+static RollingHistogram cpuHistograms[TIMER_COUNT];
+static RollingHistogram gpuHistograms[TIMER_COUNT];
+static RollingHistogram waveformHistograms[MAX_TIMED_WAVEFORMS];
+
+RollingHistogram &cpuTimes(Timer timer) {
+  return cpuHistograms[static_cast<size_t>(timer)];
+}
+
+RollingHistogram &gpuTimes(Timer timer) {
+  return gpuHistograms[static_cast<size_t>(timer)];
+}
+
+RollingHistogram *waveformTimes(size_t index) {
+  return index < MAX_TIMED_WAVEFORMS ? &waveformHistograms[index] : nullptr;
+}
+
+} // namespace perf
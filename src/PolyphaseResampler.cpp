@@ -0,0 +1,81 @@
+#include "PolyphaseResampler.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Cutoff as a fraction of the lower Nyquist rate, leaving room for the
+// transition band
+static constexpr double CUTOFF = 0.9;
+
+PolyphaseResampler::PolyphaseResampler(unsigned int inputRate,
+                                       unsigned int outputRate,
+                                       size_t tapsPerPhase)
+    : inputRate(inputRate), outputRate(outputRate) {
+  if (inputRate == 0 || outputRate == 0 || inputRate == outputRate) {
+    return;
+  }
+
+  unsigned int divisor = std::gcd(inputRate, outputRate);
+  upFactor = outputRate / divisor;
+  downFactor = inputRate / divisor;
+
+  size_t ratio = (downFactor + upFactor - 1) / upFactor;
+  taps = std::max<size_t>(tapsPerPhase, 4) * std::max<size_t>(ratio, 1);
+
+  // Windowed-sinc prototype at the upsampled rate, gain L to make up for
+  // the zeros inserted between inputs
+  const size_t length = taps * upFactor;
+  const double cutoff = CUTOFF * 0.5 / std::max(upFactor, downFactor);
+  const double centre = (length - 1) / 2.0;
+  std::vector<double> prototype(length);
+  for (size_t i = 0; i < length; ++i) {
+    double x = static_cast<double>(i) - centre;
+    double sinc = x == 0.0 ? 2.0 * cutoff
+                           : std::sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+    double blackman = 0.42 - 0.5 * std::cos(2.0 * M_PI * i / (length - 1)) +
+                      0.08 * std::cos(4.0 * M_PI * i / (length - 1));
+    prototype[i] = upFactor * sinc * blackman;
+  }
+
+  // Phase p uses prototype[p + k * L] against the k-th newest input; store
+  // reversed so each phase is a plain dot product with the history
+  coefficients.resize(length);
+  for (size_t p = 0; p < upFactor; ++p) {
+    for (size_t k = 0; k < taps; ++k) {
+      coefficients[p * taps + (taps - 1 - k)] =
+          static_cast<float>(prototype[p + k * upFactor]);
+    }
+  }
+
+  history.assign(taps * 2, 0.0f);
+}
+
+void PolyphaseResampler::process(const float *input, size_t count,
+                                 std::vector<float> &output) {
+  if (coefficients.empty()) {
+    output.insert(output.end(), input, input + count);
+    return;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    history[historyPos] = input[i];
+    history[historyPos + taps] = input[i];
+    if (++historyPos == taps) {
+      historyPos = 0;
+    }
+
+    // Every output whose upsampled position falls on or after this input
+    // and before the next one
+    const float *window = history.data() + historyPos;
+    for (; phase < upFactor; phase += downFactor) {
+      output.push_back(
+          dotProduct(coefficients.data() + phase * taps, window, taps));
+    }
+    phase -= upFactor;
+  }
+}
@@ -0,0 +1,183 @@
+#include "PresetLibrary.h"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+
+namespace fs = std::filesystem;
+
+// How long the watch thread blocks before checking for shutdown or a rescan
+static constexpr int WATCH_TIMEOUT_MS = 100;
+
+static bool isPresetFile(const std::string &filename) {
+  return fs::path(filename).extension() == ".json";
+}
+
+PresetLibrary::PresetLibrary(const std::string &directory)
+    : directory(directory) {
+  watchThread = std::thread(&PresetLibrary::watchLoop, this);
+}
+
+PresetLibrary::~PresetLibrary() {
+  running = false;
+  if (watchThread.joinable()) {
+    watchThread.join();
+  }
+}
+
+std::vector<std::string> PresetLibrary::getPresetNames() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<std::string> names;
+  names.reserve(entries.size());
+  for (const auto &entry : entries) {
+    names.push_back(entry.first);
+  }
+  return names;
+}
+
+bool PresetLibrary::getPreset(const std::string &filename,
+                              VisualizerPreset &preset) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(filename);
+  if (it == entries.end()) {
+    return false;
+  }
+  preset = it->second.preset;
+  return true;
+}
+
+std::vector<std::string> PresetLibrary::takeChangedPresets() {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<std::string> result;
+  result.swap(changed);
+  return result;
+}
+
+void PresetLibrary::watchLoop() {
+  // The initial index is built here too, so startup never waits on it.
+  // Watching starts first, so a file changed during the scan still
+  // reports a change rather than being missed.
+  std::unique_ptr<DirectoryWatcher> watcher =
+      DirectoryWatcher::create(directory);
+  scanDirectory();
+  std::vector<FileChange> changes;
+
+  while (running) {
+    if (rescanRequested.exchange(false)) {
+      scanDirectory();
+    }
+
+    changes.clear();
+    if (!watcher->waitForChanges(changes, WATCH_TIMEOUT_MS)) {
+      std::cerr << "Preset directory watch failed, recreating watcher"
+                << std::endl;
+      watcher = DirectoryWatcher::create(directory);
+      scanDirectory();
+      continue;
+    }
+
+    // Editors emit several events per save; handle each file once, in the
+    // state of its last event
+    std::map<std::string, FileChange::Type> latest;
+    bool overflowed = false;
+    for (const FileChange &change : changes) {
+      if (change.type == FileChange::Type::Overflow) {
+        overflowed = true;
+      } else if (isPresetFile(change.filename)) {
+        latest[change.filename] = change.type;
+      }
+    }
+
+    if (overflowed) {
+      scanDirectory();
+      continue;
+    }
+
+    for (const auto &change : latest) {
+      if (change.second == FileChange::Type::Removed) {
+        removeFile(change.first);
+      } else {
+        reloadFile(change.first);
+      }
+    }
+  }
+}
+
+void PresetLibrary::scanDirectory() {
+  std::vector<std::string> names =
+      ConfigSerializer::getAvailablePresets(directory);
+
+  for (const std::string &name : names) {
+    reloadFile(name);
+  }
+
+  // Drop entries whose files disappeared while we were not watching
+  std::set<std::string> present(names.begin(), names.end());
+  std::vector<std::string> stale;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &entry : entries) {
+      if (present.count(entry.first) == 0) {
+        stale.push_back(entry.first);
+      }
+    }
+  }
+  for (const std::string &name : stale) {
+    removeFile(name);
+  }
+}
+
+void PresetLibrary::reloadFile(const std::string &filename) {
+  fs::path path = fs::path(directory) / filename;
+
+  std::error_code ec;
+  fs::file_time_type writeTime = fs::last_write_time(path, ec);
+  if (ec) {
+    removeFile(filename);
+    return;
+  }
+
+  {
+    // Unchanged since it was last parsed
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(filename);
+    if (it != entries.end() && it->second.writeTime == writeTime) {
+      return;
+    }
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return;
+  }
+  std::string content((std::istreambuf_iterator<char>(file)),
+                      std::istreambuf_iterator<char>());
+
+  // A file caught mid-write fails to parse; its old entry stays until the
+  // write completes and triggers another event
+  Entry entry;
+  json::Error error;
+  if (!entry.preset.fromJSON(content, &error)) {
+    std::cerr << "Failed to parse preset " << path.string() << " at byte "
+              << error.offset << ": " << error.message << std::endl;
+    return;
+  }
+  entry.writeTime = writeTime;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[filename] = std::move(entry);
+    changed.push_back(filename);
+  }
+  ++version;
+}
+
+void PresetLibrary::removeFile(const std::string &filename) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.erase(filename) == 0) {
+      return;
+    }
+  }
+  ++version;
+}
@@ -0,0 +1,112 @@
+#include "QualityGovernor.h"
+#include <algorithm>
+#include <iostream>
+
+// Frames averaged for each decision
+static constexpr size_t AVERAGE_FRAMES = 30;
+
+// Step down above this fraction of the target, step up below this one
+static constexpr float DOWNGRADE_RATIO = 1.05f;
+static constexpr float UPGRADE_RATIO = 0.7f;
+
+// Frames of headroom before stepping up, doubled after each bounce and
+// halved while a step up holds
+static constexpr size_t MIN_UPGRADE_HOLD = 120;
+static constexpr size_t MAX_UPGRADE_HOLD = 1920;
+
+static constexpr size_t MAX_DECISIONS = 16;
+
+QualityGovernor::QualityGovernor()
+    : frameTimes(AVERAGE_FRAMES, 0.0f), upgradeHold(MIN_UPGRADE_HOLD) {}
+
+const std::vector<RenderQuality> &QualityGovernor::ladder() {
+  // Point multiplier, thick step, trail scale, jitter samples. Cheap
+  // geometry cuts go first; trail resolution is visible, so it goes last.
+  static const std::vector<RenderQuality> levels = {
+      {10, 0.5f, 1.0f, 8}, {8, 0.5f, 1.0f, 6},   {6, 1.0f, 1.0f, 4},
+      {5, 1.0f, 0.75f, 3}, {4, 1.5f, 0.75f, 2},  {3, 2.0f, 0.5f, 1},
+  };
+  return levels;
+}
+
+void QualityGovernor::setEnabled(bool enable) {
+  enabled = enable;
+  if (!enabled && level != 0) {
+    changeLevel(0);
+  }
+}
+
+bool QualityGovernor::addFrame(float frameMs) {
+  ++frameNumber;
+
+  float oldest = frameTimes[framePos];
+  frameTimes[framePos] = frameMs;
+  framePos = (framePos + 1) % frameTimes.size();
+  if (frameCount == frameTimes.size()) {
+    frameSum -= oldest;
+  } else {
+    ++frameCount;
+  }
+  frameSum += frameMs;
+  averageMs = frameSum / static_cast<float>(frameCount);
+
+  // Wait for a full average since the last change before judging it
+  if (!enabled || frameNumber - lastChangeFrame < AVERAGE_FRAMES) {
+    return false;
+  }
+
+  // A step up that outlasts the bounce window was sound, so the load that
+  // lengthened the hold has passed
+  if (holdingSince > 0 && frameNumber - holdingSince >= upgradeHold * 2 &&
+      upgradeHold > MIN_UPGRADE_HOLD) {
+    upgradeHold = std::max(upgradeHold / 2, MIN_UPGRADE_HOLD);
+    holdingSince = frameNumber;
+  }
+
+  if (averageMs > targetMs * DOWNGRADE_RATIO) {
+    headroomFrames = 0;
+    if (level + 1 >= ladder().size()) {
+      return false;
+    }
+    // Undoing a recent step up: make the next one wait longer
+    if (lastUpgradeFrame > 0 &&
+        frameNumber - lastUpgradeFrame < upgradeHold * 2) {
+      upgradeHold = std::min(upgradeHold * 2, MAX_UPGRADE_HOLD);
+    }
+    holdingSince = 0;
+    changeLevel(level + 1);
+    return true;
+  }
+
+  if (averageMs < targetMs * UPGRADE_RATIO && level > 0) {
+    if (++headroomFrames >= upgradeHold) {
+      headroomFrames = 0;
+      lastUpgradeFrame = frameNumber;
+      holdingSince = frameNumber;
+      changeLevel(level - 1);
+      return true;
+    }
+  } else {
+    headroomFrames = 0;
+  }
+  return false;
+}
+
+void QualityGovernor::changeLevel(size_t newLevel) {
+  Decision decision;
+  decision.frame = frameNumber;
+  decision.fromLevel = level;
+  decision.toLevel = newLevel;
+  decision.averageMs = averageMs;
+  decision.targetMs = targetMs;
+  decisions.push_back(decision);
+  if (decisions.size() > MAX_DECISIONS) {
+    decisions.pop_front();
+  }
+
+  std::cout << "Quality level " << level << " -> " << newLevel << " (average "
+            << averageMs << " ms, target " << targetMs << " ms)" << std::endl;
+
+  level = newLevel;
+  lastChangeFrame = frameNumber;
+}
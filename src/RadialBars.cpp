@@ -0,0 +1,54 @@
+#include "RadialBars.h"
+#include "WaveformDrawer.h"
+
+// Fraction of each bar's angular slot left empty between bars
+static constexpr float BAR_GAP = 0.25f;
+
+void RadialBars::update(const std::vector<float> &levels, float hue,
+                        float rotationAngle, float width, float height,
+                        float radiusFactor, float barHeight, float opacity) {
+  const size_t count = levels.size();
+  vertices.resize(count * 6);
+  if (count == 0) {
+    return;
+  }
+
+  const float centerX = width / 2.0f;
+  const float centerY = height / 2.0f;
+  const float radius = std::min(centerX, centerY) * radiusFactor;
+  const float slot = 2.0f * static_cast<float>(M_PI) / count;
+  const float halfWidth = slot * (1.0f - BAR_GAP) / 2.0f;
+  const sf::Uint8 alpha =
+      static_cast<sf::Uint8>(std::max(0.0f, std::min(1.0f, opacity)) * 255.0f);
+
+  for (size_t b = 0; b < count; ++b) {
+    float angle = rotationAngle + (b + 0.5f) * slot;
+    float outer = radius + levels[b] * barHeight;
+
+    float cos0 = std::cos(angle - halfWidth), sin0 = std::sin(angle - halfWidth);
+    float cos1 = std::cos(angle + halfWidth), sin1 = std::sin(angle + halfWidth);
+    sf::Vector2f innerA(centerX + radius * cos0, centerY + radius * sin0);
+    sf::Vector2f innerB(centerX + radius * cos1, centerY + radius * sin1);
+    sf::Vector2f outerA(centerX + outer * cos0, centerY + outer * sin0);
+    sf::Vector2f outerB(centerX + outer * cos1, centerY + outer * sin1);
+
+    // Hue sweeps once around the circle; louder bars are brighter
+    sf::Color color = hsvToRgb(hue + static_cast<float>(b) / count, 1.0f,
+                               0.4f + 0.6f * levels[b]);
+    color.a = alpha;
+
+    sf::Vertex *quad = &vertices[b * 6];
+    quad[0] = sf::Vertex(innerA, color);
+    quad[1] = sf::Vertex(outerA, color);
+    quad[2] = sf::Vertex(outerB, color);
+    quad[3] = sf::Vertex(innerA, color);
+    quad[4] = sf::Vertex(outerB, color);
+    quad[5] = sf::Vertex(innerB, color);
+  }
+}
+
+void RadialBars::render(sf::RenderTarget &target) const {
+  if (vertices.getVertexCount() > 0) {
+    target.draw(vertices);
+  }
+}
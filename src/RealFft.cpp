@@ -0,0 +1,93 @@
+#include "RealFft.h"
+#include <filesystem>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <system_error>
+
+std::mutex &fftwPlannerMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+// Sizes planned without wisdom this run; guarded by the planner lock
+static std::set<size_t> &unmeasuredSizes() {
+  static std::set<size_t> sizes;
+  return sizes;
+}
+
+bool loadFftWisdom(const std::string &path) {
+  std::lock_guard<std::mutex> lock(fftwPlannerMutex());
+  return fftw_import_wisdom_from_filename(path.c_str()) != 0;
+}
+
+bool saveFftWisdom(const std::string &path) {
+  std::set<size_t> sizes;
+  {
+    std::lock_guard<std::mutex> lock(fftwPlannerMutex());
+    sizes.swap(unmeasuredSizes());
+  }
+  if (sizes.empty()) {
+    return true;
+  }
+
+  // Measured one size at a time, so analysis can plan in between
+  for (size_t size : sizes) {
+    std::lock_guard<std::mutex> lock(fftwPlannerMutex());
+    double *in = fftw_alloc_real(size);
+    fftw_complex *out = fftw_alloc_complex(size / 2 + 1);
+    if (in && out) {
+      fftw_plan plan = fftw_plan_dft_r2c_1d(static_cast<int>(size), in, out,
+                                            FFTW_MEASURE);
+      if (plan) {
+        fftw_destroy_plan(plan);
+      }
+    }
+    fftw_free(in);
+    fftw_free(out);
+  }
+
+  std::error_code ec;
+  std::filesystem::path parent = std::filesystem::path(path).parent_path();
+  if (!parent.empty()) {
+    std::filesystem::create_directories(parent, ec);
+  }
+
+  std::lock_guard<std::mutex> lock(fftwPlannerMutex());
+  if (fftw_export_wisdom_to_filename(path.c_str()) == 0) {
+    std::cerr << "Failed to save FFT wisdom to " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+RealFft::RealFft(size_t size) : fftSize(size) {
+  std::lock_guard<std::mutex> lock(fftwPlannerMutex());
+
+  in = fftw_alloc_real(size);
+  out = fftw_alloc_complex(size / 2 + 1);
+  if (in && out) {
+    // Measuring here would overwrite the buffers and stall the analysis
+    // thread, so only a plan already in the wisdom is taken as measured
+    plan = fftw_plan_dft_r2c_1d(static_cast<int>(size), in, out,
+                                FFTW_MEASURE | FFTW_WISDOM_ONLY);
+    if (!plan) {
+      plan = fftw_plan_dft_r2c_1d(static_cast<int>(size), in, out,
+                                  FFTW_ESTIMATE);
+      unmeasuredSizes().insert(size);
+    }
+  }
+
+  if (!plan) {
+    fftw_free(in);
+    fftw_free(out);
+    throw std::runtime_error("Failed to create FFT plan");
+  }
+}
+
+RealFft::~RealFft() {
+  std::lock_guard<std::mutex> lock(fftwPlannerMutex());
+  fftw_destroy_plan(plan);
+  fftw_free(in);
+  fftw_free(out);
+}
@@ -0,0 +1,152 @@
+#include "SessionPlayer.h"
+#include "AudioUtils.h"
+#include <cstring>
+#include <iostream>
+
+SessionPlayer::SessionPlayer(const std::string &path) : path(path) {}
+
+bool SessionPlayer::initialize() {
+  file.open(path, std::ios::binary);
+  if (!file.is_open()) {
+    std::cerr << "Failed to open session " << path << std::endl;
+    return false;
+  }
+
+  session::FileHeader fileHeader{};
+  if (!file.read(reinterpret_cast<char *>(&fileHeader), sizeof(fileHeader)) ||
+      std::memcmp(fileHeader.magic, session::MAGIC, sizeof(session::MAGIC)) !=
+          0 ||
+      fileHeader.version != session::VERSION) {
+    std::cerr << "Not a session file: " << path << std::endl;
+    return false;
+  }
+
+  // The resampler is built for one rate, taken from the first packet
+  std::streampos start = file.tellg();
+  while (readChunk()) {
+    if (header.type == session::ChunkType::Audio) {
+      session::AudioChunk chunk;
+      std::memcpy(&chunk, payload.data(), sizeof(chunk));
+      sampleRate = chunk.sampleRate;
+      break;
+    }
+  }
+  if (sampleRate == 0) {
+    std::cerr << "Session " << path << " holds no audio" << std::endl;
+    return false;
+  }
+
+  file.clear();
+  file.seekg(start);
+  hasPending = readChunk();
+  std::cout << "Replaying session " << path << " at " << sampleRate << " Hz"
+            << std::endl;
+  return true;
+}
+
+bool SessionPlayer::readChunk() {
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    return false;
+  }
+  payload.resize(header.payloadBytes);
+  if (!file.read(reinterpret_cast<char *>(payload.data()),
+                 static_cast<std::streamsize>(payload.size()))) {
+    std::cerr << "Session " << path << " ends mid-chunk" << std::endl;
+    return false;
+  }
+
+  // A chunk too short for its own fields ends the replay
+  size_t fixed = header.type == session::ChunkType::Audio
+                     ? sizeof(session::AudioChunk)
+                     : sizeof(session::ConfigChunk);
+  return payload.size() >= fixed;
+}
+
+std::int64_t SessionPlayer::pendingTimeNs() const {
+  // Both chunk kinds start with their timestamp
+  std::int64_t timeNs;
+  std::memcpy(&timeNs, payload.data(), sizeof(timeNs));
+  return timeNs;
+}
+
+bool SessionPlayer::captureAudio(std::vector<float> &monoFrames) {
+  monoFrames.clear();
+  if (!hasPending) {
+    if (!finished) {
+      finished = true;
+      std::cout << "Session replay finished" << std::endl;
+    }
+    return true;
+  }
+
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (!started) {
+    recordedOriginNs = pendingTimeNs();
+    replayOrigin = now;
+    started = true;
+  }
+  std::int64_t replayNs = recordedOriginNs +
+                          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              now - replayOrigin)
+                              .count();
+  std::int64_t offsetNs =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          replayOrigin.time_since_epoch())
+          .count() -
+      recordedOriginNs;
+
+  // Everything recorded up to the replay position, as capture would have
+  // delivered it
+  while (hasPending && pendingTimeNs() <= replayNs) {
+    if (header.type == session::ChunkType::Audio) {
+      session::AudioChunk chunk;
+      std::memcpy(&chunk, payload.data(), sizeof(chunk));
+      size_t samples = static_cast<size_t>(chunk.frames) * chunk.channels;
+      bool silent = (chunk.flags & session::AUDIO_SILENT) != 0;
+
+      // Packets from after a device rate change cannot be resampled by
+      // the capture thread's resampler and are skipped
+      if (chunk.sampleRate == sampleRate && chunk.channels > 0 &&
+          (silent || payload.size() >= sizeof(chunk) + samples * sizeof(float))) {
+        const float *data = nullptr;
+        if (!silent) {
+          data = reinterpret_cast<const float *>(payload.data() +
+                                                 sizeof(chunk));
+        }
+
+        size_t start = monoFrames.size();
+        monoFrames.resize(start + chunk.frames, 0.0f);
+        if (data) {
+          downmixToMono(data, chunk.frames, chunk.channels,
+                        monoFrames.data() + start);
+        }
+
+        if (packetCallback) {
+          capture::AudioPacket packet;
+          packet.data = data;
+          packet.frames = chunk.frames;
+          packet.channels = chunk.channels;
+          packet.sampleRate = chunk.sampleRate;
+          packet.captureTimeNs = chunk.captureTimeNs + offsetNs;
+          packetCallback(packet);
+        }
+      }
+    } else if (header.type == session::ChunkType::Config) {
+      const char *json = reinterpret_cast<const char *>(
+          payload.data() + sizeof(session::ConfigChunk));
+      std::lock_guard<std::mutex> lock(configMutex);
+      configChanges.emplace_back(
+          json, payload.size() - sizeof(session::ConfigChunk));
+    }
+
+    hasPending = readChunk();
+  }
+  return true;
+}
+
+std::vector<std::string> SessionPlayer::takeConfigChanges() {
+  std::lock_guard<std::mutex> lock(configMutex);
+  std::vector<std::string> changes;
+  changes.swap(configChanges);
+  return changes;
+}
@@ -0,0 +1,199 @@
+#include "SessionRecorder.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// About ten seconds of stereo 48 kHz audio can queue before chunks drop
+static constexpr size_t AUDIO_RING_BYTES = 4 * 1024 * 1024;
+static constexpr size_t EVENT_RING_BYTES = 1024 * 1024;
+
+// The file is written in whole blocks of this size, except the last
+static constexpr size_t BLOCK_BYTES = 256 * 1024;
+
+// How long the writer sleeps between drains
+static constexpr int WRITE_INTERVAL_MS = 20;
+
+SessionRecorder::SessionRecorder()
+    : audio(AUDIO_RING_BYTES), events(EVENT_RING_BYTES) {
+  staging.reserve(BLOCK_BYTES * 2);
+}
+
+SessionRecorder::~SessionRecorder() { stop(); }
+
+bool SessionRecorder::start(const std::string &filePath) {
+  if (writer.joinable()) {
+    return false;
+  }
+
+  file = std::fopen(filePath.c_str(), "wb");
+  if (!file) {
+    std::cerr << "Failed to open session file " << filePath << std::endl;
+    return false;
+  }
+  // Writes are already block-sized; stdio buffering would only copy them
+  std::setvbuf(file, nullptr, _IONBF, 0);
+
+  session::FileHeader header{};
+  std::memcpy(header.magic, session::MAGIC, sizeof(header.magic));
+  header.version = session::VERSION;
+  staging.clear();
+  staging.resize(sizeof(header));
+  std::memcpy(staging.data(), &header, sizeof(header));
+
+  path = filePath;
+  bytesWritten = 0;
+  droppedChunks = 0;
+  stopping = false;
+  writer = std::thread(&SessionRecorder::writeLoop, this);
+  recording.store(true, std::memory_order_release);
+  std::cout << "Recording session to " << path << std::endl;
+  return true;
+}
+
+void SessionRecorder::stop() {
+  if (!writer.joinable()) {
+    return;
+  }
+
+  // No new chunks, then wait out any producer already past the check so
+  // the rings end on a chunk boundary
+  recording.store(false, std::memory_order_seq_cst);
+  while (producers.load(std::memory_order_seq_cst) != 0) {
+    std::this_thread::yield();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    stopping = true;
+  }
+  wake.notify_one();
+  writer.join();
+
+  std::fclose(file);
+  file = nullptr;
+  std::cout << "Session written to " << path << " (" << bytesWritten.load()
+            << " bytes, " << droppedChunks.load() << " chunks dropped)"
+            << std::endl;
+}
+
+bool SessionRecorder::beginChunk(Stream &stream, session::ChunkType type,
+                                 std::uint32_t payloadBytes) {
+  size_t needed = sizeof(session::ChunkHeader) + payloadBytes;
+  // The writer only frees space, so this check holds until we write
+  if (stream.ring.capacity() - stream.ring.size() < needed) {
+    droppedChunks.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  session::ChunkHeader header{type, payloadBytes};
+  stream.ring.write(reinterpret_cast<const std::uint8_t *>(&header),
+                    sizeof(header));
+  return true;
+}
+
+void SessionRecorder::recordPacket(const float *data, std::uint32_t frames,
+                                   std::uint32_t channels,
+                                   std::uint32_t sampleRate,
+                                   std::int64_t captureTimeNs) {
+  producers.fetch_add(1, std::memory_order_seq_cst);
+  if (recording.load(std::memory_order_seq_cst)) {
+    session::AudioChunk chunk{};
+    chunk.captureTimeNs = captureTimeNs;
+    chunk.sampleRate = sampleRate;
+    chunk.channels = channels;
+    chunk.frames = frames;
+    chunk.flags = data ? 0 : session::AUDIO_SILENT;
+
+    size_t sampleBytes = data ? sizeof(float) * frames * channels : 0;
+    if (beginChunk(audio, session::ChunkType::Audio,
+                   static_cast<std::uint32_t>(sizeof(chunk) + sampleBytes))) {
+      audio.ring.write(reinterpret_cast<const std::uint8_t *>(&chunk),
+                       sizeof(chunk));
+      audio.ring.write(reinterpret_cast<const std::uint8_t *>(data),
+                       sampleBytes);
+    }
+  }
+  producers.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void SessionRecorder::recordConfig(const std::string &presetJson,
+                                   std::int64_t timeNs) {
+  producers.fetch_add(1, std::memory_order_seq_cst);
+  if (recording.load(std::memory_order_seq_cst)) {
+    session::ConfigChunk chunk{timeNs};
+    if (beginChunk(events, session::ChunkType::Config,
+                   static_cast<std::uint32_t>(sizeof(chunk) +
+                                              presetJson.size()))) {
+      events.ring.write(reinterpret_cast<const std::uint8_t *>(&chunk),
+                        sizeof(chunk));
+      events.ring.write(
+          reinterpret_cast<const std::uint8_t *>(presetJson.data()),
+          presetJson.size());
+    }
+  }
+  producers.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void SessionRecorder::writeLoop() {
+  std::unique_lock<std::mutex> lock(wakeMutex);
+  while (true) {
+    wake.wait_for(lock, std::chrono::milliseconds(WRITE_INTERVAL_MS),
+                  [this] { return stopping; });
+    bool finishing = stopping;
+    lock.unlock();
+
+    // The streams interleave at drain granularity; replay paces every
+    // chunk by its own timestamp, so their order within a pass is moot
+    drain(events);
+    drain(audio);
+    writeStaged(finishing);
+
+    if (finishing) {
+      return;
+    }
+    lock.lock();
+  }
+}
+
+void SessionRecorder::drain(Stream &stream) {
+  // Move complete chunks only; a chunk still being written stays in the
+  // ring until the next pass
+  while (true) {
+    if (!stream.hasHeader) {
+      if (stream.ring.size() < sizeof(session::ChunkHeader)) {
+        return;
+      }
+      stream.ring.read(reinterpret_cast<std::uint8_t *>(&stream.header),
+                       sizeof(stream.header));
+      stream.hasHeader = true;
+    }
+    if (stream.ring.size() < stream.header.payloadBytes) {
+      return;
+    }
+
+    size_t offset = staging.size();
+    staging.resize(offset + sizeof(stream.header) +
+                   stream.header.payloadBytes);
+    std::memcpy(staging.data() + offset, &stream.header,
+                sizeof(stream.header));
+    stream.ring.read(staging.data() + offset + sizeof(stream.header),
+                     stream.header.payloadBytes);
+    stream.hasHeader = false;
+  }
+}
+
+void SessionRecorder::writeStaged(bool all) {
+  size_t length = all ? staging.size()
+                      : staging.size() / BLOCK_BYTES * BLOCK_BYTES;
+  if (length == 0) {
+    return;
+  }
+
+  size_t written = std::fwrite(staging.data(), 1, length, file);
+  if (written != length) {
+    std::cerr << "Session write failed after " << bytesWritten.load()
+              << " bytes" << std::endl;
+  }
+  bytesWritten.fetch_add(written, std::memory_order_relaxed);
+  staging.erase(staging.begin(), staging.begin() + length);
+}
@@ -0,0 +1,243 @@
+#include "ShaderCache.h"
+#include <SFML/OpenGL.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <system_error>
+#include <vector>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+namespace fs = std::filesystem;
+
+// ARB_get_program_binary; core since OpenGL 4.1 but absent from the 1.1
+// headers
+static constexpr GLenum LINK_STATUS = 0x8B82;
+static constexpr GLenum PROGRAM_BINARY_LENGTH = 0x8741;
+static constexpr GLenum NUM_PROGRAM_BINARY_FORMATS = 0x87FE;
+
+static constexpr const char *CACHE_DIRECTORY = "cache/shaders";
+
+// Identifies a cache file and the version of its layout
+static constexpr std::uint32_t CACHE_MAGIC = 0x42535441; // "ATSB"
+
+namespace {
+
+struct ProgramBinaryFunctions {
+  using GetProgramiv = void(APIENTRY *)(GLuint, GLenum, GLint *);
+  using GetProgramBinary = void(APIENTRY *)(GLuint, GLsizei, GLsizei *,
+                                            GLenum *, void *);
+  using ProgramBinary = void(APIENTRY *)(GLuint, GLenum, const void *,
+                                         GLsizei);
+
+  GetProgramiv getProgramiv = nullptr;
+  GetProgramBinary getProgramBinary = nullptr;
+  ProgramBinary programBinary = nullptr;
+  bool loaded = false;
+};
+
+template <typename F> F load(const char *name) {
+  return reinterpret_cast<F>(sf::Context::getFunction(name));
+}
+
+const ProgramBinaryFunctions &programBinaries() {
+  static const ProgramBinaryFunctions functions = [] {
+    using P = ProgramBinaryFunctions;
+    P f;
+    if (!sf::Context::isExtensionAvailable("GL_ARB_get_program_binary")) {
+      return f;
+    }
+    // Some drivers expose the extension without supporting any format
+    GLint formats = 0;
+    glGetIntegerv(NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0) {
+      return f;
+    }
+    f.getProgramiv = load<P::GetProgramiv>("glGetProgramiv");
+    f.getProgramBinary = load<P::GetProgramBinary>("glGetProgramBinary");
+    f.programBinary = load<P::ProgramBinary>("glProgramBinary");
+    f.loaded = f.getProgramiv && f.getProgramBinary && f.programBinary;
+    return f;
+  }();
+  return functions;
+}
+
+// FNV-1a; only has to tell sources and drivers apart, not resist attack
+void hashBytes(std::uint64_t &hash, const void *data, size_t size) {
+  const auto *bytes = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+  }
+}
+
+void hashString(std::uint64_t &hash, const char *text) {
+  // Strings are terminated in the hash so their boundaries count
+  const char *value = text ? text : "";
+  hashBytes(hash, value, std::char_traits<char>::length(value) + 1);
+}
+
+// Binaries are only valid for the driver that produced them
+std::uint64_t cacheKey(const std::string &source, sf::Shader::Type type) {
+  std::uint64_t hash = 0xcbf29ce484222325ull;
+  hashBytes(hash, source.data(), source.size());
+  const int stage = static_cast<int>(type);
+  hashBytes(hash, &stage, sizeof(stage));
+  hashString(hash, reinterpret_cast<const char *>(glGetString(GL_VENDOR)));
+  hashString(hash, reinterpret_cast<const char *>(glGetString(GL_RENDERER)));
+  hashString(hash, reinterpret_cast<const char *>(glGetString(GL_VERSION)));
+  return hash;
+}
+
+std::string cachePrefix(const std::string &path) {
+  return fs::path(path).filename().string() + "-";
+}
+
+fs::path cacheFile(const std::string &path, std::uint64_t key) {
+  char hex[17];
+  std::snprintf(hex, sizeof(hex), "%016llx",
+                static_cast<unsigned long long>(key));
+  return fs::path(CACHE_DIRECTORY) / (cachePrefix(path) + hex + ".bin");
+}
+
+// Smallest program of the same stage, linked through SFML so the shader
+// owns a program object to load the binary into
+const char *placeholderSource(sf::Shader::Type type) {
+  return type == sf::Shader::Vertex
+             ? "void main() { gl_Position = vec4(0.0); }"
+             : "void main() { gl_FragColor = vec4(0.0); }";
+}
+
+bool loadBinary(sf::Shader &shader, const fs::path &file,
+                sf::Shader::Type type) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in.is_open()) {
+    return false;
+  }
+
+  std::uint32_t magic = 0;
+  GLenum format = 0;
+  in.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  in.read(reinterpret_cast<char *>(&format), sizeof(format));
+  if (!in || magic != CACHE_MAGIC) {
+    return false;
+  }
+
+  // The rest of the file is the binary
+  const std::streampos start = in.tellg();
+  in.seekg(0, std::ios::end);
+  const std::streamoff size = in.tellg() - start;
+  if (size <= 0) {
+    return false;
+  }
+  std::vector<char> binary(static_cast<size_t>(size));
+  in.seekg(start);
+  if (!in.read(binary.data(), size)) {
+    return false;
+  }
+
+  if (!shader.loadFromMemory(placeholderSource(type), type)) {
+    return false;
+  }
+
+  const ProgramBinaryFunctions &gl = programBinaries();
+  const GLuint program = shader.getNativeHandle();
+  gl.programBinary(program, format, binary.data(),
+                   static_cast<GLsizei>(binary.size()));
+  GLint linked = GL_FALSE;
+  gl.getProgramiv(program, LINK_STATUS, &linked);
+  return linked == GL_TRUE;
+}
+
+void saveBinary(const sf::Shader &shader, const std::string &path,
+                const fs::path &file) {
+  const ProgramBinaryFunctions &gl = programBinaries();
+  const GLuint program = shader.getNativeHandle();
+
+  // Drivers may decline without a retrievable hint, which SFML never sets
+  GLint length = 0;
+  gl.getProgramiv(program, PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return;
+  }
+  std::vector<char> binary(static_cast<size_t>(length));
+  GLsizei written = 0;
+  GLenum format = 0;
+  gl.getProgramBinary(program, length, &written, &format, binary.data());
+  if (written <= 0) {
+    return;
+  }
+
+  std::error_code ec;
+  fs::create_directories(CACHE_DIRECTORY, ec);
+
+  // Entries for older versions of this source are never read again
+  const std::string prefix = cachePrefix(path);
+  for (const auto &entry : fs::directory_iterator(CACHE_DIRECTORY, ec)) {
+    if (entry.path().filename().string().rfind(prefix, 0) == 0) {
+      fs::remove(entry.path(), ec);
+    }
+  }
+
+  // Written aside and renamed, so another instance never reads half a file
+  fs::path temporary = file;
+  temporary += ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&CACHE_MAGIC),
+              sizeof(CACHE_MAGIC));
+    out.write(reinterpret_cast<const char *>(&format), sizeof(format));
+    out.write(binary.data(), written);
+    if (!out) {
+      fs::remove(temporary, ec);
+      return;
+    }
+  }
+  fs::rename(temporary, file, ec);
+  if (ec) {
+    fs::remove(temporary, ec);
+  }
+}
+
+} // namespace
+
+namespace shaders {
+
+bool loadCached(sf::Shader &shader, const std::string &path,
+                sf::Shader::Type type) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open()) {
+    std::cerr << "Failed to open shader " << path << std::endl;
+    return false;
+  }
+  std::string source((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+
+  if (type == sf::Shader::Geometry || !sf::Shader::isAvailable() ||
+      !programBinaries().loaded) {
+    return shader.loadFromMemory(source, type);
+  }
+
+  const fs::path file = cacheFile(path, cacheKey(source, type));
+  std::error_code ec;
+  if (fs::exists(file, ec)) {
+    if (loadBinary(shader, file, type)) {
+      return true;
+    }
+    std::cerr << "Cached binary for " << path << " rejected, recompiling"
+              << std::endl;
+    fs::remove(file, ec);
+  }
+
+  if (!shader.loadFromMemory(source, type)) {
+    return false;
+  }
+  saveBinary(shader, path, file);
+  return true;
+}
+
+} // namespace shaders
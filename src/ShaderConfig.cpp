@@ -1,44 +1,16 @@
 #include "ShaderConfig.h"
-#include <string>
+#include "JsonReader.h"
 
-// Helper function to extract value from JSON
-static std::string extractValue(const std::string& content, const std::string& key) {
-    std::string searchKey = "\"" + key + "\":";
-    size_t pos = content.find(searchKey);
-    if (pos == std::string::npos) return "";
+// Keys dispatched to members in a single pass over the object
+static constexpr json::Field<ShaderConfig> kFields[] = {
+    {"fadeFactor", &ShaderConfig::fadeFactor},
+    {"pixelSize", &ShaderConfig::pixelSize},
+    {"blendFactor", &ShaderConfig::blendFactor},
+    {"fadeThreshold", &ShaderConfig::fadeThreshold},
+    {"saturationBoost", &ShaderConfig::saturationBoost},
+    {"ditherStrength", &ShaderConfig::ditherStrength},
+};
 
-    pos += searchKey.length();
-    size_t endPos = content.find_first_of(",\n}", pos);
-    if (endPos == std::string::npos) return "";
-
-    std::string value = content.substr(pos, endPos - pos);
-    
-    // Trim whitespace and quotes
-    size_t first = value.find_first_not_of(" \t\n\r\"");
-    if (first == std::string::npos) return "";
-    size_t last = value.find_last_not_of(" \t\n\r\",\"");
-    return value.substr(first, last - first + 1);
-}
-
-void ShaderConfig::fromJSON(const std::string& json) {
-    std::string val;
-    
-    val = extractValue(json, "fadeFactor");
-    if (!val.empty()) fadeFactor = std::stof(val);
-    
-    val = extractValue(json, "pixelSize");
-    if (!val.empty()) pixelSize = std::stoi(val);
-    
-    val = extractValue(json, "blendFactor");
-    if (!val.empty()) blendFactor = std::stof(val);
-    
-    val = extractValue(json, "fadeThreshold");
-    if (!val.empty()) fadeThreshold = std::stof(val);
-    
-    // Enhancement effect parameters
-    val = extractValue(json, "saturationBoost");
-    if (!val.empty()) saturationBoost = std::stof(val);
-    
-    val = extractValue(json, "ditherStrength");
-    if (!val.empty()) ditherStrength = std::stof(val);
+bool ShaderConfig::fromJSON(json::Reader &reader) {
+  return json::readObject(reader, *this, kFields);
 }
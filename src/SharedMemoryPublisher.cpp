@@ -0,0 +1,185 @@
+#include "SharedMemoryPublisher.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// The sequence and frame count are plain uint64_t in the C layout and are
+// accessed through std::atomic here
+static_assert(sizeof(std::atomic<std::uint64_t>) == sizeof(std::uint64_t) &&
+                  std::atomic<std::uint64_t>::is_always_lock_free,
+              "shared counters must be lock-free 64-bit atomics");
+static_assert(sizeof(atshm_frame) % 8 == 0, "slots must stay 64-bit aligned");
+
+static std::atomic<std::uint64_t> &shared(std::uint64_t &value) {
+  return *reinterpret_cast<std::atomic<std::uint64_t> *>(&value);
+}
+
+SharedMemoryPublisher::~SharedMemoryPublisher() { close(); }
+
+bool SharedMemoryPublisher::open(const std::string &regionName) {
+  close();
+  viewBytes = sizeof(atshm_header) + ATSHM_SLOT_COUNT * sizeof(atshm_frame);
+
+#if defined(_WIN32)
+  std::string mappingName =
+      "Local\\" + (regionName.empty() || regionName[0] != '/'
+                       ? regionName
+                       : regionName.substr(1));
+  HANDLE handle = CreateFileMappingA(
+      INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+      static_cast<DWORD>(static_cast<std::uint64_t>(viewBytes) >> 32),
+      static_cast<DWORD>(viewBytes), mappingName.c_str());
+  if (!handle) {
+    std::cerr << "Failed to create shared memory " << mappingName << ": "
+              << GetLastError() << std::endl;
+    return false;
+  }
+  view = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, viewBytes);
+  if (!view) {
+    std::cerr << "Failed to map shared memory " << mappingName << ": "
+              << GetLastError() << std::endl;
+    CloseHandle(handle);
+    return false;
+  }
+  mapping = handle;
+  const std::uint64_t pid = GetCurrentProcessId();
+#else
+  int fd = shm_open(regionName.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0) {
+    std::cerr << "Failed to open shared memory " << regionName << ": "
+              << std::strerror(errno) << std::endl;
+    return false;
+  }
+  if (ftruncate(fd, static_cast<off_t>(viewBytes)) != 0) {
+    std::cerr << "Failed to size shared memory " << regionName << ": "
+              << std::strerror(errno) << std::endl;
+    ::close(fd);
+    return false;
+  }
+  view = mmap(nullptr, viewBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (view == MAP_FAILED) {
+    std::cerr << "Failed to map shared memory " << regionName << ": "
+              << std::strerror(errno) << std::endl;
+    view = nullptr;
+    return false;
+  }
+  const std::uint64_t pid = static_cast<std::uint64_t>(getpid());
+#endif
+
+  header = static_cast<atshm_header *>(view);
+  slots = reinterpret_cast<atshm_frame *>(header + 1);
+
+  // Continue a previous writer's numbering so attached readers carry on;
+  // anything else starts from scratch
+  bool compatible = header->magic == ATSHM_MAGIC &&
+                    header->version == ATSHM_VERSION &&
+                    header->slot_count == ATSHM_SLOT_COUNT &&
+                    header->frame_bytes == sizeof(atshm_frame);
+  if (!compatible) {
+    header->magic = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memset(slots, 0, ATSHM_SLOT_COUNT * sizeof(atshm_frame));
+    header->version = ATSHM_VERSION;
+    header->slot_count = ATSHM_SLOT_COUNT;
+    header->frame_bytes = sizeof(atshm_frame);
+    shared(header->frame_count).store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = ATSHM_MAGIC;
+  }
+  header->writer_pid = pid;
+  framesPublished = shared(header->frame_count).load(std::memory_order_acquire);
+
+  name = regionName;
+  std::cout << "Publishing analysis to shared memory " << name << std::endl;
+  return true;
+}
+
+void SharedMemoryPublisher::close() {
+  if (!view) {
+    return;
+  }
+  // The region itself stays so readers survive a restart
+#if defined(_WIN32)
+  UnmapViewOfFile(view);
+  CloseHandle(static_cast<HANDLE>(mapping));
+  mapping = nullptr;
+#else
+  munmap(view, viewBytes);
+#endif
+  view = nullptr;
+  header = nullptr;
+  slots = nullptr;
+}
+
+void SharedMemoryPublisher::publish(const SharedAnalysis &analysis) {
+  if (!header) {
+    return;
+  }
+
+  const std::uint64_t frame = framesPublished + 1;
+  atshm_frame &slot = slots[(frame - 1) % ATSHM_SLOT_COUNT];
+  std::atomic<std::uint64_t> &sequence = shared(slot.sequence);
+
+  // Odd sequence: readers of this slot retry until the even one below
+  sequence.store(frame * 2 - 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot.time_ns = analysis.timeNs;
+
+  const size_t samples =
+      analysis.samples ? std::min<size_t>(analysis.sampleCount,
+                                          ATSHM_MAX_SAMPLES)
+                       : 0;
+  for (size_t i = 0; i < samples; ++i) {
+    slot.samples[i] = static_cast<float>(analysis.samples[i]);
+  }
+  slot.sample_rate = analysis.sampleRate;
+  slot.sample_count = static_cast<std::uint32_t>(samples);
+  slot.peak = analysis.peak;
+  slot.rms = analysis.rms;
+  slot.gain = analysis.gain;
+  slot.silent = analysis.silent ? 1u : 0u;
+
+  const size_t bins =
+      analysis.spectrum
+          ? std::min<size_t>(analysis.fftSize / 2 + 1, ATSHM_MAX_BINS)
+          : 0;
+  if (bins > 0) {
+    std::memcpy(slot.spectrum, analysis.spectrum, bins * sizeof(float));
+  }
+  slot.fft_size = static_cast<std::uint32_t>(analysis.fftSize);
+  slot.bin_count = static_cast<std::uint32_t>(bins);
+
+  const size_t bands =
+      analysis.bands ? std::min<size_t>(analysis.bandCount, ATSHM_MAX_BANDS)
+                     : 0;
+  if (bands > 0) {
+    std::memcpy(slot.bands, analysis.bands, bands * sizeof(float));
+  }
+  slot.band_count = static_cast<std::uint32_t>(bands);
+
+  slot.bpm = analysis.bpm;
+  slot.beat_confidence = analysis.beatConfidence;
+  slot.beat_phase = analysis.beatPhase;
+  slot.beat_count = analysis.beatCount;
+  slot.onset_count = analysis.onsetCount;
+  slot.last_beat_ns = analysis.lastBeatNs;
+
+  sequence.store(frame * 2, std::memory_order_release);
+  shared(header->frame_count).store(frame, std::memory_order_release);
+  framesPublished = frame;
+}
@@ -0,0 +1,82 @@
+#include "SmoothingCache.h"
+#include "AudioUtils.h"
+#include <algorithm>
+
+void SmoothingCache::build(const std::vector<double> &audioBuffer,
+                           double gain) {
+  mirrorAudioBuffer(audioBuffer, mirrored, gain);
+  buildPrefix(mirrored, prefix);
+  entryCount = 0;
+}
+
+void SmoothingCache::buildPrefix(const std::vector<double> &data,
+                                 std::vector<double> &prefixOut) {
+  prefixOut.resize(data.size() + 1);
+  prefixOut[0] = 0.0;
+  for (size_t i = 0; i < data.size(); ++i) {
+    prefixOut[i + 1] = prefixOut[i] + data[i];
+  }
+}
+
+double SmoothingCache::boxAt(size_t index, int radius) const {
+  const size_t size = mirrored.size();
+  const size_t r = static_cast<size_t>(std::max(radius, 0));
+  size_t lo = index > r ? index - r : 0;
+  size_t hi = std::min(size, index + r + 1);
+  return (prefix[hi] - prefix[lo]) / static_cast<double>(hi - lo);
+}
+
+void SmoothingCache::boxFilter(const std::vector<double> &prefixSums,
+                               int radius, std::vector<double> &out) {
+  const size_t size = prefixSums.size() - 1;
+  const size_t r = static_cast<size_t>(radius);
+  out.resize(size);
+
+  // The window only shrinks within r samples of either end, so the
+  // interior runs without clamping
+  const size_t interiorBegin = std::min(r, size);
+  const size_t interiorEnd = size > r ? size - r : 0;
+  const double inverseWidth = 1.0 / static_cast<double>(2 * r + 1);
+
+  for (size_t i = 0; i < interiorBegin; ++i) {
+    size_t hi = std::min(size, i + r + 1);
+    out[i] = prefixSums[hi] / static_cast<double>(hi);
+  }
+  for (size_t i = interiorBegin; i < interiorEnd; ++i) {
+    out[i] = (prefixSums[i + r + 1] - prefixSums[i - r]) * inverseWidth;
+  }
+  for (size_t i = std::max(interiorBegin, interiorEnd); i < size; ++i) {
+    size_t lo = i > r ? i - r : 0;
+    out[i] = (prefixSums[size] - prefixSums[lo]) /
+             static_cast<double>(size - lo);
+  }
+}
+
+const std::vector<double> &SmoothingCache::smoothed(int radius, int passes) {
+  passes = std::min(passes, MAX_PASSES);
+  if (radius <= 0 || passes <= 0 || mirrored.empty()) {
+    return mirrored;
+  }
+
+  for (size_t i = 0; i < entryCount; ++i) {
+    if (entries[i].radius == radius && entries[i].passes == passes) {
+      return entries[i].data;
+    }
+  }
+
+  if (entryCount == entries.size()) {
+    entries.emplace_back();
+  }
+  Entry &entry = entries[entryCount++];
+  entry.radius = radius;
+  entry.passes = passes;
+
+  // The first pass reads the shared prefix; later passes need one over the
+  // previous pass's output
+  boxFilter(prefix, radius, entry.data);
+  for (int pass = 1; pass < passes; ++pass) {
+    buildPrefix(entry.data, passPrefix);
+    boxFilter(passPrefix, radius, entry.data);
+  }
+  return entry.data;
+}
@@ -0,0 +1,81 @@
+#include "StftEngine.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+StftEngine::StftEngine(size_t windowSize, size_t hopSize)
+    : windowSize(windowSize),
+      hopSize(std::max<size_t>(1, std::min(hopSize, windowSize))) {
+  fft = std::make_unique<RealFft>(windowSize);
+  window.resize(windowSize);
+  for (size_t i = 0; i < windowSize; ++i) {
+    window[i] = 0.5 - 0.5 * std::cos(2.0 * M_PI * i / windowSize);
+  }
+  history.assign(windowSize * 2, 0.0f);
+  magnitudes.assign(fft->bins(), 0.0f);
+}
+
+void StftEngine::transform() {
+  // Oldest sample first, so the window lines up with the frame
+  const float *frame = history.data() + historyPos;
+  double *input = fft->input();
+  for (size_t i = 0; i < windowSize; ++i) {
+    input[i] = frame[i] * window[i];
+  }
+  fft->execute();
+
+  // One-sided spectrum (2 / N) over the Hann coherent gain (0.5)
+  const fftw_complex *spectrum = fft->output();
+  const double scale = 4.0 / windowSize;
+  for (size_t k = 0; k < magnitudes.size(); ++k) {
+    magnitudes[k] =
+        static_cast<float>(std::hypot(spectrum[k][0], spectrum[k][1]) * scale);
+  }
+}
+
+
+void StftEngine::setTrackedBins(const std::vector<size_t> &bins) {
+  tracked.clear();
+  twiddles.clear();
+  slidingBins.clear();
+  const size_t maxBin = std::max<size_t>(windowSize / 2, 2) - 1;
+  const float *frame = history.data() + historyPos;
+  for (size_t bin : bins) {
+    bin = std::max<size_t>(1, std::min(bin, maxBin));
+    tracked.push_back(bin);
+    for (size_t k = bin - 1; k <= bin + 1; ++k) {
+      double angle = 2.0 * M_PI * static_cast<double>(k) / windowSize;
+      twiddles.emplace_back(std::cos(angle), std::sin(angle));
+
+      // Start from the DFT of the current window, oldest sample first
+      std::complex<double> sum;
+      for (size_t n = 0; n < windowSize; ++n) {
+        sum += static_cast<double>(frame[n]) *
+               std::polar(1.0, -angle * static_cast<double>(n));
+      }
+      slidingBins.push_back(sum);
+    }
+  }
+}
+
+void StftEngine::slide(double difference) {
+  // X'(k) = (X(k) + newest - oldest) * e^(j 2 pi k / N). Errors only
+  // accumulate linearly in double precision, so no resync is needed.
+  for (size_t i = 0; i < slidingBins.size(); ++i) {
+    slidingBins[i] = (slidingBins[i] + difference) * twiddles[i];
+  }
+}
+
+float StftEngine::getTrackedMagnitude(size_t index) const {
+  if (index >= tracked.size()) {
+    return 0.0f;
+  }
+
+  // Hann window as the kernel -1/4, 1/2, -1/4 across neighbouring bins
+  const std::complex<double> *bins = &slidingBins[index * 3];
+  std::complex<double> windowed = 0.5 * bins[1] - 0.25 * (bins[0] + bins[2]);
+  return static_cast<float>(std::abs(windowed) * 4.0 / windowSize);
+}
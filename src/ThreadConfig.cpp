@@ -0,0 +1,287 @@
+#include "ThreadConfig.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <avrt.h>
+#pragma comment(lib, "avrt.lib")
+#elif defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace threading {
+
+namespace {
+
+// Capture keeps the device buffer drained, so it gets the most protection.
+// The render thread is raised too, but below the audio threads.
+struct Settings {
+  // Version 0 is reserved for threads that have never applied a policy
+  Settings() {
+    for (auto &version : versions) {
+      version.store(1, std::memory_order_relaxed);
+    }
+  }
+
+  std::mutex mutex;
+  std::array<ThreadPolicy, ROLE_COUNT> policies = {{
+      {ThreadPriority::RealTime, -1}, // Capture
+      {ThreadPriority::High, -1},     // Analysis
+      {ThreadPriority::Normal, -1},   // Geometry
+      {ThreadPriority::High, -1},     // Render
+  }};
+  std::array<std::string, ROLE_COUNT> applied;
+  std::array<std::atomic<std::uint64_t>, ROLE_COUNT> versions{};
+};
+
+Settings &settings() {
+  static Settings instance;
+  return instance;
+}
+
+size_t indexOf(ThreadRole role) { return static_cast<size_t>(role); }
+
+#if defined(__linux__)
+// SCHED_FIFO priorities; capture preempts the other real-time threads
+int realTimePriority(ThreadRole role) {
+  switch (role) {
+  case ThreadRole::Capture:
+    return 70;
+  case ThreadRole::Analysis:
+    return 60;
+  case ThreadRole::Render:
+    return 50;
+  default:
+    return 40;
+  }
+}
+
+// Nice value for High; applies to the calling thread only on Linux
+constexpr int HIGH_NICE = -10;
+#endif
+
+#if defined(_WIN32)
+// MMCSS registration of the calling thread, kept until its priority drops
+thread_local HANDLE mmcssHandle = nullptr;
+
+void revertMmcss() {
+  if (mmcssHandle) {
+    AvRevertMmThreadCharacteristics(mmcssHandle);
+    mmcssHandle = nullptr;
+  }
+}
+#endif
+
+// Set the calling thread's priority; returns what was granted
+ThreadPriority applyPriority(ThreadRole role, ThreadPriority priority,
+                             std::string &state) {
+#if defined(_WIN32)
+  if (priority == ThreadPriority::RealTime) {
+    if (!mmcssHandle) {
+      DWORD taskIndex = 0;
+      mmcssHandle = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
+    }
+    if (mmcssHandle && AvSetMmThreadPriority(mmcssHandle, AVRT_PRIORITY_HIGH)) {
+      state = "MMCSS Pro Audio";
+      return priority;
+    }
+    std::cerr << roleName(role) << " thread: MMCSS unavailable (error "
+              << GetLastError() << "), using high priority" << std::endl;
+    revertMmcss();
+    priority = ThreadPriority::High;
+  } else {
+    revertMmcss();
+  }
+
+  int level = priority == ThreadPriority::High ? THREAD_PRIORITY_HIGHEST
+                                               : THREAD_PRIORITY_NORMAL;
+  if (SetThreadPriority(GetCurrentThread(), level)) {
+    state = priority == ThreadPriority::High ? "Highest" : "Normal";
+    return priority;
+  }
+  std::cerr << roleName(role) << " thread: SetThreadPriority failed (error "
+            << GetLastError() << ")" << std::endl;
+  state = "Unchanged";
+  return ThreadPriority::Normal;
+#elif defined(__linux__)
+  if (priority == ThreadPriority::RealTime) {
+    sched_param param{};
+    param.sched_priority = realTimePriority(role);
+    int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (error == 0) {
+      state = "SCHED_FIFO " + std::to_string(param.sched_priority);
+      return priority;
+    }
+    std::cerr << roleName(role) << " thread: SCHED_FIFO unavailable ("
+              << std::strerror(error) << "), using high priority"
+              << std::endl;
+    priority = ThreadPriority::High;
+  }
+
+  // Back to the time-sharing class, then set the thread's own nice value
+  sched_param param{};
+  pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+  int nice = priority == ThreadPriority::High ? HIGH_NICE : 0;
+  pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+  if (setpriority(PRIO_PROCESS, static_cast<id_t>(tid), nice) == 0) {
+    state = "SCHED_OTHER nice " + std::to_string(nice);
+    return priority;
+  }
+  if (priority == ThreadPriority::High) {
+    std::cerr << roleName(role) << " thread: cannot raise priority ("
+              << std::strerror(errno) << "), using normal priority"
+              << std::endl;
+  }
+  state = "SCHED_OTHER";
+  return ThreadPriority::Normal;
+#else
+  (void)role;
+  state = "Default";
+  return ThreadPriority::Normal;
+#endif
+}
+
+// Pin the calling thread, or release it to every core
+bool applyAffinity(ThreadRole role, int core, std::string &state) {
+  if (core >= static_cast<int>(getCoreCount())) {
+    std::cerr << roleName(role) << " thread: no core " << core
+              << ", leaving unpinned" << std::endl;
+    core = -1;
+  }
+
+#if defined(_WIN32)
+  DWORD_PTR processMask = 0;
+  DWORD_PTR systemMask = 0;
+  if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask,
+                              &systemMask)) {
+    return false;
+  }
+  if (core >= static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+    std::cerr << roleName(role) << " thread: core " << core
+              << " is outside this process's processor group" << std::endl;
+    return false;
+  }
+  DWORD_PTR mask =
+      core < 0 ? processMask : (static_cast<DWORD_PTR>(1) << core);
+  if (!SetThreadAffinityMask(GetCurrentThread(), mask)) {
+    std::cerr << roleName(role) << " thread: cannot pin to core " << core
+              << " (error " << GetLastError() << ")" << std::endl;
+    return false;
+  }
+#elif defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (core < 0) {
+    for (unsigned int i = 0; i < getCoreCount(); ++i) {
+      CPU_SET(i, &set);
+    }
+  } else {
+    CPU_SET(static_cast<unsigned int>(core), &set);
+  }
+  int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (error != 0) {
+    std::cerr << roleName(role) << " thread: cannot pin to core " << core
+              << " (" << std::strerror(error) << ")" << std::endl;
+    return false;
+  }
+#else
+  if (core >= 0) {
+    return false;
+  }
+#endif
+
+  if (core >= 0) {
+    state += ", core " + std::to_string(core);
+  }
+  return true;
+}
+
+} // namespace
+
+const char *roleName(ThreadRole role) {
+  switch (role) {
+  case ThreadRole::Capture:
+    return "Capture";
+  case ThreadRole::Analysis:
+    return "Analysis";
+  case ThreadRole::Geometry:
+    return "Geometry";
+  case ThreadRole::Render:
+    return "Render";
+  default:
+    return "Unknown";
+  }
+}
+
+const char *priorityName(ThreadPriority priority) {
+  switch (priority) {
+  case ThreadPriority::High:
+    return "High";
+  case ThreadPriority::RealTime:
+    return "Real-time";
+  default:
+    return "Normal";
+  }
+}
+
+ThreadPolicy getPolicy(ThreadRole role) {
+  Settings &s = settings();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  return s.policies[indexOf(role)];
+}
+
+void setPolicy(ThreadRole role, const ThreadPolicy &policy) {
+  Settings &s = settings();
+  {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.policies[indexOf(role)] = policy;
+  }
+  s.versions[indexOf(role)].fetch_add(1, std::memory_order_release);
+}
+
+bool applyPolicy(ThreadRole role) {
+  ThreadPolicy policy = getPolicy(role);
+  std::string state;
+  ThreadPriority granted = applyPriority(role, policy.priority, state);
+  bool pinned = applyAffinity(role, policy.core, state);
+
+  Settings &s = settings();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  s.applied[indexOf(role)] = state;
+  return granted == policy.priority && pinned;
+}
+
+void refreshPolicy(ThreadRole role, std::uint64_t &seenVersion) {
+  std::uint64_t version =
+      settings().versions[indexOf(role)].load(std::memory_order_acquire);
+  if (version != seenVersion) {
+    seenVersion = version;
+    applyPolicy(role);
+  }
+}
+
+std::string getAppliedState(ThreadRole role) {
+  Settings &s = settings();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  return s.applied[indexOf(role)];
+}
+
+unsigned int getCoreCount() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+} // namespace threading
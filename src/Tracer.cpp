@@ -0,0 +1,266 @@
+#include "Tracer.h"
+#include "SpscRingBuffer.h"
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Events a thread can hold between flushes before it starts dropping
+static constexpr size_t THREAD_RING_EVENTS = 8192;
+
+// How often the flusher drains the rings
+static constexpr int FLUSH_INTERVAL_MS = 50;
+
+namespace trace {
+
+namespace detail {
+std::atomic<bool> enabled(false);
+}
+
+namespace {
+
+struct Event {
+  const char *name = nullptr;
+  Clock::time_point begin;
+  Clock::time_point end;
+};
+
+struct ThreadBuffer {
+  explicit ThreadBuffer(std::uint32_t id) : id(id) {}
+
+  SpscRingBuffer<Event> events{THREAD_RING_EVENTS};
+  std::uint32_t id;
+  const char *name = nullptr; // Guarded by the registry mutex
+  std::atomic<std::uint64_t> dropped{0};
+};
+
+// Every thread that has recorded an event. Buffers of exited threads are
+// dropped once drained; the flusher is the only consumer of the rings.
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  std::map<std::uint32_t, const char *> exitedNames;
+  std::uint32_t nextId = 1;
+
+  // Serialises start and stop
+  std::mutex controlMutex;
+  std::ofstream file;
+  std::string path;
+  Clock::time_point origin;
+  bool firstEvent = true;
+  std::uint64_t droppedAtStart = 0;
+
+  std::thread flusher;
+  std::mutex flushMutex;
+  std::condition_variable flushWake;
+  bool flushing = false;
+
+  // A trace still running at exit is finished rather than left truncated
+  ~Registry();
+};
+
+Registry &registry() {
+  static Registry instance;
+  return instance;
+}
+
+thread_local std::shared_ptr<ThreadBuffer> localBuffer;
+thread_local const char *localName = nullptr;
+
+ThreadBuffer &threadBuffer() {
+  if (!localBuffer) {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    localBuffer = std::make_shared<ThreadBuffer>(reg.nextId++);
+    localBuffer->name = localName;
+    reg.buffers.push_back(localBuffer);
+  }
+  return *localBuffer;
+}
+
+std::uint64_t totalDropped(Registry &reg) {
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  std::uint64_t total = 0;
+  for (const auto &buffer : reg.buffers) {
+    total += buffer->dropped.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+double microseconds(Clock::duration duration) {
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+// Write or discard everything waiting in the rings. Only one thread may
+// drain at a time: the flusher while it runs, start and stop otherwise.
+void drain(Registry &reg, bool write) {
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  {
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    buffers = reg.buffers;
+  }
+
+  Event event;
+  for (const auto &buffer : buffers) {
+    while (buffer->events.pop(event)) {
+      // Scopes opened before the trace started are incomplete
+      if (!write || event.begin < reg.origin) {
+        continue;
+      }
+      reg.file << (reg.firstEvent ? "\n" : ",\n") << "{\"name\":\""
+               << event.name << "\",\"ph\":\"X\",\"ts\":"
+               << microseconds(event.begin - reg.origin)
+               << ",\"dur\":" << microseconds(event.end - event.begin)
+               << ",\"pid\":1,\"tid\":" << buffer->id << "}";
+      reg.firstEvent = false;
+    }
+  }
+
+  buffers.clear();
+
+  // Forget threads that have exited, keeping their names for the metadata
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  for (auto it = reg.buffers.begin(); it != reg.buffers.end();) {
+    if (it->use_count() == 1 && (*it)->events.size() == 0) {
+      if ((*it)->name) {
+        reg.exitedNames[(*it)->id] = (*it)->name;
+      }
+      it = reg.buffers.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void flushLoop() {
+  Registry &reg = registry();
+  std::unique_lock<std::mutex> lock(reg.flushMutex);
+  while (reg.flushing) {
+    reg.flushWake.wait_for(lock,
+                           std::chrono::milliseconds(FLUSH_INTERVAL_MS));
+    lock.unlock();
+    drain(reg, true);
+    reg.file.flush();
+    lock.lock();
+  }
+}
+
+// Flush the remaining events and terminate the JSON
+void finish(Registry &reg) {
+  if (!reg.flusher.joinable()) {
+    return;
+  }
+
+  detail::enabled.store(false, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(reg.flushMutex);
+    reg.flushing = false;
+  }
+  reg.flushWake.notify_one();
+  reg.flusher.join();
+  drain(reg, true);
+
+  // Thread names as metadata events, so tracks are labelled
+  std::map<std::uint32_t, const char *> names;
+  {
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    names = reg.exitedNames;
+    for (const auto &buffer : reg.buffers) {
+      if (buffer->name) {
+        names[buffer->id] = buffer->name;
+      }
+    }
+  }
+  for (const auto &name : names) {
+    reg.file << (reg.firstEvent ? "\n" : ",\n")
+             << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+             << name.first << ",\"args\":{\"name\":\"" << name.second
+             << "\"}}";
+    reg.firstEvent = false;
+  }
+  reg.file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  reg.file.close();
+
+  std::cout << "Trace written to " << reg.path << " ("
+            << totalDropped(reg) - reg.droppedAtStart << " events dropped)"
+            << std::endl;
+}
+
+Registry::~Registry() { finish(*this); }
+
+} // namespace
+
+bool start(const std::string &path) {
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> control(reg.controlMutex);
+  if (reg.flusher.joinable()) {
+    return false;
+  }
+
+  reg.file.open(path, std::ios::out | std::ios::trunc);
+  if (!reg.file.is_open()) {
+    std::cerr << "Failed to open trace file " << path << std::endl;
+    return false;
+  }
+  reg.file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+  reg.path = path;
+  reg.firstEvent = true;
+  reg.exitedNames.clear();
+
+  // Leftovers from an earlier trace
+  drain(reg, false);
+  reg.droppedAtStart = totalDropped(reg);
+  reg.origin = Clock::now();
+
+  reg.flushing = true;
+  reg.flusher = std::thread(flushLoop);
+  detail::enabled.store(true, std::memory_order_relaxed);
+  std::cout << "Tracing to " << path << std::endl;
+  return true;
+}
+
+void stop() {
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> control(reg.controlMutex);
+  finish(reg);
+}
+
+std::string getPath() {
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> control(reg.controlMutex);
+  return reg.path;
+}
+
+std::uint64_t getDroppedEvents() {
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> control(reg.controlMutex);
+  return totalDropped(reg) - reg.droppedAtStart;
+}
+
+void setThreadName(const char *name) {
+  localName = name;
+  if (localBuffer) {
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    localBuffer->name = name;
+  }
+}
+
+void record(const char *name, Clock::time_point begin, Clock::time_point end) {
+  Event event;
+  event.name = name;
+  event.begin = begin;
+  event.end = end;
+  ThreadBuffer &buffer = threadBuffer();
+  if (!buffer.events.push(event)) {
+    buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+} // namespace trace
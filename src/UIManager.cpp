@@ -1,23 +1,52 @@
 #include "AudioVisualizer.h"
+#include "FrameScheduler.h"
+#include "QualityGovernor.h"
+#include "SessionRecorder.h"
+#include "SharedMemoryPublisher.h"
+#include "SmoothingCache.h"
+#include "ThreadConfig.h"
+#include "Tracer.h"
 #include "UIManager.h"
+#include "VideoRecorder.h"
+#include <algorithm>
+#include <ctime>
+#include <implot.h>
 #include <iostream>
 
 UIManager::UIManager(VisualizerConfig &config, ShaderConfig &shaderConfig)
     : config(config), shaderConfig(shaderConfig) {
-  refreshPresetList();
+  plottedTimers[static_cast<size_t>(perf::Timer::Frame)] = true;
 }
 
 UIManager::~UIManager() {}
 
 void UIManager::drawUI(float fps, float frameTime,
                        AudioVisualizer *visualizer) {
+  syncPresetLibrary(visualizer);
+
   // Create a single main debug window
   ImGui::Begin("Audio Visualizer Debug", nullptr,
                ImGuiWindowFlags_AlwaysAutoResize);
 
   // Performance metrics section
   if (ImGui::CollapsingHeader("Performance", ImGuiTreeNodeFlags_DefaultOpen)) {
-    drawPerformanceSection(fps, frameTime);
+    drawPerformanceSection(fps, frameTime, visualizer);
+  }
+
+  if (ImGui::CollapsingHeader("Stage Timings")) {
+    drawTimingSection(visualizer);
+  }
+
+  if (scheduler && ImGui::CollapsingHeader("Stage Scheduling")) {
+    drawSchedulerSection();
+  }
+
+  if (ImGui::CollapsingHeader("Threads")) {
+    drawThreadSection();
+  }
+
+  if (governor && ImGui::CollapsingHeader("Adaptive Quality")) {
+    drawQualitySection(visualizer);
   }
 
   ImGui::Separator();
@@ -30,8 +59,22 @@ void UIManager::drawUI(float fps, float frameTime,
 
   ImGui::Separator();
 
+  if (ImGui::CollapsingHeader("Spectrum Bars")) {
+    drawSpectrumBarsSection();
+  }
+
+  ImGui::Separator();
+
   // Waveform management sections (only if visualizer exists)
   if (visualizer) {
+    if (visualizer->getBeatAnalyzer()) {
+      if (ImGui::CollapsingHeader("Beat Detection")) {
+        drawBeatSection(visualizer);
+      }
+
+      ImGui::Separator();
+    }
+
     if (ImGui::CollapsingHeader("Waveforms", ImGuiTreeNodeFlags_DefaultOpen)) {
       drawWaveformListSection(visualizer);
     }
@@ -44,6 +87,12 @@ void UIManager::drawUI(float fps, float frameTime,
 
     ImGui::Separator();
 
+    if (ImGui::CollapsingHeader("Modulation")) {
+      drawModulationSection(visualizer);
+    }
+
+    ImGui::Separator();
+
     if (ImGui::CollapsingHeader("Preset Manager")) {
       drawPresetManagerSection(visualizer);
     }
@@ -52,9 +101,364 @@ void UIManager::drawUI(float fps, float frameTime,
   ImGui::End();
 }
 
-void UIManager::drawPerformanceSection(float fps, float frameTime) {
+// Frame rate of recorded video; matches the default render rate
+static constexpr unsigned int VIDEO_FRAME_RATE = 60;
+
+// Output file named for the time it was started
+static std::string timestampedFileName(const char *prefix,
+                                       const char *extension) {
+  std::time_t now = std::time(nullptr);
+  char stamp[32];
+  std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", std::localtime(&now));
+  return std::string(prefix) + stamp + extension;
+}
+
+void UIManager::drawPerformanceSection(float fps, float frameTime,
+                                       AudioVisualizer *visualizer) {
   ImGui::Text("FPS: %.1f", fps);
   ImGui::Text("Frame Time: %.2f ms", frameTime);
+
+  if (trace::isEnabled()) {
+    if (ImGui::Button("Stop Trace")) {
+      trace::stop();
+    }
+    ImGui::SameLine();
+    ImGui::Text("Recording %s (%llu dropped)", trace::getPath().c_str(),
+                static_cast<unsigned long long>(trace::getDroppedEvents()));
+  } else {
+    if (ImGui::Button("Start Trace")) {
+      trace::start(timestampedFileName("trace_", ".json"));
+    }
+    if (ImGui::IsItemHovered()) {
+      ImGui::SetTooltip("Record frame and thread activity as Chrome trace "
+                        "JSON, for Perfetto or chrome://tracing.");
+    }
+    if (!trace::getPath().empty()) {
+      ImGui::SameLine();
+      ImGui::TextDisabled("Last: %s", trace::getPath().c_str());
+    }
+  }
+
+  if (recorder) {
+    if (recorder->isRecording()) {
+      if (ImGui::Button("Stop Recording")) {
+        recorder->stop();
+      }
+      ImGui::SameLine();
+      ImGui::Text("%s: %.1f MB (%llu dropped)", recorder->getPath().c_str(),
+                  recorder->getBytesWritten() / (1024.0 * 1024.0),
+                  static_cast<unsigned long long>(
+                      recorder->getDroppedChunks()));
+    } else {
+      if (ImGui::Button("Record Session")) {
+        recorder->start(timestampedFileName("session_", ".atsession"));
+      }
+      if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Record captured audio and every configuration "
+                          "change. Replay with --replay <file>.");
+      }
+    }
+  }
+
+  if (videoRecorder && visualizer) {
+    if (videoRecorder->isRecording()) {
+      if (ImGui::Button("Stop Video")) {
+        videoRecorder->stop();
+      }
+      ImGui::SameLine();
+      ImGui::Text("%s: %llu frames", videoRecorder->getPath().c_str(),
+                  static_cast<unsigned long long>(
+                      videoRecorder->getFramesWritten()));
+      ImGui::Text("Readback %.2f ms, %llu dropped, %llu repeated",
+                  videoRecorder->getReadbackMs(),
+                  static_cast<unsigned long long>(
+                      videoRecorder->getFramesDropped()),
+                  static_cast<unsigned long long>(
+                      videoRecorder->getFramesRepeated()));
+    } else if (VideoRecorder::isAvailable()) {
+      if (ImGui::Button("Record Video")) {
+        videoRecorder->start(timestampedFileName("video_", ".y4m"),
+                             visualizer->getTrailSize(), VIDEO_FRAME_RATE);
+      }
+      if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Record the visualizer output, without the UI, as "
+                          "uncompressed Y4M at the trail resolution when "
+                          "recording starts. If Adaptive Quality resizes the "
+                          "trail, frames are scaled back to that size.");
+      }
+    } else {
+      ImGui::TextDisabled("Video recording unavailable");
+    }
+  }
+
+  if (publisher) {
+    bool sharing = publisher->isOpen();
+    if (ImGui::Checkbox("Share Analysis", &sharing)) {
+      if (sharing) {
+        publisher->open();
+      } else {
+        publisher->close();
+      }
+    }
+    if (ImGui::IsItemHovered()) {
+      ImGui::SetTooltip("Publish waveform, spectrum, bands and beat state to "
+                        "shared memory for other local programs. See "
+                        "tools/shm_reader.");
+    }
+    if (publisher->isOpen()) {
+      ImGui::SameLine();
+      ImGui::Text("%s: %llu frames", publisher->getName().c_str(),
+                  static_cast<unsigned long long>(
+                      publisher->getFramesPublished()));
+    }
+  }
+
+  if (!visualizer) {
+    return;
+  }
+
+  bool pipelined = visualizer->isGeometryPipelined();
+  if (ImGui::Checkbox("Pipelined CPU Geometry", &pipelined)) {
+    visualizer->setGeometryPipelined(pipelined);
+  }
+  if (ImGui::IsItemHovered()) {
+    ImGui::SetTooltip("Build CPU waveform vertices on a worker thread while "
+                      "the previous frame is drawn. Adds one frame of "
+                      "latency.");
+  }
+
+  if (!visualizer->isGpuGeometryAvailable()) {
+    ImGui::TextDisabled("GPU waveform geometry unavailable");
+    return;
+  }
+
+  bool gpuGeometry = visualizer->isGpuGeometryEnabled();
+  if (ImGui::Checkbox("GPU Waveform Geometry", &gpuGeometry)) {
+    visualizer->setGpuGeometryEnabled(gpuGeometry);
+  }
+  if (ImGui::IsItemHovered()) {
+    ImGui::SetTooltip("Build waveform vertices in a vertex shader from the "
+                      "uploaded samples. Turn off to compare with the CPU "
+                      "path.");
+  }
+}
+
+// Last, p50, p95 and p99 of a timing, or dashes before its first sample
+static void timingColumns(const perf::RollingHistogram &histogram) {
+  if (histogram.getCount() == 0) {
+    for (int i = 0; i < 4; ++i) {
+      ImGui::TableNextColumn();
+      ImGui::TextDisabled("-");
+    }
+    return;
+  }
+  ImGui::TableNextColumn();
+  ImGui::Text("%.2f", histogram.getLatest());
+  ImGui::TableNextColumn();
+  ImGui::Text("%.2f", histogram.percentile(0.5f));
+  ImGui::TableNextColumn();
+  ImGui::Text("%.2f", histogram.percentile(0.95f));
+  ImGui::TableNextColumn();
+  ImGui::Text("%.2f", histogram.percentile(0.99f));
+}
+
+void UIManager::drawTimingSection(AudioVisualizer *visualizer) {
+  ImGui::TextDisabled("Milliseconds over the last %zu samples",
+                      perf::RollingHistogram::WINDOW);
+
+  if (ImGui::BeginTable("Timings", 6,
+                        ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                            ImGuiTableFlags_SizingFixedFit)) {
+    ImGui::TableSetupColumn("Stage");
+    ImGui::TableSetupColumn("Last");
+    ImGui::TableSetupColumn("p50");
+    ImGui::TableSetupColumn("p95");
+    ImGui::TableSetupColumn("p99");
+    ImGui::TableSetupColumn("GPU p95");
+    ImGui::TableHeadersRow();
+
+    for (size_t i = 0; i < perf::TIMER_COUNT; ++i) {
+      perf::Timer timer = static_cast<perf::Timer>(i);
+      const perf::RollingHistogram &gpu = perf::gpuTimes(timer);
+      ImGui::PushID(static_cast<int>(i));
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      bool plotted = plottedTimers[i];
+      if (ImGui::Checkbox(perf::timerName(timer), &plotted)) {
+        plottedTimers[i] = plotted;
+      }
+      timingColumns(perf::cpuTimes(timer));
+      ImGui::TableNextColumn();
+      if (gpu.getCount() > 0) {
+        ImGui::Text("%.2f", gpu.percentile(0.95f));
+      } else {
+        ImGui::TextDisabled("-");
+      }
+      ImGui::PopID();
+    }
+    ImGui::EndTable();
+  }
+
+  if (ImPlot::BeginPlot("##Timing history", ImVec2(-1, 180))) {
+    ImPlot::SetupAxes("Sample", "ms", ImPlotAxisFlags_AutoFit,
+                      ImPlotAxisFlags_AutoFit);
+    for (size_t i = 0; i < perf::TIMER_COUNT; ++i) {
+      if (!plottedTimers[i]) {
+        continue;
+      }
+      perf::Timer timer = static_cast<perf::Timer>(i);
+      perf::cpuTimes(timer).copyRecent(timingSamples);
+      ImPlot::PlotLine(perf::timerName(timer), timingSamples.data(),
+                       static_cast<int>(timingSamples.size()));
+
+      perf::gpuTimes(timer).copyRecent(timingSamples);
+      if (!timingSamples.empty()) {
+        std::string label = std::string(perf::timerName(timer)) + " (GPU)";
+        ImPlot::PlotLine(label.c_str(), timingSamples.data(),
+                         static_cast<int>(timingSamples.size()));
+      }
+    }
+    ImPlot::EndPlot();
+  }
+
+  if (!visualizer || visualizer->getWaveformCount() == 0 ||
+      !ImGui::TreeNode("Per-Waveform Geometry")) {
+    return;
+  }
+  size_t count =
+      std::min(visualizer->getWaveformCount(), perf::MAX_TIMED_WAVEFORMS);
+  if (ImGui::BeginTable("Waveform Timings", 5,
+                        ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                            ImGuiTableFlags_SizingFixedFit)) {
+    ImGui::TableSetupColumn("Waveform");
+    ImGui::TableSetupColumn("Last");
+    ImGui::TableSetupColumn("p50");
+    ImGui::TableSetupColumn("p95");
+    ImGui::TableSetupColumn("p99");
+    ImGui::TableHeadersRow();
+    for (size_t i = 0; i < count; ++i) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Text("%zu", i + 1);
+      timingColumns(*perf::waveformTimes(i));
+    }
+    ImGui::EndTable();
+  }
+  ImGui::TextDisabled("CPU geometry only; the GPU path has no per-waveform "
+                      "cost");
+  ImGui::TreePop();
+}
+
+void UIManager::drawSchedulerSection() {
+  for (size_t i = 0; i < scheduler->getStageCount(); ++i) {
+    const FrameScheduler::Stage &stage = scheduler->getStage(i);
+    ImGui::PushID(static_cast<int>(i));
+
+    // Cost over budget shows in red
+    bool overBudget = stage.budgetMs > 0.0f && stage.meanMs > stage.budgetMs;
+    ImGui::TextColored(overBudget ? ImVec4(1.0f, 0.5f, 0.4f, 1.0f)
+                                  : ImVec4(0.6f, 1.0f, 0.6f, 1.0f),
+                       "%s: %.1f Hz, %.2f ms (budget %.1f ms), %.2f ms late",
+                       stage.name.c_str(), stage.measuredHz, stage.meanMs,
+                       stage.budgetMs, stage.meanLateMs);
+    if (ImGui::IsItemHovered()) {
+      ImGui::SetTooltip("Late: how long after it was due a run starts, "
+                        "waiting for other stages or the display\nRuns: "
+                        "%llu\nOver budget: %llu\nMissed: %llu",
+                        static_cast<unsigned long long>(stage.runs),
+                        static_cast<unsigned long long>(stage.overruns),
+                        static_cast<unsigned long long>(stage.missed));
+    }
+
+    float rate = stage.rateHz;
+    if (ImGui::SliderFloat("Rate", &rate, 5.0f, 500.0f, "%.0f Hz")) {
+      scheduler->setRate(i, rate);
+    }
+    float budget = stage.budgetMs;
+    if (ImGui::SliderFloat("Budget", &budget, 0.1f, 20.0f, "%.1f ms")) {
+      scheduler->setBudget(i, budget);
+    }
+
+    ImGui::PopID();
+  }
+}
+
+void UIManager::drawThreadSection() {
+  static const char *priorities[] = {"Normal", "High", "Real-time"};
+  int lastCore = static_cast<int>(threading::getCoreCount()) - 1;
+
+  for (size_t i = 0; i < threading::ROLE_COUNT; ++i) {
+    ThreadRole role = static_cast<ThreadRole>(i);
+    ThreadPolicy policy = threading::getPolicy(role);
+    ImGui::PushID(static_cast<int>(i));
+
+    std::string state = threading::getAppliedState(role);
+    ImGui::Text("%s: %s", threading::roleName(role),
+                state.empty() ? "not started" : state.c_str());
+
+    bool changed = false;
+    int priority = static_cast<int>(policy.priority);
+    if (ImGui::Combo("Priority", &priority, priorities, 3)) {
+      policy.priority = static_cast<ThreadPriority>(priority);
+      changed = true;
+    }
+    if (ImGui::SliderInt("Core", &policy.core, -1, lastCore,
+                         policy.core < 0 ? "Any" : "%d")) {
+      changed = true;
+    }
+    if (changed) {
+      threading::setPolicy(role, policy);
+    }
+
+    ImGui::PopID();
+  }
+  ImGui::TextDisabled("Refused requests fall back to a lower priority; "
+                      "see the console");
+}
+
+void UIManager::drawQualitySection(AudioVisualizer *visualizer) {
+  bool enabled = governor->isEnabled();
+  if (ImGui::Checkbox("Adapt Quality", &enabled)) {
+    governor->setEnabled(enabled);
+    if (visualizer) {
+      visualizer->setQuality(governor->getQuality());
+    }
+  }
+  if (ImGui::IsItemHovered()) {
+    ImGui::SetTooltip("Lower waveform detail, trail resolution and blur "
+                      "samples when frames take longer than the target, "
+                      "and restore them when there is headroom.");
+  }
+
+  float target = governor->getTargetMs();
+  if (ImGui::SliderFloat("Target", &target, 2.0f, 50.0f, "%.2f ms")) {
+    governor->setTargetMs(target);
+  }
+  if (ImGui::Button("60 Hz")) {
+    governor->setTargetMs(1000.0f / 60.0f);
+  }
+  ImGui::SameLine();
+  if (ImGui::Button("144 Hz")) {
+    governor->setTargetMs(1000.0f / 144.0f);
+  }
+
+  const RenderQuality &quality = governor->getQuality();
+  ImGui::Text("Level %zu of %zu, frame work %.2f ms", governor->getLevel(),
+              QualityGovernor::ladder().size() - 1, governor->getAverageMs());
+  ImGui::Text("Points x%d, thick step %.1f px, trail %.0f%%, blur %d",
+              quality.pointMultiplier, quality.thickStep,
+              quality.trailScale * 100.0f, quality.jitterSamples);
+
+  if (governor->getDecisions().empty()) {
+    return;
+  }
+  ImGui::Text("Recent changes:");
+  for (auto it = governor->getDecisions().rbegin();
+       it != governor->getDecisions().rend(); ++it) {
+    ImGui::BulletText("Frame %llu: %zu -> %zu (%.2f / %.2f ms)",
+                      static_cast<unsigned long long>(it->frame),
+                      it->fromLevel, it->toLevel, it->averageMs, it->targetMs);
+  }
 }
 
 void UIManager::drawShaderEffectsSection() {
@@ -86,6 +490,54 @@ void UIManager::drawShaderEffectsSection() {
   }
 }
 
+void UIManager::drawSpectrumBarsSection() {
+  ImGui::Checkbox("Show Bars", &config.bars);
+  ImGui::SliderInt("Bands", &config.barCount, 8, 256);
+  if (ImGui::IsItemHovered()) {
+    ImGui::SetTooltip("Log-spaced bands from 30 Hz to 16 kHz");
+  }
+  ImGui::SliderFloat("Bar Height", &config.barHeight, 10.0f, 600.0f, "%.0f");
+  ImGui::SliderFloat("Bar Radius", &config.barRadiusFactor, 0.1f, 1.0f,
+                     "%.2f");
+  ImGui::SliderFloat("Bar Attack", &config.barAttack, 0.0f, 0.2f, "%.3f s");
+  ImGui::SliderFloat("Bar Release", &config.barRelease, 0.0f, 1.0f, "%.2f s");
+}
+
+void UIManager::drawBeatSection(AudioVisualizer *visualizer) {
+  const BeatAnalyzer &analyzer = *visualizer->getBeatAnalyzer();
+
+  ImGui::Text("Tempo: %.1f BPM (confidence %.2f)", analyzer.getBpm(),
+              analyzer.getConfidence());
+
+  float phase = visualizer->getBeatPhase();
+  if (phase >= 0.0f) {
+    ImGui::ProgressBar(phase, ImVec2(-1.0f, 0.0f), "Beat phase");
+  } else {
+    ImGui::TextDisabled("No beat tracked");
+  }
+
+  // Pulses land late once detection takes longer than this
+  constexpr float TARGET_DELAY_MS = 20.0f;
+  float maxDelay = analyzer.getMaxDelayMs();
+  ImVec4 delayColor = maxDelay <= TARGET_DELAY_MS
+                          ? ImVec4(0.6f, 1.0f, 0.6f, 1.0f)
+                          : ImVec4(1.0f, 0.5f, 0.4f, 1.0f);
+  ImGui::TextColored(delayColor, "Onset delay: %.1f ms avg, %.1f ms max",
+                     analyzer.getMeanDelayMs(), maxDelay);
+  if (ImGui::IsItemHovered()) {
+    ImGui::SetTooltip("From audio capture to the onset event being "
+                      "published. Target: under %.0f ms.",
+                      TARGET_DELAY_MS);
+  }
+
+  if (analyzer.getDroppedSamples() > 0) {
+    ImGui::Text("Dropped samples: %llu",
+                static_cast<unsigned long long>(analyzer.getDroppedSamples()));
+  }
+
+  ImGui::SliderFloat("Beat Pulse", &config.beatPulse, 0.0f, 0.5f, "%.2f");
+}
+
 void UIManager::drawWaveformListSection(AudioVisualizer *visualizer) {
   size_t waveformCount = visualizer->getWaveformCount();
   ImGui::Text("Waveforms: %zu", waveformCount);
@@ -119,11 +571,11 @@ void UIManager::drawWaveformListSection(AudioVisualizer *visualizer) {
 
   // List of waveforms
   for (size_t i = 0; i < waveformCount; ++i) {
-    Waveform *waveform = visualizer->getWaveform(i);
-    if (!waveform)
+    WaveformConfig *waveConfig = visualizer->getWaveformConfig(i);
+    if (!waveConfig)
       continue;
 
-    bool enabled = waveform->getConfig().enabled;
+    bool enabled = waveConfig->enabled;
     char label[64];
     snprintf(label, sizeof(label), "Waveform %zu %s", i,
              enabled ? "[ON]" : "[OFF]");
@@ -142,15 +594,16 @@ void UIManager::drawWaveformSettingsSection(AudioVisualizer *visualizer) {
     return;
   }
 
-  Waveform *waveform = visualizer->getWaveform(selectedWaveformIndex);
-  if (!waveform) {
+  WaveformConfig *selectedConfig =
+      visualizer->getWaveformConfig(selectedWaveformIndex);
+  if (!selectedConfig) {
     return;
   }
 
   ImGui::Text("Editing Waveform %d", selectedWaveformIndex);
   ImGui::Spacing();
 
-  WaveformConfig &waveConfig = waveform->getConfig();
+  WaveformConfig &waveConfig = *selectedConfig;
 
   ImGui::Checkbox("Enabled", &waveConfig.enabled);
 
@@ -164,6 +617,12 @@ void UIManager::drawWaveformSettingsSection(AudioVisualizer *visualizer) {
     // Updated
   }
 
+  ImGui::SliderInt("Smoothing Passes", &waveConfig.smoothingPasses, 1,
+                   SmoothingCache::MAX_PASSES);
+  if (ImGui::IsItemHovered()) {
+    ImGui::SetTooltip("1 = box average, 2 = triangle, 3+ = close to Gaussian");
+  }
+
   float rotationSpeed = waveConfig.rotationSpeed;
   if (ImGui::SliderFloat("Rotation Speed", &rotationSpeed, -2.0f, 2.0f)) {
     waveConfig.rotationSpeed = rotationSpeed;
@@ -193,6 +652,96 @@ void UIManager::drawWaveformSettingsSection(AudioVisualizer *visualizer) {
   if (ImGui::SliderInt("Thick Alpha", &thickAlpha, 0, 255)) {
     waveConfig.thickAlpha = static_cast<sf::Uint8>(thickAlpha);
   }
+
+  static const char *interpolationNames[] = {"None", "Linear", "Cubic",
+                                             "Catmull-Rom"};
+  int interpolation = static_cast<int>(waveConfig.getInterpolation());
+  if (ImGui::Combo("Interpolation", &interpolation, interpolationNames, 4)) {
+    waveConfig.interpolation = interpolation;
+  }
+}
+
+void UIManager::drawModulationSection(AudioVisualizer *visualizer) {
+  ModulationMatrix &matrix = visualizer->getModulation();
+  ModulationSettings settings = matrix.getSettings();
+  bool changed = false;
+
+  ImGui::Text("Routes: %zu (%zu after expanding to every waveform)",
+              settings.routes.size(), matrix.getCompiledRouteCount());
+
+  for (size_t i = 0; i < ModulationSettings::LFO_COUNT; ++i) {
+    char label[32];
+    snprintf(label, sizeof(label), "LFO %zu Rate", i + 1);
+    changed |= ImGui::SliderFloat(label, &settings.lfoRates[i], 0.01f, 10.0f,
+                                  "%.2f Hz");
+  }
+
+  if (ImGui::Button("Add Route")) {
+    settings.routes.push_back(ModulationRoute());
+    changed = true;
+  }
+
+  std::array<const char *, static_cast<size_t>(ModSource::Count)> sources;
+  for (size_t i = 0; i < sources.size(); ++i) {
+    sources[i] = sourceName(static_cast<ModSource>(i));
+  }
+  std::array<const char *, static_cast<size_t>(ModCurve::Count)> curves;
+  for (size_t i = 0; i < curves.size(); ++i) {
+    curves[i] = curveName(static_cast<ModCurve>(i));
+  }
+  std::array<const char *, static_cast<size_t>(ModTarget::Count)> targets;
+  for (size_t i = 0; i < targets.size(); ++i) {
+    targets[i] = targetInfo(static_cast<ModTarget>(i)).name;
+  }
+
+  const int lastWaveform = static_cast<int>(visualizer->getWaveformCount()) - 1;
+  size_t removeIndex = settings.routes.size();
+  for (size_t i = 0; i < settings.routes.size(); ++i) {
+    ModulationRoute &route = settings.routes[i];
+    ImGui::PushID(static_cast<int>(i));
+    ImGui::Separator();
+
+    changed |= ImGui::Checkbox("Enabled", &route.enabled);
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Remove")) {
+      removeIndex = i;
+    }
+
+    changed |= ImGui::Combo("Source", &route.source, sources.data(),
+                            static_cast<int>(sources.size()));
+    if (route.getSource() == ModSource::Band) {
+      changed |= ImGui::SliderInt("Band", &route.band, 0,
+                                  std::max(config.barCount - 1, 0));
+    }
+    ImGui::ProgressBar(matrix.getSourceValue(route.getSource(), route.band),
+                       ImVec2(-1.0f, 0.0f), "Source level");
+
+    changed |= ImGui::Combo("Curve", &route.curve, curves.data(),
+                            static_cast<int>(curves.size()));
+    changed |= ImGui::Combo("Target", &route.target, targets.data(),
+                            static_cast<int>(targets.size()));
+    if (!route.isShaderTarget()) {
+      changed |= ImGui::SliderInt("Waveform", &route.waveform, -1,
+                                  std::max(lastWaveform, -1),
+                                  route.waveform < 0 ? "All" : "%d");
+    }
+    changed |= ImGui::SliderFloat("Depth", &route.depth, -1.0f, 1.0f, "%.2f");
+    if (ImGui::IsItemHovered()) {
+      ImGui::SetTooltip("Fraction of the target's range added at full "
+                        "source level");
+    }
+
+    ImGui::PopID();
+  }
+
+  if (removeIndex < settings.routes.size()) {
+    settings.routes.erase(settings.routes.begin() + removeIndex);
+    changed = true;
+  }
+
+  if (changed) {
+    matrix.setSettings(settings);
+  }
 }
 
 void UIManager::drawPresetManagerSection(AudioVisualizer *visualizer) {
@@ -222,6 +771,15 @@ void UIManager::drawPresetManagerSection(AudioVisualizer *visualizer) {
     refreshPresetList();
   }
 
+  ImGui::SliderFloat("Crossfade (s)", &presetCrossfadeTime, 0.0f, 10.0f,
+                     "%.1f");
+
+  if (visualizer->isPresetLoading()) {
+    ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.3f, 1.0f), "Loading preset...");
+  } else if (visualizer->isCrossfading()) {
+    ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.3f, 1.0f), "Crossfading...");
+  }
+
   if (availablePresets.empty()) {
     ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "No presets found");
   } else {
@@ -251,54 +809,77 @@ void UIManager::drawPresetManagerSection(AudioVisualizer *visualizer) {
                      "Tip: Double-click to load");
 }
 
+void UIManager::syncPresetLibrary(AudioVisualizer *visualizer) {
+  std::uint64_t version = presetLibrary.getVersion();
+  if (version != presetListVersion) {
+    presetListVersion = version;
+
+    // Keep the same file selected wherever it moved to in the new list
+    std::string selected;
+    if (selectedPresetIndex >= 0 &&
+        selectedPresetIndex < static_cast<int>(availablePresets.size())) {
+      selected = availablePresets[selectedPresetIndex];
+    }
+    availablePresets = presetLibrary.getPresetNames();
+    auto it = std::find(availablePresets.begin(), availablePresets.end(),
+                        selected);
+    selectedPresetIndex =
+        it != availablePresets.end() && !selected.empty()
+            ? static_cast<int>(it - availablePresets.begin())
+            : -1;
+  }
+
+  // Edits to the active preset's file are applied live
+  for (const std::string &filename : presetLibrary.takeChangedPresets()) {
+    if (filename == suppressReloadOf) {
+      suppressReloadOf.clear();
+      continue;
+    }
+
+    VisualizerPreset preset;
+    if (visualizer && filename == activePresetFile &&
+        presetLibrary.getPreset(filename, preset)) {
+      std::cout << "Preset file changed, re-applying: " << filename
+                << std::endl;
+      visualizer->applyPresetAsync(preset, 0.0f);
+    }
+  }
+}
+
 void UIManager::refreshPresetList() {
-  availablePresets = ConfigSerializer::getAvailablePresets("presets");
+  // The library tracks the directory itself; this forces a full rescan in
+  // case changes were missed
+  presetLibrary.rescan();
 }
 
 void UIManager::saveCurrentPreset(AudioVisualizer *visualizer,
                                   const std::string &name) {
-  VisualizerPreset preset;
-  preset.name = name;
-  preset.visualizerConfig = config;
-  preset.shaderConfig = shaderConfig;
-
-  // Collect all waveform configurations
-  for (size_t i = 0; i < visualizer->getWaveformCount(); ++i) {
-    Waveform *waveform = visualizer->getWaveform(i);
-    if (waveform) {
-      preset.waveforms.push_back(waveform->getConfig());
-    }
-  }
+  VisualizerPreset preset = visualizer->getCurrentPreset(name);
 
-  std::string filename = "presets/" + name + ".json";
-  if (ConfigSerializer::savePreset(filename, preset)) {
+  // Changes are taken on this thread, so the change this save causes
+  // is still to come when it returns
+  std::string filename = name + ".json";
+  if (ConfigSerializer::savePreset("presets/" + filename, preset)) {
     std::cout << "Preset saved successfully!" << std::endl;
+    if (filename == activePresetFile) {
+      suppressReloadOf = filename;
+    }
   }
 }
 
 void UIManager::loadPreset(AudioVisualizer *visualizer,
                            const std::string &filename) {
+  // The scene is built off-thread and swapped in by the visualizer at a
+  // frame boundary, so loading never stalls rendering. Indexed presets are
+  // already parsed; anything else is read from disk on the worker.
   VisualizerPreset preset;
-  std::string filepath = "presets/" + filename;
-
-  if (ConfigSerializer::loadPreset(filepath, preset)) {
-    // Apply configurations
-    config = preset.visualizerConfig;
-    shaderConfig = preset.shaderConfig;
-
-    // Clear existing waveforms
-    while (visualizer->getWaveformCount() > 0) {
-      visualizer->removeWaveform(0);
-    }
-
-    // Add loaded waveforms
-    for (const auto &waveConfig : preset.waveforms) {
-      visualizer->addWaveform(waveConfig);
-    }
-
-    // Reset selected waveform index
-    selectedWaveformIndex = 0;
-
-    std::cout << "Preset loaded successfully: " << preset.name << std::endl;
+  if (presetLibrary.getPreset(filename, preset)) {
+    visualizer->applyPresetAsync(preset, presetCrossfadeTime);
+  } else {
+    visualizer->loadPresetAsync("presets/" + filename, presetCrossfadeTime);
   }
+  activePresetFile = filename;
+
+  // Reset selected waveform index
+  selectedWaveformIndex = 0;
 }
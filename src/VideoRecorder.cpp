@@ -0,0 +1,395 @@
+#include "VideoRecorder.h"
+#include "Tracer.h"
+#include <SFML/OpenGL.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+// ARB_pixel_buffer_object and ARB_sync; core since OpenGL 2.1 and 3.2 but
+// absent from the 1.1 headers
+static constexpr GLenum PIXEL_PACK_BUFFER = 0x88EB;
+static constexpr GLenum STREAM_READ = 0x88E1;
+static constexpr GLenum READ_ONLY = 0x88B8;
+static constexpr GLenum SYNC_GPU_COMMANDS_COMPLETE = 0x9117;
+static constexpr GLenum ALREADY_SIGNALED = 0x911A;
+static constexpr GLenum CONDITION_SATISFIED = 0x911C;
+static constexpr GLbitfield SYNC_FLUSH_COMMANDS_BIT = 0x00000001;
+
+// How long stop() waits for each outstanding readback
+static constexpr unsigned long long STOP_WAIT_NS = 1000000000ull;
+
+// Longest run of repeated frames written for one gap
+static constexpr std::int64_t MAX_REPEATS = 600;
+
+namespace {
+
+struct PixelBufferFunctions {
+  using GenBuffers = void(APIENTRY *)(GLsizei, GLuint *);
+  using DeleteBuffers = void(APIENTRY *)(GLsizei, const GLuint *);
+  using BindBuffer = void(APIENTRY *)(GLenum, GLuint);
+  using BufferData = void(APIENTRY *)(GLenum, std::ptrdiff_t, const void *,
+                                      GLenum);
+  using MapBuffer = void *(APIENTRY *)(GLenum, GLenum);
+  using UnmapBuffer = GLboolean(APIENTRY *)(GLenum);
+  using FenceSync = void *(APIENTRY *)(GLenum, GLbitfield);
+  using ClientWaitSync = GLenum(APIENTRY *)(void *, GLbitfield,
+                                            unsigned long long);
+  using DeleteSync = void(APIENTRY *)(void *);
+
+  GenBuffers genBuffers = nullptr;
+  DeleteBuffers deleteBuffers = nullptr;
+  BindBuffer bindBuffer = nullptr;
+  BufferData bufferData = nullptr;
+  MapBuffer mapBuffer = nullptr;
+  UnmapBuffer unmapBuffer = nullptr;
+  FenceSync fenceSync = nullptr;
+  ClientWaitSync clientWaitSync = nullptr;
+  DeleteSync deleteSync = nullptr;
+  bool loaded = false;
+};
+
+template <typename F> F load(const char *name) {
+  return reinterpret_cast<F>(sf::Context::getFunction(name));
+}
+
+const PixelBufferFunctions &pixelBuffers() {
+  static const PixelBufferFunctions functions = [] {
+    using P = PixelBufferFunctions;
+    P f;
+    if (!sf::Context::isExtensionAvailable("GL_ARB_pixel_buffer_object") ||
+        !sf::Context::isExtensionAvailable("GL_ARB_sync")) {
+      return f;
+    }
+    f.genBuffers = load<P::GenBuffers>("glGenBuffers");
+    f.deleteBuffers = load<P::DeleteBuffers>("glDeleteBuffers");
+    f.bindBuffer = load<P::BindBuffer>("glBindBuffer");
+    f.bufferData = load<P::BufferData>("glBufferData");
+    f.mapBuffer = load<P::MapBuffer>("glMapBuffer");
+    f.unmapBuffer = load<P::UnmapBuffer>("glUnmapBuffer");
+    f.fenceSync = load<P::FenceSync>("glFenceSync");
+    f.clientWaitSync = load<P::ClientWaitSync>("glClientWaitSync");
+    f.deleteSync = load<P::DeleteSync>("glDeleteSync");
+    f.loaded = f.genBuffers && f.deleteBuffers && f.bindBuffer &&
+               f.bufferData && f.mapBuffer && f.unmapBuffer && f.fenceSync &&
+               f.clientWaitSync && f.deleteSync;
+    return f;
+  }();
+  return functions;
+}
+
+// BT.601 studio range
+inline std::uint8_t toY(int r, int g, int b) {
+  return static_cast<std::uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) +
+                                   16);
+}
+inline std::uint8_t toCb(int r, int g, int b) {
+  return static_cast<std::uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) +
+                                   128);
+}
+inline std::uint8_t toCr(int r, int g, int b) {
+  return static_cast<std::uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) +
+                                   128);
+}
+
+} // namespace
+
+VideoRecorder::VideoRecorder() = default;
+
+VideoRecorder::~VideoRecorder() { stop(); }
+
+bool VideoRecorder::isAvailable() { return pixelBuffers().loaded; }
+
+bool VideoRecorder::start(const std::string &outputPath, sf::Vector2u frameSize,
+                          unsigned int framesPerSecond) {
+  if (recording) {
+    return false;
+  }
+  if (!isAvailable()) {
+    std::cerr << "Video recording needs pixel buffer objects and sync objects"
+              << std::endl;
+    return false;
+  }
+  if (frameSize.x == 0 || frameSize.y == 0 || framesPerSecond == 0) {
+    return false;
+  }
+
+  file = std::fopen(outputPath.c_str(), "wb");
+  if (!file) {
+    std::cerr << "Failed to open video file: " << outputPath << std::endl;
+    return false;
+  }
+  // The writer fills whole frames itself; stdio buffering would only copy
+  std::setvbuf(file, nullptr, _IONBF, 0);
+  std::fprintf(file, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C444\n", frameSize.x,
+               frameSize.y, framesPerSecond);
+
+  path = outputPath;
+  size = frameSize;
+  const size_t pixels = static_cast<size_t>(size.x) * size.y;
+  planes.resize(pixels * 3);
+
+  // Only this thread touches the rings until the writer starts
+  Frame *ignored = nullptr;
+  while (full.pop(ignored)) {
+  }
+  while (empty.pop(ignored)) {
+  }
+  frames.resize(FRAME_COUNT);
+  for (Frame &frame : frames) {
+    frame.pixels.resize(pixels * 4);
+    empty.push(&frame);
+  }
+
+  nextTransfer = 0;
+  oldestTransfer = 0;
+  inFlight = 0;
+  origin = std::chrono::steady_clock::now();
+  period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(1.0 / framesPerSecond));
+  nextIndex = 0;
+  writtenIndex = -1;
+  framesWritten = 0;
+  framesRepeated = 0;
+  framesDropped = 0;
+  readbackMs = 0.0f;
+
+  recording = true;
+  writing = true;
+  writer = std::thread(&VideoRecorder::writeLoop, this);
+  std::cout << "Recording video to " << path << std::endl;
+  return true;
+}
+
+void VideoRecorder::stop() {
+  if (!recording) {
+    return;
+  }
+  recording = false;
+
+  {
+    // Buffers and fences are shared between contexts, so any will do
+    sf::Context context;
+    while (inFlight > 0) {
+      collect(transfers[oldestTransfer], true);
+    }
+    releaseTransfers();
+  }
+
+  writing = false;
+  if (writer.joinable()) {
+    writer.join();
+  }
+  if (file) {
+    std::fclose(file);
+    file = nullptr;
+  }
+  std::cout << "Video recording stopped: " << framesWritten.load()
+            << " frames (" << framesRepeated.load() << " repeated, "
+            << framesDropped << " dropped)" << std::endl;
+}
+
+void VideoRecorder::capture(sf::RenderTexture &texture) {
+  if (!recording) {
+    return;
+  }
+  TRACE_SCOPE("Video readback");
+  const PixelBufferFunctions &gl = pixelBuffers();
+  texture.setActive(true);
+
+  if (transfers[0].buffer == 0) {
+    const std::ptrdiff_t bytes =
+        static_cast<std::ptrdiff_t>(size.x) * size.y * 4;
+    for (Transfer &transfer : transfers) {
+      gl.genBuffers(1, &transfer.buffer);
+      gl.bindBuffer(PIXEL_PACK_BUFFER, transfer.buffer);
+      gl.bufferData(PIXEL_PACK_BUFFER, bytes, nullptr, STREAM_READ);
+    }
+    gl.bindBuffer(PIXEL_PACK_BUFFER, 0);
+  }
+
+  // Oldest first, stopping at the first the GPU has not finished
+  while (inFlight > 0 && collect(transfers[oldestTransfer], false)) {
+  }
+
+  // One frame per period of the video; extra rendered frames are skipped
+  const auto now = std::chrono::steady_clock::now();
+  const std::int64_t index = (now - origin) / period;
+  if (index < nextIndex) {
+    return;
+  }
+  nextIndex = index + 1;
+
+  if (inFlight == TRANSFER_COUNT) {
+    ++framesDropped;
+    return;
+  }
+
+  // A resized texture is read back through a copy at the recorded size
+  if (texture.getSize() != size && !scaleToRecordedSize(texture)) {
+    std::cerr << "Failed to scale video frames to " << size.x << "x"
+              << size.y << ", stopping the recording" << std::endl;
+    stop();
+    return;
+  }
+
+  Transfer &transfer = transfers[nextTransfer];
+  gl.bindBuffer(PIXEL_PACK_BUFFER, transfer.buffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, static_cast<GLsizei>(size.x),
+               static_cast<GLsizei>(size.y), GL_RGBA, GL_UNSIGNED_BYTE,
+               nullptr);
+  gl.bindBuffer(PIXEL_PACK_BUFFER, 0);
+  transfer.fence = gl.fenceSync(SYNC_GPU_COMMANDS_COMPLETE, 0);
+  transfer.index = index;
+  transfer.issued = now;
+  glFlush();
+
+  nextTransfer = (nextTransfer + 1) % TRANSFER_COUNT;
+  ++inFlight;
+}
+
+bool VideoRecorder::scaleToRecordedSize(const sf::RenderTexture &texture) {
+  TRACE_SCOPE("Video scale");
+  if (scaled.getSize() != size && !scaled.create(size.x, size.y)) {
+    return false;
+  }
+
+  // Scaled as the window shows it; the pixel buffers and fences are shared
+  // with this texture's context
+  sf::Sprite sprite(texture.getTexture());
+  sprite.setScale(static_cast<float>(size.x) / texture.getSize().x,
+                  static_cast<float>(size.y) / texture.getSize().y);
+  scaled.clear();
+  scaled.draw(sprite, sf::BlendNone);
+  scaled.display();
+  return scaled.setActive(true);
+}
+
+bool VideoRecorder::collect(Transfer &transfer, bool wait) {
+  const PixelBufferFunctions &gl = pixelBuffers();
+  GLenum status =
+      gl.clientWaitSync(transfer.fence, wait ? SYNC_FLUSH_COMMANDS_BIT : 0,
+                        wait ? STOP_WAIT_NS : 0);
+  bool ready = status == ALREADY_SIGNALED || status == CONDITION_SATISFIED;
+  if (!ready && !wait) {
+    return false;
+  }
+  gl.deleteSync(transfer.fence);
+  transfer.fence = nullptr;
+  oldestTransfer = (oldestTransfer + 1) % TRANSFER_COUNT;
+  --inFlight;
+
+  const float ms = std::chrono::duration<float, std::milli>(
+                       std::chrono::steady_clock::now() - transfer.issued)
+                       .count();
+  readbackMs = readbackMs == 0.0f ? ms : readbackMs + (ms - readbackMs) * 0.1f;
+
+  // The writer still holds every frame
+  Frame *frame = nullptr;
+  if (!ready || !empty.pop(frame)) {
+    ++framesDropped;
+    return true;
+  }
+
+  gl.bindBuffer(PIXEL_PACK_BUFFER, transfer.buffer);
+  const void *mapped = gl.mapBuffer(PIXEL_PACK_BUFFER, READ_ONLY);
+  if (mapped) {
+    std::memcpy(frame->pixels.data(), mapped, frame->pixels.size());
+    gl.unmapBuffer(PIXEL_PACK_BUFFER);
+  }
+  gl.bindBuffer(PIXEL_PACK_BUFFER, 0);
+
+  if (!mapped) {
+    empty.push(frame);
+    ++framesDropped;
+    return true;
+  }
+  frame->index = transfer.index;
+  full.push(frame);
+  return true;
+}
+
+void VideoRecorder::releaseTransfers() {
+  const PixelBufferFunctions &gl = pixelBuffers();
+  for (Transfer &transfer : transfers) {
+    if (transfer.fence) {
+      gl.deleteSync(transfer.fence);
+      transfer.fence = nullptr;
+    }
+    if (transfer.buffer != 0) {
+      gl.deleteBuffers(1, &transfer.buffer);
+      transfer.buffer = 0;
+    }
+  }
+  nextTransfer = 0;
+  oldestTransfer = 0;
+  inFlight = 0;
+}
+
+void VideoRecorder::writeLoop() {
+  trace::setThreadName("Video writer");
+  while (true) {
+    Frame *frame = nullptr;
+    if (!full.pop(frame)) {
+      if (!writing) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      continue;
+    }
+    writeFrame(*frame);
+    empty.push(frame);
+  }
+}
+
+void VideoRecorder::writeFrame(const Frame &frame) {
+  TRACE_SCOPE("Video write");
+  if (!file) {
+    return;
+  }
+
+  // GL rows start at the bottom; Y4M planes start at the top
+  const size_t width = size.x;
+  const size_t height = size.y;
+  const size_t planeSize = width * height;
+  std::uint8_t *yPlane = planes.data();
+  std::uint8_t *cbPlane = yPlane + planeSize;
+  std::uint8_t *crPlane = cbPlane + planeSize;
+  for (size_t row = 0; row < height; ++row) {
+    const std::uint8_t *src = frame.pixels.data() + (height - 1 - row) * width * 4;
+    const size_t out = row * width;
+    for (size_t x = 0; x < width; ++x, src += 4) {
+      const int r = src[0], g = src[1], b = src[2];
+      yPlane[out + x] = toY(r, g, b);
+      cbPlane[out + x] = toCb(r, g, b);
+      crPlane[out + x] = toCr(r, g, b);
+    }
+  }
+
+  // Repeat this frame over any gap left by drops so the video keeps time
+  std::int64_t copies = 1;
+  if (writtenIndex >= 0) {
+    copies = std::min(std::max<std::int64_t>(frame.index - writtenIndex, 1),
+                      MAX_REPEATS);
+  }
+  writtenIndex = frame.index;
+
+  static const char frameHeader[] = "FRAME\n";
+  for (std::int64_t i = 0; i < copies; ++i) {
+    if (std::fwrite(frameHeader, 1, sizeof(frameHeader) - 1, file) !=
+            sizeof(frameHeader) - 1 ||
+        std::fwrite(planes.data(), 1, planes.size(), file) != planes.size()) {
+      std::cerr << "Failed to write video frame to " << path
+                << ", recording discarded from here" << std::endl;
+      std::fclose(file);
+      file = nullptr;
+      return;
+    }
+    ++framesWritten;
+  }
+  framesRepeated += static_cast<std::uint64_t>(copies - 1);
+}
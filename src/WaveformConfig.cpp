@@ -1,52 +1,21 @@
 #include "WaveformConfig.h"
-#include <string>
+#include "JsonReader.h"
 
-// Helper function to extract value from JSON
-static std::string extractValue(const std::string& content, const std::string& key) {
-    std::string searchKey = "\"" + key + "\":";
-    size_t pos = content.find(searchKey);
-    if (pos == std::string::npos) return "";
+// Keys dispatched to members in a single pass over the object
+static constexpr json::Field<WaveformConfig> kFields[] = {
+    {"displayHeight", &WaveformConfig::displayHeight},
+    {"smoothness", &WaveformConfig::smoothness},
+    {"smoothingPasses", &WaveformConfig::smoothingPasses},
+    {"rotationSpeed", &WaveformConfig::rotationSpeed},
+    {"radiusFactor", &WaveformConfig::radiusFactor},
+    {"thickness", &WaveformConfig::thickness},
+    {"hueOffset", &WaveformConfig::hueOffset},
+    {"alpha", &WaveformConfig::alpha},
+    {"thickAlpha", &WaveformConfig::thickAlpha},
+    {"interpolation", &WaveformConfig::interpolation},
+    {"enabled", &WaveformConfig::enabled},
+};
 
-    pos += searchKey.length();
-    size_t endPos = content.find_first_of(",\n}", pos);
-    if (endPos == std::string::npos) return "";
-
-    std::string value = content.substr(pos, endPos - pos);
-    
-    // Trim whitespace and quotes
-    size_t first = value.find_first_not_of(" \t\n\r\"");
-    if (first == std::string::npos) return "";
-    size_t last = value.find_last_not_of(" \t\n\r\",\"");
- return value.substr(first, last - first + 1);
-}
-
-void WaveformConfig::fromJSON(const std::string& json) {
-std::string val;
-    
-  val = extractValue(json, "displayHeight");
-    if (!val.empty()) displayHeight = std::stof(val);
-    
-    val = extractValue(json, "smoothness");
-    if (!val.empty()) smoothness = std::stoi(val);
-  
-    val = extractValue(json, "rotationSpeed");
-    if (!val.empty()) rotationSpeed = std::stof(val);
-    
-    val = extractValue(json, "radiusFactor");
-    if (!val.empty()) radiusFactor = std::stof(val);
-    
-  val = extractValue(json, "thickness");
-    if (!val.empty()) thickness = std::stof(val);
-    
-    val = extractValue(json, "hueOffset");
-  if (!val.empty()) hueOffset = std::stof(val);
-    
-    val = extractValue(json, "alpha");
-    if (!val.empty()) alpha = static_cast<sf::Uint8>(std::stoi(val));
-    
-    val = extractValue(json, "thickAlpha");
-    if (!val.empty()) thickAlpha = static_cast<sf::Uint8>(std::stoi(val));
-    
-    val = extractValue(json, "enabled");
-    if (!val.empty()) enabled = (val == "true");
+bool WaveformConfig::fromJSON(json::Reader &reader) {
+  return json::readObject(reader, *this, kFields);
 }
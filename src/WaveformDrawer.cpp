@@ -0,0 +1,251 @@
+#include "WaveformDrawer.h"
+#include "ColorLut.h"
+#include <array>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+// Point multipliers with their own kernels: every step of the quality
+// ladder. Index 0 is the generic kernel for any other multiplier.
+constexpr int SPECIALISED_MULTIPLIERS[] = {0, 3, 4, 5, 6, 8, 10};
+constexpr size_t MULTIPLIER_SLOTS = std::size(SPECIALISED_MULTIPLIERS);
+
+// Bound on the generic kernel's multiplier, which sizes its weight table
+constexpr int MAX_POINT_MULTIPLIER = 32;
+
+// Everything a kernel needs beyond its template parameters
+struct WaveformArgs {
+  const double *samples;
+  const double *smoothed;
+  size_t sampleCount;
+  sf::Vertex *normalOut;
+  sf::Vertex *thickOut;
+  float displayHeight;
+  float rotationAngle;
+  float radius;
+  float centerX;
+  float centerY;
+  float hue;
+  float thickHue;
+  float thickness;
+  sf::Uint8 alpha;
+  sf::Uint8 thickAlpha;
+  int pointMultiplier;
+  float thickStep;
+};
+
+// Weights of a segment's four neighbours (see neighbourOffset) at position
+// mu through it; the curve runs from the second neighbour to the third
+template <Interpolation Kernel> std::array<double, 4> kernelWeights(double mu) {
+  const double mu2 = mu * mu;
+  const double mu3 = mu2 * mu;
+  switch (Kernel) {
+  case Interpolation::None:
+    return {0.0, 1.0, 0.0, 0.0};
+  case Interpolation::Linear:
+    return {0.0, 1.0 - mu, mu, 0.0};
+  case Interpolation::CatmullRom:
+    return {0.5 * (-mu3 + 2.0 * mu2 - mu), 0.5 * (3.0 * mu3 - 5.0 * mu2 + 2.0),
+            0.5 * (-3.0 * mu3 + 4.0 * mu2 + mu), 0.5 * (mu3 - mu2)};
+  case Interpolation::Cubic:
+  default:
+    return {-mu3 + 2.0 * mu2 - mu, mu3 - 2.0 * mu2 + 1.0, -mu3 + mu2 + mu,
+            mu3 - mu2};
+  }
+}
+
+// Offset of the first of a sample's four neighbours. Each segment runs
+// from the sample to the next one, with one neighbour either side. Cubic
+// keeps the original curve, which skips the sample itself and runs from
+// the one before to the one after.
+template <Interpolation Kernel> constexpr size_t neighbourOffset() {
+  return Kernel == Interpolation::Cubic ? 2 : 1;
+}
+
+// Both passes in one walk over the samples. The multiplier is a constant
+// unless Multiplier is 0, so the per-point weights, divisions and the
+// inner loop resolve at compile time.
+template <Interpolation Kernel, int Multiplier, bool ThickPass>
+void drawWaveformKernel(const WaveformArgs &args) {
+  // Per-thread vectors to avoid repeated allocations; geometry may be built
+  // on more than one thread
+  static thread_local std::vector<float> cosCache;
+  static thread_local std::vector<float> sinCache;
+
+  const int multiplier = Multiplier > 0 ? Multiplier : args.pointMultiplier;
+  const size_t sampleCount = args.sampleCount;
+  const size_t numPoints = sampleCount * static_cast<size_t>(multiplier);
+  const size_t thicknessSteps = thickStepCount(args.thickness, args.thickStep);
+
+  std::array<std::array<double, 4>,
+             (Multiplier > 0 ? Multiplier : MAX_POINT_MULTIPLIER)>
+      weights;
+  for (int k = 0; k < multiplier; ++k) {
+    weights[k] = kernelWeights<Kernel>(static_cast<double>(k) / multiplier);
+  }
+
+  // Pre-compute sin/cos for all angles to avoid redundant calculations
+  cosCache.resize(numPoints);
+  sinCache.resize(numPoints);
+  for (size_t i = 0; i < numPoints; ++i) {
+    float angle = static_cast<float>(i) / static_cast<float>(numPoints) * 2.0f *
+                      static_cast<float>(M_PI) +
+                  args.rotationAngle;
+    cosCache[i] = std::cos(angle);
+    sinCache[i] = std::sin(angle);
+  }
+
+  // Hues advance by one turn around the circle, so colours come from the
+  // shared palettes through fixed-point accumulators
+  const ColorLut &normalPalette = normalPassPalette();
+  const ColorLut &thickPalette = thickPassPalette();
+  const double hueOffset = -args.rotationAngle / (2.0 * M_PI);
+  const std::uint32_t hueStep = ColorLut::stepFor(numPoints);
+  std::uint32_t normalHue = ColorLut::toFixed(args.hue + hueOffset);
+  std::uint32_t thickHue = ColorLut::toFixed(args.thickHue + hueOffset);
+
+  sf::Vertex *normalOut = args.normalOut;
+  sf::Vertex *thickOut = args.thickOut;
+  size_t i = 0;
+  for (size_t index = 0; index < sampleCount; ++index) {
+    // Neighbours with wraparound, once per sample rather than per point
+    constexpr size_t before = neighbourOffset<Kernel>();
+    const size_t idx0 = index >= before ? index - before
+                                        : index + sampleCount - before;
+    const size_t idx1 = index >= before - 1 ? index - (before - 1)
+                                            : index + sampleCount - (before - 1);
+    const size_t idx2 = index + 1 < sampleCount ? index + 1 : index + 1 - sampleCount;
+    const size_t idx3 = index + 2 < sampleCount ? index + 2 : index + 2 - sampleCount;
+
+    const double y0 = args.samples[idx0], y1 = args.samples[idx1];
+    const double y2 = args.samples[idx2], y3 = args.samples[idx3];
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    if (ThickPass) {
+      s0 = args.smoothed[idx0];
+      s1 = args.smoothed[idx1];
+      s2 = args.smoothed[idx2];
+      s3 = args.smoothed[idx3];
+    }
+
+    for (int k = 0; k < multiplier; ++k, ++i) {
+      const std::array<double, 4> &w = weights[k];
+      const float cosAngle = cosCache[i];
+      const float sinAngle = sinCache[i];
+
+      float sampleValue =
+          static_cast<float>(w[0] * y0 + w[1] * y1 + w[2] * y2 + w[3] * y3);
+      float r = args.radius + sampleValue * args.displayHeight;
+      sf::Color color = normalPalette[normalHue];
+      color.a = args.alpha;
+      normalHue += hueStep;
+      normalOut[i].position = sf::Vector2f(args.centerX + r * cosAngle,
+                                           args.centerY + r * sinAngle);
+      normalOut[i].color = color;
+
+      if (ThickPass) {
+        float smoothedValue =
+            static_cast<float>(w[0] * s0 + w[1] * s1 + w[2] * s2 + w[3] * s3);
+        float thickR = args.radius + smoothedValue * args.displayHeight;
+        sf::Color thickColor = thickPalette[thickHue];
+        thickColor.a = args.thickAlpha;
+        thickHue += hueStep;
+
+        for (size_t step = 0; step < thicknessSteps; ++step) {
+          float offsetRadius = thickR - args.thickness / 2.0f +
+                               static_cast<float>(step) * args.thickStep;
+          thickOut->position =
+              sf::Vector2f(args.centerX + offsetRadius * cosAngle,
+                           args.centerY + offsetRadius * sinAngle);
+          thickOut->color = thickColor;
+          ++thickOut;
+        }
+      }
+    }
+  }
+
+  // Prevent vertical line artifact by not connecting last to first if
+  // discontinuous
+  if (numPoints > 1) {
+    sf::Vector2f first = normalOut[0].position;
+    sf::Vector2f last = normalOut[numPoints - 1].position;
+    float dist = std::hypot(first.x - last.x, first.y - last.y);
+    float threshold = args.radius * 0.5f; // Heuristic: half the radius
+    if (dist > threshold) {
+      // Overwrite last vertex to match first, breaking the line
+      normalOut[numPoints - 1].position = first;
+    }
+  }
+}
+
+using WaveformKernel = void (*)(const WaveformArgs &);
+
+template <Interpolation Kernel, bool ThickPass, size_t... Slot>
+constexpr std::array<WaveformKernel, MULTIPLIER_SLOTS>
+multiplierKernels(std::index_sequence<Slot...>) {
+  return {&drawWaveformKernel<Kernel, SPECIALISED_MULTIPLIERS[Slot], ThickPass>...};
+}
+
+template <Interpolation Kernel>
+constexpr std::array<std::array<WaveformKernel, MULTIPLIER_SLOTS>, 2>
+passKernels() {
+  constexpr auto slots = std::make_index_sequence<MULTIPLIER_SLOTS>();
+  return {multiplierKernels<Kernel, false>(slots),
+          multiplierKernels<Kernel, true>(slots)};
+}
+
+// Indexed by interpolation, thick pass and multiplier slot
+constexpr std::array<std::array<std::array<WaveformKernel, MULTIPLIER_SLOTS>, 2>,
+                     static_cast<size_t>(Interpolation::Count)>
+    KERNELS = {passKernels<Interpolation::None>(),
+               passKernels<Interpolation::Linear>(),
+               passKernels<Interpolation::Cubic>(),
+               passKernels<Interpolation::CatmullRom>()};
+
+size_t multiplierSlot(int pointMultiplier) {
+  for (size_t slot = 1; slot < MULTIPLIER_SLOTS; ++slot) {
+    if (SPECIALISED_MULTIPLIERS[slot] == pointMultiplier) {
+      return slot;
+    }
+  }
+  return 0;
+}
+
+} // namespace
+
+void drawWaveform(const std::vector<double> &extendedBuffer,
+                  const std::vector<double> &smoothedAudioBuffer,
+                  sf::Vertex *normalOut, sf::Vertex *thickOut,
+                  float displayHeight, float rotationAngle, float radiusFactor,
+                  float width, float height, float hue, float thickness,
+                  float thickWaveformHueOffset, sf::Uint8 waveformAlpha,
+                  sf::Uint8 thickWaveformAlpha, int pointMultiplier,
+                  float thickStep, Interpolation interpolation) {
+  // Fewer than two samples have no neighbours to wrap around to
+  if (extendedBuffer.size() < 2 ||
+      smoothedAudioBuffer.size() != extendedBuffer.size()) {
+    return;
+  }
+
+  WaveformArgs args;
+  args.samples = extendedBuffer.data();
+  args.smoothed = smoothedAudioBuffer.data();
+  args.sampleCount = extendedBuffer.size();
+  args.normalOut = normalOut;
+  args.thickOut = thickOut;
+  args.displayHeight = displayHeight;
+  args.rotationAngle = rotationAngle;
+  args.centerX = width / 2.0f;
+  args.centerY = height / 2.0f;
+  args.radius = std::min(args.centerX, args.centerY) * radiusFactor;
+  args.hue = hue;
+  args.thickHue = hue + thickWaveformHueOffset;
+  args.thickness = thickness;
+  args.alpha = waveformAlpha;
+  args.thickAlpha = thickWaveformAlpha;
+  args.pointMultiplier = std::clamp(pointMultiplier, 1, MAX_POINT_MULTIPLIER);
+  args.thickStep = std::max(thickStep, 0.1f);
+
+  KERNELS[static_cast<size_t>(interpolation)][thickOut != nullptr]
+         [multiplierSlot(args.pointMultiplier)](args);
+}
@@ -0,0 +1,256 @@
+#include "WaveformGeometry.h"
+#include "PerfTimers.h"
+#include "WaveformDrawer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+static void writeBridge(sf::Vertex *bridge, const sf::Vertex &from,
+                        const sf::Vertex &to) {
+  bridge[0] = from;
+  bridge[0].color.a = 0;
+  bridge[1] = to;
+  bridge[1].color.a = 0;
+}
+
+size_t layoutGeometry(const std::vector<WaveformConfig> &configs,
+                      size_t pointCount, float thickStep,
+                      std::vector<GeometryRange> &ranges) {
+  ranges.resize(configs.size());
+
+  size_t total = 0;
+  for (size_t i = 0; i < configs.size(); ++i) {
+    GeometryRange &range = ranges[i];
+    range = GeometryRange();
+    range.normalOffset = total;
+    range.thickOffset = total;
+    if (!configs[i].enabled || pointCount == 0) {
+      continue;
+    }
+
+    // A transparent thick pass is left out, and the normal pass bridges
+    // straight to the next waveform
+    range.normalCount = pointCount;
+    if (configs[i].thickAlpha == 0) {
+      range.thickOffset = total + pointCount;
+      total = range.thickOffset + BRIDGE_VERTICES;
+      continue;
+    }
+    range.thickOffset = total + pointCount + BRIDGE_VERTICES;
+    range.thickCount =
+        pointCount * thickStepCount(configs[i].thickness, thickStep);
+    total = range.thickOffset + range.thickCount + BRIDGE_VERTICES;
+  }
+  return total;
+}
+
+void writeBridges(const std::vector<GeometryRange> &ranges,
+                  std::vector<sf::Vertex> &vertices) {
+  // Each normal pass leads into its thick pass, and each thick pass (or
+  // normal pass without one) into the next enabled waveform
+  for (size_t i = 0, next = 0; i < ranges.size(); i = next) {
+    next = i + 1;
+    if (ranges[i].normalCount == 0) {
+      continue;
+    }
+    while (next < ranges.size() && ranges[next].normalCount == 0) {
+      ++next;
+    }
+
+    const GeometryRange &range = ranges[i];
+    sf::Vertex *normal = vertices.data() + range.normalOffset;
+    sf::Vertex *thick = vertices.data() + range.thickOffset;
+    if (range.thickCount > 0) {
+      writeBridge(normal + range.normalCount, normal[range.normalCount - 1],
+                  thick[0]);
+    }
+
+    sf::Vertex *bridge = thick + range.thickCount;
+    const sf::Vertex &last = bridge[-1];
+    const sf::Vertex &first = next < ranges.size()
+                                  ? vertices[ranges[next].normalOffset]
+                                  : last;
+    writeBridge(bridge, last, first);
+  }
+}
+
+void buildCpuGeometry(const std::vector<WaveformConfig> &configs,
+                      const std::vector<float> &rotationAngles,
+                      const std::vector<GeometryRange> &ranges,
+                      SmoothingCache &samples, float globalHue, float width,
+                      float height, float opacity, float radiusScale,
+                      const RenderQuality &quality,
+                      std::vector<sf::Vertex> &vertices) {
+  for (size_t i = 0; i < configs.size(); ++i) {
+    const WaveformConfig &config = configs[i];
+    const GeometryRange &range = ranges[i];
+    if (range.normalCount == 0) {
+      continue;
+    }
+
+    perf::ScopedTimer timer(perf::waveformTimes(i));
+    sf::Uint8 alpha = static_cast<sf::Uint8>(config.alpha * opacity);
+    sf::Uint8 thickAlpha = static_cast<sf::Uint8>(config.thickAlpha * opacity);
+
+    drawWaveform(samples.samples(),
+                 samples.smoothed(config.smoothness, config.smoothingPasses),
+                 vertices.data() + range.normalOffset,
+                 range.thickCount > 0 ? vertices.data() + range.thickOffset
+                                      : nullptr,
+                 config.displayHeight, -rotationAngles[i],
+                 config.radiusFactor * radiusScale, width, height, globalHue,
+                 config.thickness, config.hueOffset, alpha, thickAlpha,
+                 quality.pointMultiplier, quality.thickStep,
+                 config.getInterpolation());
+  }
+  writeBridges(ranges, vertices);
+}
+
+void writeGpuIndexVertices(const std::vector<GeometryRange> &ranges,
+                           size_t first, std::vector<sf::Vertex> &vertices) {
+  for (size_t i = first; i < ranges.size(); ++i) {
+    const GeometryRange &range = ranges[i];
+    float wave = static_cast<float>(i);
+    sf::Vertex *normal = vertices.data() + range.normalOffset;
+    sf::Vertex *thick = vertices.data() + range.thickOffset;
+    size_t steps =
+        range.normalCount > 0 ? range.thickCount / range.normalCount : 0;
+
+    for (size_t point = 0; point < range.normalCount; ++point) {
+      float x = static_cast<float>(point);
+      normal[point] = sf::Vertex(sf::Vector2f(x, 0.0f), sf::Color::White,
+                                 sf::Vector2f(wave, 0.0f));
+      for (size_t step = 0; step < steps; ++step) {
+        *thick++ = sf::Vertex(sf::Vector2f(x, static_cast<float>(step)),
+                              sf::Color::White, sf::Vector2f(wave, 1.0f));
+      }
+    }
+  }
+  writeBridges(ranges, vertices);
+}
+
+// Texels per waveform in the waveform texture, and the range each
+// parameter is encoded over. Must match waveform.vert; values outside a
+// range are clamped to it.
+static constexpr unsigned int WAVEFORM_TEXELS = 7;
+static constexpr float MAX_RADIUS_FACTOR = 8.0f;
+static constexpr float MAX_DISPLAY_HEIGHT = 2048.0f;
+static constexpr float MAX_THICKNESS = 512.0f;
+
+// Map a sample in [-2, 2] to 16-bit fixed point in the red and green bytes
+static void encodeSamples(const std::vector<double> &samples,
+                          sf::Uint8 *pixels) {
+  for (double sample : samples) {
+    double clamped = std::max(-2.0, std::min(2.0, sample));
+    auto encoded =
+        static_cast<unsigned int>(std::lround((clamped * 0.25 + 0.5) * 65535.0));
+    pixels[0] = static_cast<sf::Uint8>(encoded >> 8);
+    pixels[1] = static_cast<sf::Uint8>(encoded & 0xFF);
+    pixels[2] = 0;
+    pixels[3] = 255;
+    pixels += 4;
+  }
+}
+
+// Map a value in [minimum, maximum] to 24-bit fixed point in a texel's RGB
+static void encodeParameter(double value, double minimum, double maximum,
+                            sf::Uint8 *texel) {
+  double unit = (std::clamp(value, minimum, maximum) - minimum) /
+                (maximum - minimum);
+  auto encoded = static_cast<std::uint32_t>(std::lround(unit * 16777215.0));
+  texel[0] = static_cast<sf::Uint8>(encoded >> 16);
+  texel[1] = static_cast<sf::Uint8>((encoded >> 8) & 0xFF);
+  texel[2] = static_cast<sf::Uint8>(encoded & 0xFF);
+}
+
+static double turns(double value) { return value - std::floor(value); }
+
+void packGpuGeometry(const std::vector<WaveformConfig> &configs,
+                     const std::vector<float> &rotationAngles,
+                     const std::vector<GeometryRange> &ranges,
+                     SmoothingCache &samples, float globalHue, float width,
+                     float height, float opacity, float radiusScale,
+                     const RenderQuality &quality, GpuGeometryFrame &frame) {
+  frame.rowSmoothing.clear();
+  frame.waveformSize = sf::Vector2u(WAVEFORM_TEXELS,
+                                    static_cast<unsigned int>(configs.size()));
+  frame.waveformPixels.assign(WAVEFORM_TEXELS * configs.size() * 4, 255);
+
+  for (size_t i = 0; i < configs.size(); ++i) {
+    const WaveformConfig &config = configs[i];
+    std::pair<int, int> smoothing(config.smoothness, config.smoothingPasses);
+    auto row = std::find(frame.rowSmoothing.begin(), frame.rowSmoothing.end(),
+                         smoothing);
+    if (row == frame.rowSmoothing.end() && ranges[i].normalCount > 0) {
+      frame.rowSmoothing.push_back(smoothing);
+      row = frame.rowSmoothing.end() - 1;
+    }
+    auto sampleRow =
+        static_cast<unsigned int>(row - frame.rowSmoothing.begin()) + 1;
+
+    // Rotation and hue offsets only matter modulo a turn
+    sf::Uint8 *texel = frame.waveformPixels.data() + i * WAVEFORM_TEXELS * 4;
+    encodeParameter(turns(-rotationAngles[i] / (2.0 * M_PI)), 0.0, 1.0,
+                    texel);
+    encodeParameter(config.radiusFactor * radiusScale, 0.0, MAX_RADIUS_FACTOR,
+                    texel + 4);
+    encodeParameter(config.displayHeight, -MAX_DISPLAY_HEIGHT,
+                    MAX_DISPLAY_HEIGHT, texel + 8);
+    encodeParameter(config.thickness, 0.0, MAX_THICKNESS, texel + 12);
+    encodeParameter(turns(config.hueOffset), 0.0, 1.0, texel + 16);
+    encodeParameter(config.alpha * opacity / 255.0, 0.0, 1.0, texel + 20);
+    encodeParameter(config.thickAlpha * opacity / 255.0, 0.0, 1.0,
+                    texel + 24);
+    texel[3] = static_cast<sf::Uint8>(sampleRow >> 8);
+    texel[7] = static_cast<sf::Uint8>(sampleRow & 0xFF);
+    texel[11] = static_cast<sf::Uint8>(config.getInterpolation());
+
+    // The layout may hold more radial steps than this frame's thickness
+    // draws; the shader folds the rest onto the last
+    auto lastStep = static_cast<unsigned int>(
+        thickStepCount(config.thickness, quality.thickStep) - 1);
+    texel[15] = static_cast<sf::Uint8>(lastStep >> 8);
+    texel[19] = static_cast<sf::Uint8>(lastStep & 0xFF);
+  }
+
+  const size_t columns = samples.samples().size();
+  const size_t rows = frame.rowSmoothing.size() + 1;
+  frame.samplePixels.resize(columns * rows * 4);
+  encodeSamples(samples.samples(), frame.samplePixels.data());
+  for (size_t row = 1; row < rows; ++row) {
+    const std::pair<int, int> &smoothing = frame.rowSmoothing[row - 1];
+    encodeSamples(samples.smoothed(smoothing.first, smoothing.second),
+                  frame.samplePixels.data() + row * columns * 4);
+  }
+
+  frame.sampleSize = sf::Vector2u(static_cast<unsigned int>(columns),
+                                  static_cast<unsigned int>(rows));
+  frame.pointCount = waveformPointCount(columns, quality.pointMultiplier);
+  frame.pointMultiplier =
+      static_cast<float>(std::max(quality.pointMultiplier, 1));
+  frame.thickStep = std::max(quality.thickStep, 0.1f);
+  frame.hue = globalHue;
+  frame.center = sf::Vector2f(width / 2.0f, height / 2.0f);
+}
+
+void setGpuGeometryUniforms(sf::Shader &shader, const GpuGeometryFrame &frame,
+                            const sf::Texture &sampleTexture,
+                            const sf::Texture &waveformTexture) {
+  sf::Vector2u sampleTextureSize = sampleTexture.getSize();
+  sf::Vector2u waveformTextureSize = waveformTexture.getSize();
+  shader.setUniform("samples", sampleTexture);
+  shader.setUniform("sampleTexel",
+                    sf::Glsl::Vec2(1.0f / sampleTextureSize.x,
+                                   1.0f / sampleTextureSize.y));
+  shader.setUniform("waveforms", waveformTexture);
+  shader.setUniform("waveformTexel",
+                    sf::Glsl::Vec2(1.0f / waveformTextureSize.x,
+                                   1.0f / waveformTextureSize.y));
+  shader.setUniform("sampleCount", static_cast<float>(frame.sampleSize.x));
+  shader.setUniform("pointCount", static_cast<float>(frame.pointCount));
+  shader.setUniform("pointMultiplier", frame.pointMultiplier);
+  shader.setUniform("thickStep", frame.thickStep);
+  shader.setUniform("center", frame.center);
+  shader.setUniform("baseRadius", std::min(frame.center.x, frame.center.y));
+  shader.setUniform("hue", frame.hue);
+}
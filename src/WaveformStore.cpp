@@ -0,0 +1,337 @@
+#include "WaveformStore.h"
+#include "ModulationMatrix.h"
+#include "PerfTimers.h"
+#include "SmoothingCache.h"
+#include "WaveformDrawer.h"
+#include <algorithm>
+
+WaveformHandle WaveformStore::add(const WaveformConfig &config) {
+  std::uint32_t slot;
+  if (!freeSlots.empty()) {
+    slot = freeSlots.back();
+    freeSlots.pop_back();
+  } else {
+    slot = static_cast<std::uint32_t>(slotToDense.size());
+    slotToDense.push_back(WaveformHandle::INVALID);
+    slotGenerations.push_back(0);
+  }
+
+  slotToDense[slot] = static_cast<std::uint32_t>(configs.size());
+  configs.push_back(config);
+  rotationAngles.push_back(0.0f);
+  ranges.push_back(GeometryRange());
+  denseToSlot.push_back(slot);
+
+  return WaveformHandle{slot, slotGenerations[slot]};
+}
+
+void WaveformStore::remove(WaveformHandle handle) {
+  size_t index = indexOf(handle);
+  if (index >= configs.size()) {
+    return;
+  }
+
+  // Draw order is visible (later waveforms layer on top), so removal closes
+  // the gap instead of swapping the last waveform in. The arrays are plain
+  // values, so this is a memmove rather than per-object work.
+  configs.erase(configs.begin() + index);
+  rotationAngles.erase(rotationAngles.begin() + index);
+  ranges.erase(ranges.begin() + index);
+  denseToSlot.erase(denseToSlot.begin() + index);
+
+  for (size_t i = index; i < denseToSlot.size(); ++i) {
+    slotToDense[denseToSlot[i]] = static_cast<std::uint32_t>(i);
+  }
+
+  slotToDense[handle.slot] = WaveformHandle::INVALID;
+  ++slotGenerations[handle.slot];
+  freeSlots.push_back(handle.slot);
+}
+
+void WaveformStore::clear() {
+  for (std::uint32_t slot : denseToSlot) {
+    slotToDense[slot] = WaveformHandle::INVALID;
+    ++slotGenerations[slot];
+    freeSlots.push_back(slot);
+  }
+
+  configs.clear();
+  rotationAngles.clear();
+  ranges.clear();
+  denseToSlot.clear();
+  vertices.clear();
+  dirtyBegin = dirtyEnd = 0;
+
+  // Its last frame still holds the old waveforms. Joining it here could
+  // wait out a whole build, so it is stopped and destroyed once it exits.
+  producer.retire();
+  pipelined = false;
+}
+
+WaveformHandle WaveformStore::getHandle(size_t index) const {
+  std::uint32_t slot = denseToSlot[index];
+  return WaveformHandle{slot, slotGenerations[slot]};
+}
+
+size_t WaveformStore::indexOf(WaveformHandle handle) const {
+  if (handle.slot >= slotToDense.size() ||
+      slotGenerations[handle.slot] != handle.generation ||
+      slotToDense[handle.slot] == WaveformHandle::INVALID) {
+    return configs.size();
+  }
+  return slotToDense[handle.slot];
+}
+
+void WaveformStore::update(SmoothingCache &samples,
+                           float globalHue, float deltaTime, float width,
+                           float height, float opacity,
+                           float radiusScale) {
+  // The stored configs stay as edited and saved
+  modulating = modulation && modulation->isActive();
+  if (modulating) {
+    modulation->applyToWaveforms(configs, modulatedConfigs);
+  }
+  const std::vector<WaveformConfig> &active = frameConfigs();
+
+  // CPU geometry is rebuilt whole every frame, so only the GPU path gains
+  // from a layout that modulation cannot change
+  const bool gpu =
+      geometryShader && configs.size() <= sf::Texture::getMaximumSize();
+  if (gpu && modulating) {
+    modulation->applyLayoutBounds(configs, layoutConfigs);
+  }
+  size_t total = layoutGeometry(
+      gpu && modulating ? layoutConfigs : active,
+      waveformPointCount(samples.samples().size(), quality.pointMultiplier),
+      quality.thickStep, ranges);
+
+  for (size_t i = 0; i < active.size(); ++i) {
+    if (ranges[i].normalCount > 0) {
+      rotationAngles[i] += active[i].rotationSpeed * deltaTime;
+    }
+  }
+
+  if (gpu) {
+    buildGpuGeometry(samples, total, globalHue, width, height, opacity,
+                     radiusScale);
+  } else if (pipelineEnabled) {
+    submitGeometry(samples, total, globalHue, width, height, opacity,
+                   radiusScale);
+  } else {
+    buildInlineGeometry(samples, total, globalHue, width, height, opacity,
+                        radiusScale);
+  }
+}
+
+void WaveformStore::buildInlineGeometry(SmoothingCache &samples,
+                                        size_t total, float globalHue,
+                                        float width, float height,
+                                        float opacity, float radiusScale) {
+  // Capacity is kept from the previous frame, so this rarely reallocates
+  vertices.resize(total);
+  buildCpuGeometry(frameConfigs(), rotationAngles, ranges, samples, globalHue,
+                   width, height, opacity, radiusScale, quality, vertices);
+
+  // Every enabled waveform was regenerated
+  gpuGeometry = false;
+  pipelined = false;
+  builtRanges.clear();
+  dirtyBegin = 0;
+  dirtyEnd = total;
+}
+
+void WaveformStore::submitGeometry(SmoothingCache &samples, size_t total,
+                                   float globalHue, float width, float height,
+                                   float opacity, float radiusScale) {
+  GeometryProducer &geometryProducer = producer.acquire();
+
+  // Copies reuse the allocations of the job handed back by the last submit
+  job.samples = samples;
+  job.configs = frameConfigs();
+  job.rotationAngles = rotationAngles;
+  job.ranges = ranges;
+  job.vertexCount = total;
+  job.globalHue = globalHue;
+  job.width = width;
+  job.height = height;
+  job.opacity = opacity;
+  job.radiusScale = radiusScale;
+  job.quality = quality;
+  geometryProducer.submit(job);
+
+  // Index vertices are no use as a stand-in for the producer's first frame
+  if (gpuGeometry) {
+    vertices.clear();
+  }
+  gpuGeometry = false;
+  pipelined = true;
+  builtRanges.clear();
+}
+
+// First waveform whose range differs between two layouts, or the size of
+// the shorter if one is a prefix of the other
+static size_t firstLayoutChange(const std::vector<GeometryRange> &a,
+                                const std::vector<GeometryRange> &b) {
+  size_t count = std::min(a.size(), b.size());
+  for (size_t i = 0; i < count; ++i) {
+    if (a[i].normalOffset != b[i].normalOffset ||
+        a[i].normalCount != b[i].normalCount ||
+        a[i].thickOffset != b[i].thickOffset ||
+        a[i].thickCount != b[i].thickCount) {
+      return i;
+    }
+  }
+  return count;
+}
+
+// Upload pixels to the top-left of a texture that only grows, so a steady
+// scene never reallocates it
+static bool updateTexture(std::unique_ptr<sf::Texture> &texture,
+                          const sf::Uint8 *pixels, sf::Vector2u size) {
+  if (!texture || texture->getSize().x < size.x ||
+      texture->getSize().y < size.y) {
+    if (texture) {
+      size.x = std::max(size.x, texture->getSize().x);
+      size.y = std::max(size.y, texture->getSize().y);
+    }
+    texture = std::make_unique<sf::Texture>();
+    if (!texture->create(size.x, size.y)) {
+      texture.reset();
+      return false;
+    }
+  }
+  texture->update(pixels, size.x, size.y, 0, 0);
+  return true;
+}
+
+void WaveformStore::buildGpuGeometry(SmoothingCache &samples,
+                                     size_t total, float globalHue,
+                                     float width, float height,
+                                     float opacity, float radiusScale) {
+  // Index vertices only change with the layout, not with the audio, and
+  // those of waveforms before the first changed range stay as uploaded
+  size_t first = gpuGeometry ? firstLayoutChange(ranges, builtRanges) : 0;
+  if (!gpuGeometry || first < ranges.size() ||
+      ranges.size() != builtRanges.size()) {
+    vertices.resize(total);
+    writeGpuIndexVertices(ranges, first, vertices);
+
+    // From the bridge leading into the first changed waveform. Disabled
+    // waveforms take no space, so it ends where that waveform starts.
+    size_t begin = first < ranges.size() ? ranges[first].normalOffset : total;
+    if (!gpuGeometry) {
+      begin = 0;
+    } else if (first > 0) {
+      begin -= std::min(begin, BRIDGE_VERTICES);
+    }
+    gpuGeometry = true;
+    pipelined = false;
+    builtRanges = ranges;
+    dirtyBegin = std::min(dirtyBegin == dirtyEnd ? begin : dirtyBegin, begin);
+    dirtyEnd = total;
+  }
+
+  packGpuGeometry(frameConfigs(), rotationAngles, ranges, samples, globalHue,
+                  width, height, opacity, radiusScale, quality, gpuFrame);
+  if (gpuFrame.sampleSize.x == 0 || gpuFrame.waveformSize.y == 0) {
+    return;
+  }
+
+  perf::ScopedTimer timer(perf::Timer::Upload);
+  if (updateTexture(sampleTexture, gpuFrame.samplePixels.data(),
+                    gpuFrame.sampleSize)) {
+    updateTexture(waveformTexture, gpuFrame.waveformPixels.data(),
+                  gpuFrame.waveformSize);
+  }
+}
+
+void WaveformStore::uploadGeometry(const std::vector<sf::Vertex> &source) {
+  perf::ScopedTimer timer(perf::Timer::Upload);
+  if (!vertexBuffer) {
+    vertexBuffer = std::make_unique<sf::VertexBuffer>(
+        sf::LineStrip, sf::VertexBuffer::Stream);
+  }
+
+  // Grow with headroom so small layout changes do not reallocate
+  if (vertexBuffer->getVertexCount() < source.size()) {
+    if (!vertexBuffer->create(source.size() + source.size() / 2)) {
+      vertexBuffer.reset();
+      return;
+    }
+    dirtyBegin = 0;
+    dirtyEnd = source.size();
+  }
+
+  if (dirtyEnd > dirtyBegin) {
+    vertexBuffer->update(source.data() + dirtyBegin, dirtyEnd - dirtyBegin,
+                         static_cast<unsigned int>(dirtyBegin));
+  }
+  dirtyBegin = dirtyEnd = 0;
+}
+
+void WaveformStore::render(sf::RenderTarget &target) {
+  // Until the producer finishes its first frame, any geometry built inline
+  // is drawn instead
+  if (pipelined && renderProduced(target)) {
+    return;
+  }
+  if (vertices.empty()) {
+    return;
+  }
+
+  sf::RenderStates states;
+  if (gpuGeometry) {
+    if (!geometryShader || !sampleTexture || !waveformTexture) {
+      return;
+    }
+
+    // The shader is shared between stores, so set everything per draw
+    setGpuGeometryUniforms(*geometryShader, gpuFrame, *sampleTexture,
+                           *waveformTexture);
+    states.shader = geometryShader;
+  }
+
+  if (sf::VertexBuffer::isAvailable()) {
+    if (bufferHoldsProduced) {
+      // Overwritten by the producer's frames since vertices was uploaded
+      dirtyBegin = 0;
+      dirtyEnd = vertices.size();
+      bufferHoldsProduced = false;
+    }
+    if (dirtyEnd > dirtyBegin || !vertexBuffer) {
+      uploadGeometry(vertices);
+    }
+    if (vertexBuffer) {
+      target.draw(*vertexBuffer, 0, vertices.size(), states);
+      return;
+    }
+  }
+
+  // Client-side fallback when VBOs are unavailable
+  target.draw(vertices.data(), vertices.size(), sf::LineStrip, states);
+}
+
+bool WaveformStore::renderProduced(sf::RenderTarget &target) {
+  GeometryProducer &geometryProducer = *producer.get();
+  bool fresh = geometryProducer.acquire();
+  const std::vector<sf::Vertex> &produced = geometryProducer.vertices();
+  if (produced.empty()) {
+    return false;
+  }
+
+  if (sf::VertexBuffer::isAvailable()) {
+    if (fresh || !vertexBuffer || !bufferHoldsProduced) {
+      dirtyBegin = 0;
+      dirtyEnd = produced.size();
+      uploadGeometry(produced);
+      bufferHoldsProduced = true;
+    }
+    if (vertexBuffer) {
+      target.draw(*vertexBuffer, 0, produced.size());
+      return true;
+    }
+  }
+
+  target.draw(produced.data(), produced.size(), sf::LineStrip);
+  return true;
+}
@@ -0,0 +1,310 @@
+// Equivalence check between the two ways a scene's waveform geometry is
+// built: buildCpuGeometry, and waveform.vert run over the index vertices
+// with its parameters packed into textures by packGpuGeometry. The scene
+// has more waveforms than the shader's old uniform arrays held and covers
+// every interpolation, several smoothing settings, a transparent thick
+// pass and a disabled layer. waveform.vert's outputs are captured with
+// transform feedback and compared vertex by vertex with the CPU geometry
+// at several point multipliers. Exits non-zero on a mismatch. Needs a GL
+// 3.0 context. Built from the repository root with
+//
+//   c++ -std=c++17 -O2 -Iinclude tools/benchmarks/gpu_geometry_check.cpp
+//       src/AudioUtils.cpp src/ColorLut.cpp src/PerfTimers.cpp
+//       src/SmoothingCache.cpp src/WaveformDrawer.cpp src/WaveformGeometry.cpp
+//       -lsfml-graphics -lsfml-window -lsfml-system -lGL
+//       -o gpu_geometry_check
+//
+//   gpu_geometry_check [shader = waveform.vert]
+
+#include "SmoothingCache.h"
+#include "WaveformDrawer.h"
+#include "WaveformGeometry.h"
+#include <SFML/Graphics.hpp>
+#include <SFML/OpenGL.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+namespace {
+
+// Transform feedback and buffer objects, absent from the 1.1 headers
+constexpr GLenum LINK_STATUS = 0x8B82;
+constexpr GLenum INTERLEAVED_ATTRIBS = 0x8C8C;
+constexpr GLenum RASTERIZER_DISCARD = 0x8C89;
+constexpr GLenum TRANSFORM_FEEDBACK_BUFFER = 0x8C8E;
+constexpr GLenum STATIC_READ = 0x88E5;
+
+struct FeedbackFunctions {
+  using TransformFeedbackVaryings = void(APIENTRY *)(GLuint, GLsizei,
+                                                     const char *const *,
+                                                     GLenum);
+  using LinkProgram = void(APIENTRY *)(GLuint);
+  using GetProgramiv = void(APIENTRY *)(GLuint, GLenum, GLint *);
+  using GenBuffers = void(APIENTRY *)(GLsizei, GLuint *);
+  using DeleteBuffers = void(APIENTRY *)(GLsizei, const GLuint *);
+  using BindBuffer = void(APIENTRY *)(GLenum, GLuint);
+  using BindBufferBase = void(APIENTRY *)(GLenum, GLuint, GLuint);
+  using BufferData = void(APIENTRY *)(GLenum, std::ptrdiff_t, const void *,
+                                      GLenum);
+  using GetBufferSubData = void(APIENTRY *)(GLenum, std::ptrdiff_t,
+                                            std::ptrdiff_t, void *);
+  using BeginTransformFeedback = void(APIENTRY *)(GLenum);
+  using EndTransformFeedback = void(APIENTRY *)();
+
+  TransformFeedbackVaryings transformFeedbackVaryings = nullptr;
+  LinkProgram linkProgram = nullptr;
+  GetProgramiv getProgramiv = nullptr;
+  GenBuffers genBuffers = nullptr;
+  DeleteBuffers deleteBuffers = nullptr;
+  BindBuffer bindBuffer = nullptr;
+  BindBufferBase bindBufferBase = nullptr;
+  BufferData bufferData = nullptr;
+  GetBufferSubData getBufferSubData = nullptr;
+  BeginTransformFeedback beginTransformFeedback = nullptr;
+  EndTransformFeedback endTransformFeedback = nullptr;
+
+  bool loaded() const {
+    return transformFeedbackVaryings && linkProgram && getProgramiv &&
+           genBuffers && deleteBuffers && bindBuffer && bindBufferBase &&
+           bufferData && getBufferSubData && beginTransformFeedback &&
+           endTransformFeedback;
+  }
+};
+
+template <typename F> F load(const char *name) {
+  return reinterpret_cast<F>(sf::Context::getFunction(name));
+}
+
+FeedbackFunctions loadFeedbackFunctions() {
+  using F = FeedbackFunctions;
+  F f;
+  f.transformFeedbackVaryings =
+      load<F::TransformFeedbackVaryings>("glTransformFeedbackVaryings");
+  f.linkProgram = load<F::LinkProgram>("glLinkProgram");
+  f.getProgramiv = load<F::GetProgramiv>("glGetProgramiv");
+  f.genBuffers = load<F::GenBuffers>("glGenBuffers");
+  f.deleteBuffers = load<F::DeleteBuffers>("glDeleteBuffers");
+  f.bindBuffer = load<F::BindBuffer>("glBindBuffer");
+  f.bindBufferBase = load<F::BindBufferBase>("glBindBufferBase");
+  f.bufferData = load<F::BufferData>("glBufferData");
+  f.getBufferSubData = load<F::GetBufferSubData>("glGetBufferSubData");
+  f.beginTransformFeedback =
+      load<F::BeginTransformFeedback>("glBeginTransformFeedback");
+  f.endTransformFeedback =
+      load<F::EndTransformFeedback>("glEndTransformFeedback");
+  return f;
+}
+
+constexpr float WIDTH = 1280.0f;
+constexpr float HEIGHT = 720.0f;
+constexpr size_t WAVEFORMS = 40;
+
+// What waveform.vert writes per vertex: gl_Position, then gl_FrontColor
+struct Captured {
+  float position[4];
+  float color[4];
+};
+
+std::vector<WaveformConfig> testScene() {
+  std::vector<WaveformConfig> configs(WAVEFORMS);
+  for (size_t i = 0; i < configs.size(); ++i) {
+    WaveformConfig &config = configs[i];
+    config.interpolation =
+        static_cast<int>(i % static_cast<size_t>(Interpolation::Count));
+    config.smoothness = static_cast<int>(i % 3) * 4;
+    config.smoothingPasses = 1 + static_cast<int>(i % 5) / 2;
+    config.displayHeight = (i % 8 == 7 ? -1.0f : 1.0f) *
+                           (20.0f + 7.0f * static_cast<float>(i % 9));
+    config.radiusFactor = 0.1f + 0.05f * static_cast<float>(i % 10);
+    config.thickness = 1.0f + 3.0f * static_cast<float>(i % 6);
+    config.hueOffset = static_cast<float>(i % 10) / 10.0f;
+    config.alpha = static_cast<sf::Uint8>(255 - i * 3);
+    config.thickAlpha = i % 7 == 3 ? 0 : static_cast<sf::Uint8>(120 + i);
+    config.enabled = i % 11 != 5;
+  }
+  return configs;
+}
+
+// Mirrored audio with content at several frequencies, so every kernel's
+// neighbours differ
+std::vector<double> testAudio(size_t length) {
+  std::vector<double> audio(length);
+  for (size_t i = 0; i < length; ++i) {
+    double t = static_cast<double>(i) / static_cast<double>(length);
+    audio[i] = 0.6 * std::sin(2.0 * M_PI * 3.0 * t) +
+               0.3 * std::sin(2.0 * M_PI * 37.0 * t + 0.4) +
+               0.1 * std::sin(2.0 * M_PI * 181.0 * t + 1.3);
+  }
+  return audio;
+}
+
+bool upload(sf::Texture &texture, const std::vector<sf::Uint8> &pixels,
+            sf::Vector2u size) {
+  if (!texture.create(size.x, size.y)) {
+    return false;
+  }
+  texture.update(pixels.data(), size.x, size.y, 0, 0);
+  return true;
+}
+
+// Run waveform.vert over the index vertices and read back what it wrote
+std::vector<Captured> runShader(const FeedbackFunctions &gl,
+                                sf::Shader &shader,
+                                const std::vector<sf::Vertex> &indices) {
+  GLuint buffer = 0;
+  gl.genBuffers(1, &buffer);
+  gl.bindBuffer(TRANSFORM_FEEDBACK_BUFFER, buffer);
+  gl.bufferData(TRANSFORM_FEEDBACK_BUFFER,
+                static_cast<std::ptrdiff_t>(indices.size() * sizeof(Captured)),
+                nullptr, STATIC_READ);
+  gl.bindBufferBase(TRANSFORM_FEEDBACK_BUFFER, 0, buffer);
+
+  // Identity matrices, so gl_Position is in pixels like the CPU vertices
+  glMatrixMode(GL_PROJECTION);
+  glLoadIdentity();
+  glMatrixMode(GL_MODELVIEW);
+  glLoadIdentity();
+
+  const sf::Vertex *first = indices.data();
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_COLOR_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  glVertexPointer(2, GL_FLOAT, sizeof(sf::Vertex), &first->position);
+  glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(sf::Vertex), &first->color);
+  glTexCoordPointer(2, GL_FLOAT, sizeof(sf::Vertex), &first->texCoords);
+
+  sf::Shader::bind(&shader);
+  glEnable(RASTERIZER_DISCARD);
+  gl.beginTransformFeedback(GL_POINTS);
+  glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(indices.size()));
+  gl.endTransformFeedback();
+  glDisable(RASTERIZER_DISCARD);
+  sf::Shader::bind(nullptr);
+
+  std::vector<Captured> captured(indices.size());
+  gl.getBufferSubData(TRANSFORM_FEEDBACK_BUFFER, 0,
+                      static_cast<std::ptrdiff_t>(captured.size() *
+                                                  sizeof(Captured)),
+                      captured.data());
+  gl.bindBuffer(TRANSFORM_FEEDBACK_BUFFER, 0);
+  gl.deleteBuffers(1, &buffer);
+  return captured;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const char *shaderPath = argc > 1 ? argv[1] : "waveform.vert";
+
+  sf::Context context;
+  const FeedbackFunctions gl = loadFeedbackFunctions();
+  if (!sf::Shader::isAvailable() || !gl.loaded()) {
+    std::fprintf(stderr, "Needs a GL 3.0 context with transform feedback\n");
+    return EXIT_FAILURE;
+  }
+
+  // Outputs to capture have to be named before linking, so the program SFML
+  // built is relinked before any uniform location is looked up
+  sf::Shader shader;
+  if (!shader.loadFromFile(shaderPath, sf::Shader::Vertex)) {
+    return EXIT_FAILURE;
+  }
+  const char *varyings[] = {"gl_Position", "gl_FrontColor"};
+  const GLuint program = shader.getNativeHandle();
+  gl.transformFeedbackVaryings(program, 2, varyings, INTERLEAVED_ATTRIBS);
+  gl.linkProgram(program);
+  GLint linked = GL_FALSE;
+  gl.getProgramiv(program, LINK_STATUS, &linked);
+  if (linked != GL_TRUE) {
+    std::fprintf(stderr, "Relinking %s for transform feedback failed\n",
+                 shaderPath);
+    return EXIT_FAILURE;
+  }
+
+  const std::vector<WaveformConfig> configs = testScene();
+  std::vector<float> rotationAngles(configs.size());
+  for (size_t i = 0; i < rotationAngles.size(); ++i) {
+    rotationAngles[i] = 0.7f * static_cast<float>(i) - 9.0f;
+  }
+  SmoothingCache samples;
+  samples.build(testAudio(512));
+
+  const float globalHue = 0.35f;
+  const float opacity = 0.8f;
+  const float radiusScale = 1.1f;
+
+  // Positions are float maths on both sides; colours differ by the CPU
+  // palette's hue steps and its truncated alphas
+  const float positionTolerance = 0.25f;
+  const float colorTolerance = 2.0f;
+  bool passed = true;
+
+  std::printf("%d waveforms, %zu mirrored samples\n",
+              static_cast<int>(configs.size()), samples.samples().size());
+  for (int multiplier : {10, 3, 7}) {
+    RenderQuality quality;
+    quality.pointMultiplier = multiplier;
+
+    std::vector<GeometryRange> ranges;
+    const size_t total = layoutGeometry(
+        configs, waveformPointCount(samples.samples().size(), multiplier),
+        quality.thickStep, ranges);
+
+    std::vector<sf::Vertex> cpu(total);
+    buildCpuGeometry(configs, rotationAngles, ranges, samples, globalHue,
+                     WIDTH, HEIGHT, opacity, radiusScale, quality, cpu);
+
+    std::vector<sf::Vertex> indices(total);
+    GpuGeometryFrame frame;
+    writeGpuIndexVertices(ranges, 0, indices);
+    packGpuGeometry(configs, rotationAngles, ranges, samples, globalHue,
+                    WIDTH, HEIGHT, opacity, radiusScale, quality, frame);
+    sf::Texture sampleTexture;
+    sf::Texture waveformTexture;
+    if (!upload(sampleTexture, frame.samplePixels, frame.sampleSize) ||
+        !upload(waveformTexture, frame.waveformPixels, frame.waveformSize)) {
+      std::fprintf(stderr, "Texture creation failed\n");
+      return EXIT_FAILURE;
+    }
+    setGpuGeometryUniforms(shader, frame, sampleTexture, waveformTexture);
+    const std::vector<Captured> gpu = runShader(gl, shader, indices);
+
+    float positionError = 0.0f;
+    float colorError = 0.0f;
+    size_t worst = 0;
+    for (size_t v = 0; v < total; ++v) {
+      const sf::Vertex &expected = cpu[v];
+      const Captured &actual = gpu[v];
+      float distance = std::hypot(actual.position[0] - expected.position.x,
+                                  actual.position[1] - expected.position.y);
+      const sf::Uint8 channels[] = {expected.color.r, expected.color.g,
+                                    expected.color.b, expected.color.a};
+      float channelError = 0.0f;
+      for (int c = 0; c < 4; ++c) {
+        channelError = std::max(
+            channelError, std::abs(actual.color[c] * 255.0f - channels[c]));
+      }
+      if (distance > positionError) {
+        positionError = distance;
+        worst = v;
+      }
+      colorError = std::max(colorError, channelError);
+    }
+
+    bool ok = positionError <= positionTolerance &&
+              colorError <= colorTolerance;
+    std::printf("Multiplier %2d: %zu vertices, max position error %.4f px "
+                "(vertex %zu), max colour error %.2f/255 %s\n",
+                multiplier, total, positionError, worst, colorError,
+                ok ? "ok" : "MISMATCH");
+    passed = passed && ok;
+  }
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
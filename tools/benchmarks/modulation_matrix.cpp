@@ -0,0 +1,186 @@
+// Cost of the modulation matrix at scale: 5000 routes across 200
+// waveforms, from every source, curve and target, some driving every
+// waveform. Times evaluating the routes, applying them to the configs and
+// making the layout bounds the GPU geometry path lays out from. Also
+// checks, over frames of changing audio, that the bounded layout never
+// changes and always holds the frame's own layout, and counts how often
+// the frame's own layout changed. Exits non-zero if the bounds fail.
+// Built from the repository root with
+//
+//   c++ -std=c++17 -O2 -Iinclude tools/benchmarks/modulation_matrix.cpp
+//       src/AudioUtils.cpp src/ColorLut.cpp src/JsonReader.cpp
+//       src/ModulationMatrix.cpp src/PerfTimers.cpp src/SmoothingCache.cpp
+//       src/WaveformDrawer.cpp src/WaveformGeometry.cpp -lsfml-graphics
+//       -lsfml-system -o modulation_matrix
+//
+//   modulation_matrix [frames = 2000]
+
+#include "ModulationMatrix.h"
+#include "WaveformDrawer.h"
+#include "WaveformGeometry.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr size_t WAVEFORMS = 200;
+constexpr size_t ROUTES = 5000;
+constexpr size_t BANDS = 64;
+constexpr size_t POINTS = 2048 * 10; // A 1024-sample window at x10
+
+ModulationSettings testRoutes(std::mt19937 &random) {
+  std::uniform_int_distribution<int> source(
+      0, static_cast<int>(ModSource::Count) - 1);
+  std::uniform_int_distribution<int> band(0, static_cast<int>(BANDS) - 1);
+  std::uniform_int_distribution<int> curve(
+      0, static_cast<int>(ModCurve::Count) - 1);
+  std::uniform_int_distribution<int> target(
+      0, static_cast<int>(ModTarget::Count) - 1);
+  std::uniform_int_distribution<int> waveform(0,
+                                              static_cast<int>(WAVEFORMS) - 1);
+  std::uniform_real_distribution<float> depth(-0.3f, 0.3f);
+
+  ModulationSettings settings;
+  for (size_t i = 0; i < ROUTES; ++i) {
+    ModulationRoute route;
+    route.source = source(random);
+    route.band = band(random);
+    route.curve = curve(random);
+    route.target = target(random);
+    route.waveform = i % 100 == 0 ? -1 : waveform(random);
+    route.depth = depth(random);
+    settings.routes.push_back(route);
+  }
+  return settings;
+}
+
+template <typename Body> double microsPerFrame(int frames, Body body) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < frames; ++frame) {
+    body(frame);
+  }
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         frames;
+}
+
+// Whether every waveform's passes in frame fit in the same waveform's
+// passes in bounds
+bool layoutFits(const std::vector<GeometryRange> &frame,
+                const std::vector<GeometryRange> &bounds) {
+  for (size_t i = 0; i < frame.size(); ++i) {
+    if (frame[i].normalCount != bounds[i].normalCount ||
+        frame[i].thickCount > bounds[i].thickCount) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool sameLayout(const std::vector<GeometryRange> &a,
+                const std::vector<GeometryRange> &b) {
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].thickOffset != b[i].thickOffset ||
+        a[i].thickCount != b[i].thickCount) {
+      return false;
+    }
+  }
+  return a.size() == b.size();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+
+  std::mt19937 random(1234);
+  std::vector<WaveformConfig> configs(WAVEFORMS);
+  for (size_t i = 0; i < configs.size(); ++i) {
+    configs[i].thickness = 2.0f + static_cast<float>(i % 8);
+    configs[i].thickAlpha = i % 5 == 0 ? 0 : 200;
+  }
+
+  ModulationMatrix matrix;
+  matrix.setSettings(testRoutes(random));
+
+  // Audio that moves every frame
+  std::uniform_real_distribution<float> level(0.0f, 1.0f);
+  std::vector<float> bands(BANDS);
+  ModulationInputs inputs;
+  inputs.bands = bands.data();
+  inputs.bandCount = bands.size();
+  auto nextInputs = [&](int frame) {
+    inputs.rms = level(random) * 0.5f;
+    inputs.peak = level(random);
+    inputs.beatPhase = static_cast<float>(frame % 30) / 30.0f;
+    inputs.beatPulse = std::exp(-0.2f * static_cast<float>(frame % 30));
+    for (float &value : bands) {
+      value = level(random);
+    }
+  };
+
+  nextInputs(0);
+  matrix.evaluate(inputs, WAVEFORMS, 1.0f / 60.0f);
+  std::printf("%zu routes across %zu waveforms compile to %zu\n", ROUTES,
+              WAVEFORMS, matrix.getCompiledRouteCount());
+
+  std::vector<WaveformConfig> modulated;
+  std::vector<WaveformConfig> bounded;
+  const double evaluate = microsPerFrame(frames, [&](int frame) {
+    inputs.beatPhase = static_cast<float>(frame % 30) / 30.0f;
+    matrix.evaluate(inputs, WAVEFORMS, 1.0f / 60.0f);
+  });
+  const double apply = microsPerFrame(frames, [&](int) {
+    matrix.applyToWaveforms(configs, modulated);
+  });
+  const double bounds = microsPerFrame(frames, [&](int) {
+    matrix.applyLayoutBounds(configs, bounded);
+  });
+  std::printf("evaluate %.2f us, apply %.2f us, layout bounds %.2f us per "
+              "frame\n",
+              evaluate, apply, bounds);
+
+  // The bounds only change with the routes and configs, so one layout made
+  // from them must hold every frame
+  std::vector<GeometryRange> boundedLayout;
+  std::vector<GeometryRange> frameLayout;
+  std::vector<GeometryRange> previousLayout;
+  std::vector<GeometryRange> layout;
+  matrix.applyLayoutBounds(configs, bounded);
+  layoutGeometry(bounded, POINTS, WAVEFORM_THICK_STEP, boundedLayout);
+
+  bool passed = true;
+  int frameLayoutChanges = 0;
+  for (int frame = 0; frame < frames; ++frame) {
+    nextInputs(frame);
+    matrix.evaluate(inputs, WAVEFORMS, 1.0f / 60.0f);
+    matrix.applyToWaveforms(configs, modulated);
+    matrix.applyLayoutBounds(configs, bounded);
+
+    layoutGeometry(modulated, POINTS, WAVEFORM_THICK_STEP, frameLayout);
+    layoutGeometry(bounded, POINTS, WAVEFORM_THICK_STEP, layout);
+    if (!sameLayout(layout, boundedLayout) ||
+        !layoutFits(frameLayout, boundedLayout)) {
+      std::fprintf(stderr, "Frame %d does not fit the bounded layout\n",
+                   frame);
+      passed = false;
+      break;
+    }
+    if (frame > 0 && !sameLayout(frameLayout, previousLayout)) {
+      ++frameLayoutChanges;
+    }
+    previousLayout.swap(frameLayout);
+  }
+
+  std::printf("Layout from modulated configs changed on %d of %d frames; "
+              "bounded layout %s\n",
+              frameLayoutChanges, frames - 1,
+              passed ? "fixed and holds every frame" : "FAILED");
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,287 @@
+// Bulk-load benchmark for preset parsing. Every preset in a directory is
+// read into memory once, then parsed repeatedly by json::Reader (through
+// VisualizerPreset::fromJSON) and by a copy of the extractValue parser it
+// replaced. Larger synthetic presets, with many waveforms, show how the old
+// per-key search grew with the document. Exits non-zero if the two parsers
+// disagree on any value. Built from the repository root with
+//
+//   c++ -std=c++17 -O2 -Iinclude tools/benchmarks/preset_parse.cpp
+//       src/ConfigSerializer.cpp src/JsonReader.cpp src/ModulationMatrix.cpp
+//       src/ShaderConfig.cpp src/VisualizerConfig.cpp src/WaveformConfig.cpp
+//       -lsfml-graphics -lsfml-window -lsfml-system -o preset_parse
+//
+//   preset_parse [directory = presets] [passes = 200]
+
+#include "ConfigSerializer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace legacy {
+
+// The parser json::Reader replaced: every key searches the whole section
+std::string extractValue(const std::string &content, const std::string &key) {
+  std::string searchKey = "\"" + key + "\":";
+  size_t pos = content.find(searchKey);
+  if (pos == std::string::npos) return "";
+
+  pos += searchKey.length();
+  size_t endPos = content.find_first_of(",\n}", pos);
+  if (endPos == std::string::npos) return "";
+
+  std::string value = content.substr(pos, endPos - pos);
+  size_t first = value.find_first_not_of(" \t\n\r\"");
+  if (first == std::string::npos) return "";
+  size_t last = value.find_last_not_of(" \t\n\r\",\"");
+  return value.substr(first, last - first + 1);
+}
+
+std::string extractSection(const std::string &content, const std::string &key) {
+  std::string searchKey = "\"" + key + "\":";
+  size_t pos = content.find(searchKey);
+  if (pos == std::string::npos) return "";
+  size_t start = content.find("{", pos);
+  if (start == std::string::npos) return "";
+
+  int braceCount = 1;
+  size_t end = start + 1;
+  while (end < content.length() && braceCount > 0) {
+    if (content[end] == '{') braceCount++;
+    else if (content[end] == '}') braceCount--;
+    end++;
+  }
+  return braceCount == 0 ? content.substr(start, end - start) : "";
+}
+
+template <typename T, typename Parse>
+void read(const std::string &json, const char *key, T &field, Parse parse) {
+  std::string val = extractValue(json, key);
+  if (!val.empty()) field = static_cast<T>(parse(val));
+}
+
+float toFloat(const std::string &s) { return std::stof(s); }
+int toInt(const std::string &s) { return std::stoi(s); }
+bool toBool(const std::string &s) { return s == "true"; }
+
+void parseWaveform(const std::string &json, WaveformConfig &c) {
+  read(json, "displayHeight", c.displayHeight, toFloat);
+  read(json, "smoothness", c.smoothness, toInt);
+  read(json, "smoothingPasses", c.smoothingPasses, toInt);
+  read(json, "rotationSpeed", c.rotationSpeed, toFloat);
+  read(json, "radiusFactor", c.radiusFactor, toFloat);
+  read(json, "thickness", c.thickness, toFloat);
+  read(json, "hueOffset", c.hueOffset, toFloat);
+  read(json, "alpha", c.alpha, toInt);
+  read(json, "thickAlpha", c.thickAlpha, toInt);
+  read(json, "interpolation", c.interpolation, toInt);
+  read(json, "enabled", c.enabled, toBool);
+}
+
+void parsePreset(const std::string &json, VisualizerPreset &preset) {
+  preset.name = extractValue(json, "name");
+
+  std::string viz = extractSection(json, "visualizerConfig");
+  VisualizerConfig &v = preset.visualizerConfig;
+  read(viz, "smoothness", v.smoothness, toInt);
+  read(viz, "rotationSpeed", v.rotationSpeed, toFloat);
+  read(viz, "waveformHeight", v.waveformHeight, toFloat);
+  read(viz, "radiusFactor", v.radiusFactor, toFloat);
+  read(viz, "thickness", v.thickness, toInt);
+  read(viz, "hueOffset", v.hueOffset, toFloat);
+  read(viz, "hue", v.hue, toFloat);
+  read(viz, "hueRotationSpeed", v.hueRotationSpeed, toFloat);
+
+  std::string shader = extractSection(json, "shaderConfig");
+  ShaderConfig &s = preset.shaderConfig;
+  read(shader, "fadeFactor", s.fadeFactor, toFloat);
+  read(shader, "pixelSize", s.pixelSize, toInt);
+  read(shader, "blendFactor", s.blendFactor, toFloat);
+  read(shader, "fadeThreshold", s.fadeThreshold, toFloat);
+  read(shader, "saturationBoost", s.saturationBoost, toFloat);
+  read(shader, "ditherStrength", s.ditherStrength, toFloat);
+
+  preset.waveforms.clear();
+  size_t waveformsStart = json.find("\"waveforms\"");
+  if (waveformsStart == std::string::npos) return;
+  size_t arrayStart = json.find("[", waveformsStart);
+  size_t arrayEnd = json.rfind("]");
+  if (arrayStart == std::string::npos || arrayEnd == std::string::npos) return;
+
+  std::string arrayContent =
+      json.substr(arrayStart + 1, arrayEnd - arrayStart - 1);
+  int braceCount = 0;
+  size_t objStart = 0;
+  for (size_t i = 0; i < arrayContent.length(); ++i) {
+    if (arrayContent[i] == '{') {
+      if (braceCount == 0) objStart = i;
+      braceCount++;
+    } else if (arrayContent[i] == '}' && --braceCount == 0) {
+      WaveformConfig config;
+      parseWaveform(arrayContent.substr(objStart, i - objStart + 1), config);
+      preset.waveforms.push_back(config);
+    }
+  }
+}
+
+} // namespace legacy
+
+namespace {
+
+struct Document {
+  std::string name;
+  std::string json;
+};
+
+// A preset with many layers, as a large scene would save. Written without
+// a modulation section, whose arrays the old parser would mistake for the
+// end of the waveforms.
+std::string syntheticPreset(size_t waveformCount) {
+  std::ostringstream oss;
+  oss << "{\n  \"name\": \"Synthetic " << waveformCount << "\",\n";
+  oss << "  \"visualizerConfig\": " << VisualizerConfig().toJSON(2) << ",\n";
+  oss << "  \"shaderConfig\": " << ShaderConfig().toJSON(2) << ",\n";
+  oss << "  \"waveforms\": [\n";
+  for (size_t i = 0; i < waveformCount; ++i) {
+    WaveformConfig config;
+    config.displayHeight = 50.0f + static_cast<float>(i % 200);
+    config.smoothness = static_cast<int>(i % 16);
+    config.rotationSpeed = 0.01f * static_cast<float>(i % 50) - 0.25f;
+    config.hueOffset = static_cast<float>(i % 100) / 100.0f;
+    config.alpha = static_cast<sf::Uint8>(128 + i % 128);
+    oss << config.toJSON(4) << (i + 1 < waveformCount ? ",\n" : "\n");
+  }
+  oss << "  ]\n}\n";
+  return oss.str();
+}
+
+bool sameWaveform(const WaveformConfig &a, const WaveformConfig &b) {
+  return a.displayHeight == b.displayHeight && a.smoothness == b.smoothness &&
+         a.smoothingPasses == b.smoothingPasses &&
+         a.rotationSpeed == b.rotationSpeed &&
+         a.radiusFactor == b.radiusFactor && a.thickness == b.thickness &&
+         a.hueOffset == b.hueOffset && a.alpha == b.alpha &&
+         a.thickAlpha == b.thickAlpha &&
+         a.interpolation == b.interpolation && a.enabled == b.enabled;
+}
+
+// Only the fields both parsers read
+bool samePreset(const VisualizerPreset &a, const VisualizerPreset &b) {
+  const VisualizerConfig &va = a.visualizerConfig;
+  const VisualizerConfig &vb = b.visualizerConfig;
+  const ShaderConfig &sa = a.shaderConfig;
+  const ShaderConfig &sb = b.shaderConfig;
+  if (a.waveforms.size() != b.waveforms.size() ||
+      va.smoothness != vb.smoothness ||
+      va.rotationSpeed != vb.rotationSpeed ||
+      va.waveformHeight != vb.waveformHeight ||
+      va.radiusFactor != vb.radiusFactor || va.thickness != vb.thickness ||
+      va.hueOffset != vb.hueOffset ||
+      va.hueRotationSpeed != vb.hueRotationSpeed ||
+      sa.fadeFactor != sb.fadeFactor || sa.pixelSize != sb.pixelSize ||
+      sa.blendFactor != sb.blendFactor ||
+      sa.fadeThreshold != sb.fadeThreshold ||
+      sa.saturationBoost != sb.saturationBoost ||
+      sa.ditherStrength != sb.ditherStrength) {
+    return false;
+  }
+  for (size_t i = 0; i < a.waveforms.size(); ++i) {
+    if (!sameWaveform(a.waveforms[i], b.waveforms[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename Parse>
+double timePerPass(const std::vector<Document> &documents, int passes,
+                   Parse parse) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < passes; ++pass) {
+    for (const Document &document : documents) {
+      parse(document);
+    }
+  }
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         passes;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const std::string directory = argc > 1 ? argv[1] : "presets";
+  const int passes = argc > 2 ? std::max(1, std::atoi(argv[2])) : 200;
+
+  std::vector<Document> library;
+  std::error_code ec;
+  for (const auto &entry : fs::directory_iterator(directory, ec)) {
+    if (entry.path().extension() != ".json") {
+      continue;
+    }
+    std::ifstream file(entry.path(), std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    library.push_back({entry.path().filename().string(), contents.str()});
+  }
+  if (library.empty()) {
+    std::fprintf(stderr, "No presets found in %s\n", directory.c_str());
+    return EXIT_FAILURE;
+  }
+
+  int mismatches = 0;
+  for (const Document &document : library) {
+    VisualizerPreset current;
+    VisualizerPreset old;
+    bool parsed = current.fromJSON(document.json);
+    legacy::parsePreset(document.json, old);
+    if (!parsed || !samePreset(current, old)) {
+      std::fprintf(stderr, "Parsers disagree on %s\n", document.name.c_str());
+      ++mismatches;
+    }
+  }
+
+  std::printf("%-22s %10s %12s %12s %8s\n", "Documents", "Bytes",
+              "Old us/pass", "New us/pass", "Speedup");
+  const auto report = [&](const char *label,
+                          const std::vector<Document> &documents) {
+    size_t bytes = 0;
+    for (const Document &document : documents) {
+      bytes += document.json.size();
+    }
+    VisualizerPreset preset;
+    const double old = timePerPass(documents, passes, [&](const Document &d) {
+      legacy::parsePreset(d.json, preset);
+    });
+    const double current =
+        timePerPass(documents, passes,
+                    [&](const Document &d) { preset.fromJSON(d.json); });
+    std::printf("%-22s %10zu %12.1f %12.1f %7.1fx\n", label, bytes, old,
+                current, old / current);
+  };
+
+  report(("Library (" + std::to_string(library.size()) + ")").c_str(),
+         library);
+  for (size_t waveforms : {16, 64, 256}) {
+    Document synthetic{"synthetic", syntheticPreset(waveforms)};
+    VisualizerPreset current;
+    VisualizerPreset old;
+    current.fromJSON(synthetic.json);
+    legacy::parsePreset(synthetic.json, old);
+    if (!samePreset(current, old)) {
+      std::fprintf(stderr, "Parsers disagree on %zu waveforms\n", waveforms);
+      ++mismatches;
+    }
+    report((std::to_string(waveforms) + " waveforms").c_str(), {synthetic});
+  }
+
+  return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,129 @@
+// Equivalence check and timing for SmoothingCache against the per-waveform
+// smoothing it replaced. Every radius and pass count is compared with
+// smoothAudioData applied the same number of times to the mirrored buffer,
+// over several buffer sizes including ones shorter than the window. Both
+// accumulate rounding in running sums, so results agree to within about
+// 1e-12 rather than exactly, far below the 16-bit sample texture's step.
+// Exits non-zero if any sample differs by more than that. Then times a
+// frame of waveforms smoothed one by one against one shared cache. Built
+// from the repository root with
+//
+//   c++ -std=c++17 -O2 -Iinclude tools/benchmarks/smoothing_check.cpp
+//       src/AudioUtils.cpp src/SmoothingCache.cpp -o smoothing_check
+//
+//   smoothing_check [frames = 2000]
+
+#include "AudioUtils.h"
+#include "SmoothingCache.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr double TOLERANCE = 1e-12;
+
+// Audio at full scale with a DC offset, the worst case for prefix sums
+std::vector<double> testAudio(size_t length, std::mt19937 &random) {
+  std::uniform_real_distribution<double> noise(-1.0, 1.0);
+  std::vector<double> audio(length);
+  for (size_t i = 0; i < length; ++i) {
+    audio[i] = 0.5 + 0.5 * noise(random);
+  }
+  return audio;
+}
+
+void smoothRepeatedly(const std::vector<double> &input, int radius,
+                      int passes, std::vector<double> &out,
+                      std::vector<double> &scratch) {
+  out = input;
+  for (int pass = 0; pass < passes; ++pass) {
+    smoothAudioData(out, scratch, radius);
+    out.swap(scratch);
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+
+  std::mt19937 random(1234);
+  std::vector<double> expected;
+  std::vector<double> scratch;
+  double worst = 0.0;
+  int comparisons = 0;
+
+  for (size_t length : {1, 2, 3, 17, 256, 1024, 4096}) {
+    SmoothingCache cache;
+    cache.build(testAudio(length, random), 1.7);
+    const std::vector<double> &mirrored = cache.samples();
+    for (int radius : {1, 2, 5, 16, 63, 200, 5000}) {
+      for (int passes = 1; passes <= SmoothingCache::MAX_PASSES; ++passes) {
+        const std::vector<double> &actual = cache.smoothed(radius, passes);
+        smoothRepeatedly(mirrored, radius, passes, expected, scratch);
+        double error = actual.size() == expected.size() ? 0.0 : INFINITY;
+        for (size_t i = 0; i < expected.size() && i < actual.size(); ++i) {
+          error = std::max(error, std::abs(actual[i] - expected[i]));
+        }
+        if (error > TOLERANCE) {
+          std::fprintf(stderr,
+                       "Mismatch: %zu samples, radius %d, %d passes, "
+                       "error %.3g\n",
+                       length, radius, passes, error);
+        }
+        worst = std::max(worst, error);
+        ++comparisons;
+      }
+    }
+  }
+  const bool passed = worst <= TOLERANCE;
+  std::printf("%d comparisons, max error %.3g (tolerance %.0e) %s\n",
+              comparisons, worst, TOLERANCE, passed ? "ok" : "MISMATCH");
+
+  // A frame of the default window with layers sharing some settings, as
+  // a preset would: each smoothed separately, then through one cache
+  const std::vector<double> audio = testAudio(1024, random);
+  const int settings[][2] = {{5, 1}, {5, 1}, {8, 2}, {5, 1},
+                             {12, 3}, {8, 2}, {3, 1}, {5, 1}};
+  std::vector<double> mirrored;
+  std::vector<double> smoothed;
+  double sink = 0.0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < frames; ++frame) {
+    for (const auto &setting : settings) {
+      mirrorAudioBuffer(audio, mirrored);
+      smoothRepeatedly(mirrored, setting[0], setting[1], smoothed, scratch);
+      sink += smoothed[static_cast<size_t>(frame) % smoothed.size()];
+    }
+  }
+  const double separate = std::chrono::duration<double, std::micro>(
+                              std::chrono::steady_clock::now() - start)
+                              .count() /
+                          frames;
+
+  SmoothingCache cache;
+  start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < frames; ++frame) {
+    cache.build(audio);
+    for (const auto &setting : settings) {
+      const std::vector<double> &shared =
+          cache.smoothed(setting[0], setting[1]);
+      sink += shared[static_cast<size_t>(frame) % shared.size()];
+    }
+  }
+  const double shared = std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - start)
+                            .count() /
+                        frames;
+
+  std::printf("8 waveforms: separate %.1f us/frame, shared cache %.1f "
+              "us/frame (%.1fx) [%g]\n",
+              separate, shared, separate / shared, sink);
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,118 @@
+// StftEngine's sliding-DFT tracked bins against the FFT frames. Streams
+// tones and noise through one engine with no tracked bins and one with a
+// few, tracked from a second in, and checks at every hop that each tracked
+// bin reads the same magnitude as that bin of the frame. Also times both
+// streams per sample, so the untracked one shows what tracking costs.
+// Exits non-zero if a tracked bin strays. Built from the repository root
+// with
+//
+//   c++ -std=c++17 -O2 -Iinclude tools/benchmarks/stft_tracked_bins.cpp
+//       src/RealFft.cpp src/StftEngine.cpp -lfftw3 -o stft_tracked_bins
+//
+//   stft_tracked_bins [seconds = 60]
+
+#include "StftEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+constexpr size_t SAMPLE_RATE = 48000;
+constexpr size_t WINDOW_SIZE = 2048;
+constexpr size_t HOP_SIZE = 512;
+constexpr size_t BLOCK = 480; // 10 ms, as capture hands them over
+constexpr size_t TRACKED_FROM = SAMPLE_RATE;
+constexpr double TOLERANCE = 1e-4;
+
+// Lowest and highest trackable bins, one on a tone and one between tones
+const std::vector<size_t> TRACKED_BINS = {1, 12, 93, WINDOW_SIZE / 2 - 1};
+
+std::vector<float> testSignal(size_t samples) {
+  // One tone centred on bin 12, one between bins 93 and 94, and noise
+  std::mt19937 random(1234);
+  std::uniform_real_distribution<float> noise(-0.1f, 0.1f);
+  const double centred = 12.0 * SAMPLE_RATE / WINDOW_SIZE;
+  const double between = 93.5 * SAMPLE_RATE / WINDOW_SIZE;
+  std::vector<float> signal(samples);
+  for (size_t i = 0; i < samples; ++i) {
+    const double t = static_cast<double>(i) / SAMPLE_RATE;
+    signal[i] = static_cast<float>(0.5 * std::sin(2.0 * M_PI * centred * t) +
+                                   0.3 * std::sin(2.0 * M_PI * between * t)) +
+                noise(random);
+  }
+  return signal;
+}
+
+template <typename OnFrame>
+double nanosPerSample(StftEngine &engine, const std::vector<float> &signal,
+                      size_t from, OnFrame onFrame) {
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = from; i < signal.size(); i += BLOCK) {
+    engine.process(signal.data() + i, std::min(BLOCK, signal.size() - i),
+                   onFrame);
+  }
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         static_cast<double>(signal.size() - from);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const int seconds = argc > 1 ? std::max(2, std::atoi(argv[1])) : 60;
+  const std::vector<float> signal =
+      testSignal(static_cast<size_t>(seconds) * SAMPLE_RATE);
+
+  double sink = 0.0;
+  StftEngine untracked(WINDOW_SIZE, HOP_SIZE);
+  const double untrackedNanos =
+      nanosPerSample(untracked, signal, 0, [&](const std::vector<float> &bins) {
+        sink += bins[12];
+      });
+
+  // Tracking starts mid-stream, from whatever window the engine holds
+  StftEngine tracked(WINDOW_SIZE, HOP_SIZE);
+  tracked.process(signal.data(), TRACKED_FROM,
+                  [](const std::vector<float> &) {});
+  tracked.setTrackedBins(TRACKED_BINS);
+
+  double worst = 0.0;
+  size_t worstBin = 0;
+  size_t hops = 0;
+  const double trackedNanos = nanosPerSample(
+      tracked, signal, TRACKED_FROM, [&](const std::vector<float> &bins) {
+        for (size_t i = 0; i < TRACKED_BINS.size(); ++i) {
+          const double error = std::abs(
+              static_cast<double>(tracked.getTrackedMagnitude(i)) -
+              bins[TRACKED_BINS[i]]);
+          if (error > worst) {
+            worst = error;
+            worstBin = TRACKED_BINS[i];
+          }
+        }
+        ++hops;
+      });
+
+  std::printf("%d s at %zu Hz, window %zu, hop %zu\n", seconds, SAMPLE_RATE,
+              WINDOW_SIZE, HOP_SIZE);
+  std::printf("No tracked bins: %.2f ns per sample [%g]\n", untrackedNanos,
+              sink);
+  std::printf("%zu tracked bins: %.2f ns per sample, including the check\n",
+              TRACKED_BINS.size(), trackedNanos);
+
+  const bool passed = worst <= TOLERANCE;
+  std::printf("Tracked bins against the frame over %zu hops: worst %.3g at "
+              "bin %zu, %s\n",
+              hops, worst, worstBin, passed ? "ok" : "MISMATCH");
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
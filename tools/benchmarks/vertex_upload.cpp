@@ -0,0 +1,162 @@
+// Cost of drawing waveform geometry the old way and the batched way, on an
+// offscreen render texture. Geometry changes on every other frame, as when
+// the 60 Hz render stage reuses 30 Hz geometry.
+//
+//   Client arrays: two draws per waveform from client-side vertex arrays,
+//                  which SFML re-sends to the driver on every draw
+//   Batched:       one LineStrip packed with transparent bridges in a
+//                  streaming sf::VertexBuffer, uploaded only on frames where
+//                  the geometry changed and drawn with one call
+//
+// Each frame ends with glFinish so driver work is counted. Needs a GL
+// context. Built from the repository root with
+//
+//   c++ -std=c++17 -O2 tools/benchmarks/vertex_upload.cpp -lsfml-graphics
+//       -lsfml-window -lsfml-system -lGL -o vertex_upload
+//
+//   vertex_upload [waveforms = 8] [frames = 600]
+
+#include <SFML/Graphics.hpp>
+#include <SFML/OpenGL.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+// Matches a 1024-sample window drawn at quality defaults
+constexpr size_t POINTS = 2048;
+constexpr size_t THICK_STEPS = 10;
+constexpr size_t BRIDGE = 2;
+
+struct Scene {
+  std::vector<sf::VertexArray> normal;
+  std::vector<sf::VertexArray> thick;
+  std::vector<sf::Vertex> packed;
+};
+
+void fillPass(sf::Vertex *vertices, size_t count, float radius, float phase,
+              sf::Color color) {
+  for (size_t i = 0; i < count; ++i) {
+    float angle = 6.2831853f * static_cast<float>(i % POINTS) / POINTS;
+    float r = radius + 20.0f * std::sin(angle * 7.0f + phase) +
+              static_cast<float>(i / POINTS);
+    vertices[i] = sf::Vertex(
+        sf::Vector2f(640.0f + r * std::cos(angle), 360.0f + r * std::sin(angle)),
+        color);
+  }
+}
+
+// New geometry for every waveform in both representations
+void regenerate(Scene &scene, size_t waveforms, float phase) {
+  size_t offset = 0;
+  for (size_t w = 0; w < waveforms; ++w) {
+    float radius = 100.0f + 20.0f * static_cast<float>(w);
+    sf::Color color(255, static_cast<sf::Uint8>(w * 30), 128, 200);
+    fillPass(&scene.normal[w][0], POINTS, radius, phase, color);
+    fillPass(&scene.thick[w][0], POINTS * THICK_STEPS, radius, phase, color);
+
+    sf::Vertex *out = scene.packed.data() + offset;
+    for (size_t i = 0; i < POINTS; ++i) {
+      *out++ = scene.normal[w][i];
+    }
+    out[0] = scene.normal[w][POINTS - 1];
+    out[1] = scene.thick[w][0];
+    out[0].color.a = out[1].color.a = 0;
+    out += BRIDGE;
+    for (size_t i = 0; i < POINTS * THICK_STEPS; ++i) {
+      *out++ = scene.thick[w][i];
+    }
+    out[0] = out[-1];
+    out[1] = out[-1];
+    out[0].color.a = out[1].color.a = 0;
+    offset += POINTS + BRIDGE + POINTS * THICK_STEPS + BRIDGE;
+  }
+}
+
+template <typename Draw>
+double millisecondsPerFrame(sf::RenderTexture &target, Scene &scene,
+                            size_t waveforms, int frames, Draw draw) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < frames; ++frame) {
+    bool changed = frame % 2 == 0;
+    if (changed) {
+      regenerate(scene, waveforms, static_cast<float>(frame) * 0.05f);
+    }
+    target.clear();
+    draw(changed);
+    target.display();
+    glFinish();
+  }
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         frames;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const size_t waveforms =
+      argc > 1 ? static_cast<size_t>(std::max(1, std::atoi(argv[1]))) : 8;
+  const int frames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 600;
+
+  sf::RenderTexture target;
+  if (!target.create(1280, 720) || !sf::VertexBuffer::isAvailable()) {
+    std::fprintf(stderr, "Needs a GL context with vertex buffers\n");
+    return EXIT_FAILURE;
+  }
+  target.setActive(true);
+
+  Scene scene;
+  for (size_t w = 0; w < waveforms; ++w) {
+    scene.normal.emplace_back(sf::LineStrip, POINTS);
+    scene.thick.emplace_back(sf::LineStrip, POINTS * THICK_STEPS);
+  }
+  scene.packed.resize(waveforms *
+                      (POINTS + BRIDGE + POINTS * THICK_STEPS + BRIDGE));
+
+  // Generation is the same for both and timed on its own, so it can be
+  // taken out of the totals
+  const auto generateStart = std::chrono::steady_clock::now();
+  for (int i = 0; i < frames / 2; ++i) {
+    regenerate(scene, waveforms, static_cast<float>(i));
+  }
+  const double generate =
+      std::chrono::duration<double, std::milli>(
+          std::chrono::steady_clock::now() - generateStart)
+          .count() /
+      frames;
+
+  const double client = millisecondsPerFrame(
+      target, scene, waveforms, frames, [&](bool) {
+        for (size_t w = 0; w < waveforms; ++w) {
+          target.draw(scene.normal[w]);
+          target.draw(scene.thick[w]);
+        }
+      });
+
+  sf::VertexBuffer buffer(sf::LineStrip, sf::VertexBuffer::Stream);
+  buffer.create(scene.packed.size());
+  const double batched = millisecondsPerFrame(
+      target, scene, waveforms, frames, [&](bool changed) {
+        if (changed) {
+          buffer.update(scene.packed.data());
+        }
+        target.draw(buffer);
+      });
+
+  const double vertexMb =
+      scene.packed.size() * sizeof(sf::Vertex) / (1024.0 * 1024.0);
+  std::printf("%zu waveforms, %zu vertices (%.1f MB) per frame\n", waveforms,
+              scene.packed.size(), vertexMb);
+  std::printf("Client arrays: %.3f ms/frame, %zu draws, %.1f MB sent\n",
+              client - generate, waveforms * 2, vertexMb);
+  std::printf("Batched:       %.3f ms/frame, 1 draw, %.1f MB sent on "
+              "changed frames only\n",
+              batched - generate, vertexMb);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+// Time of every compiled drawWaveform kernel: each interpolation, with and
+// without the thick pass, at each quality-ladder point multiplier and at 7,
+// which takes the generic kernel. Also checks that the kernels other than
+// cubic pass through every sample at the start of its segment, on both
+// passes. Exits non-zero if one does not. Built from the repository root
+// with
+//
+//   c++ -std=c++17 -O2 -Iinclude tools/benchmarks/waveform_kernels.cpp
+//       src/AudioUtils.cpp src/ColorLut.cpp src/WaveformDrawer.cpp
+//       -lsfml-graphics -lsfml-system -o waveform_kernels
+//
+//   waveform_kernels [calls = 200]
+
+#include "AudioUtils.h"
+#include "WaveformDrawer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+// A 1024-sample window, mirrored, at default waveform settings
+constexpr size_t SAMPLES = 1024;
+constexpr float THICKNESS = 5.0f;
+constexpr float WIDTH = 1920.0f;
+constexpr float HEIGHT = 1080.0f;
+constexpr float RADIUS_FACTOR = 0.3f;
+constexpr float DISPLAY_HEIGHT = 30.0f;
+
+const char *const KERNEL_NAMES[] = {"None", "Linear", "Cubic", "Catmull-Rom"};
+const int MULTIPLIERS[] = {3, 4, 5, 6, 7, 8, 10};
+
+struct Buffers {
+  std::vector<sf::Vertex> normal;
+  std::vector<sf::Vertex> thick;
+};
+
+void draw(const std::vector<double> &samples,
+          const std::vector<double> &smoothed, Buffers &out,
+          Interpolation kernel, int multiplier, bool thickPass) {
+  drawWaveform(samples, smoothed, out.normal.data(),
+               thickPass ? out.thick.data() : nullptr, DISPLAY_HEIGHT, 0.0f,
+               RADIUS_FACTOR, WIDTH, HEIGHT, 0.3f, THICKNESS, 0.5f, 255, 200,
+               multiplier, WAVEFORM_THICK_STEP, kernel);
+}
+
+// Largest distance in pixels between a segment's first point and the
+// sample it starts at, on the normal pass and the thick pass's middle line
+double segmentStartError(const std::vector<double> &samples,
+                         const std::vector<double> &smoothed,
+                         const Buffers &out, int multiplier) {
+  const float radius = std::min(WIDTH, HEIGHT) / 2.0f * RADIUS_FACTOR;
+  const size_t steps = thickStepCount(THICKNESS);
+  const size_t middle = steps / 2;
+  const float middleOffset =
+      -THICKNESS / 2.0f + static_cast<float>(middle) * WAVEFORM_THICK_STEP;
+  double worst = 0.0;
+  for (size_t index = 0; index < samples.size(); ++index) {
+    const size_t point = index * static_cast<size_t>(multiplier);
+    const sf::Vector2f normal = out.normal[point].position;
+    const sf::Vector2f thick = out.thick[point * steps + middle].position;
+    const double normalR =
+        std::hypot(normal.x - WIDTH / 2.0f, normal.y - HEIGHT / 2.0f);
+    const double thickR =
+        std::hypot(thick.x - WIDTH / 2.0f, thick.y - HEIGHT / 2.0f);
+    worst = std::max(
+        worst, std::abs(normalR - (radius + samples[index] * DISPLAY_HEIGHT)));
+    worst = std::max(worst, std::abs(thickR - (radius + middleOffset +
+                                               smoothed[index] *
+                                                   DISPLAY_HEIGHT)));
+  }
+  return worst;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const int calls = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+
+  std::mt19937 random(1234);
+  std::uniform_real_distribution<double> noise(-1.0, 1.0);
+  std::vector<double> audio(SAMPLES);
+  for (double &sample : audio) {
+    sample = noise(random);
+  }
+  std::vector<double> samples;
+  std::vector<double> smoothed;
+  mirrorAudioBuffer(audio, samples);
+  smoothAudioData(samples, smoothed, 5);
+
+  Buffers out;
+  const size_t maxPoints = waveformPointCount(samples.size(), 10);
+  out.normal.resize(maxPoints);
+  out.thick.resize(maxPoints * thickStepCount(THICKNESS));
+
+  bool passed = true;
+  double sink = 0.0;
+  std::printf("%zu mirrored samples, thickness %.0f, us per call\n",
+              samples.size(), THICKNESS);
+  std::printf("%-12s %-6s", "Kernel", "Thick");
+  for (int multiplier : MULTIPLIERS) {
+    std::printf(" %8s%-2d", "x", multiplier);
+  }
+  std::printf("\n");
+
+  for (size_t k = 0; k < static_cast<size_t>(Interpolation::Count); ++k) {
+    const Interpolation kernel = static_cast<Interpolation>(k);
+    for (bool thickPass : {false, true}) {
+      std::printf("%-12s %-6s", KERNEL_NAMES[k], thickPass ? "yes" : "no");
+      for (int multiplier : MULTIPLIERS) {
+        draw(samples, smoothed, out, kernel, multiplier, thickPass);
+        if (thickPass && kernel != Interpolation::Cubic) {
+          const double error =
+              segmentStartError(samples, smoothed, out, multiplier);
+          if (error > 1e-3) {
+            std::fprintf(stderr,
+                         "%s at multiplier %d misses its samples by %.3g px\n",
+                         KERNEL_NAMES[k], multiplier, error);
+            passed = false;
+          }
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int call = 0; call < calls; ++call) {
+          draw(samples, smoothed, out, kernel, multiplier, thickPass);
+          sink += out.normal[static_cast<size_t>(call) % SAMPLES].position.x;
+        }
+        const double micros = std::chrono::duration<double, std::micro>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count() /
+                              calls;
+        std::printf(" %10.1f", micros);
+      }
+      std::printf("\n");
+    }
+  }
+
+  std::printf("x7 takes the generic kernel [%g]\n", sink);
+  std::printf("Segment starts %s\n", passed ? "ok" : "MISMATCH");
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,189 @@
+#include "shm_reader.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <intrin.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* Attempts atshm_read_latest makes before giving up on a busy writer */
+#define READ_ATTEMPTS 8
+
+struct atshm_reader {
+  const atshm_header *header;
+  const atshm_frame *slots;
+  size_t bytes;
+#if defined(_WIN32)
+  HANDLE mapping;
+#endif
+};
+
+/* Acquire load, and an acquire fence followed by a plain load, of a
+   64-bit counter written by the publisher */
+#if defined(_MSC_VER) && defined(_M_ARM64)
+static uint64_t load_acquire(const uint64_t *p) {
+  return __ldar64((unsigned __int64 volatile *)p);
+}
+static uint64_t fence_then_load(const uint64_t *p) {
+  __dmb(_ARM64_BARRIER_ISHLD);
+  return __iso_volatile_load64((const volatile __int64 *)p);
+}
+#elif defined(_MSC_VER)
+/* x86 and x64 never reorder loads with loads; only the compiler might */
+static uint64_t load_acquire(const uint64_t *p) {
+  uint64_t value = *(const volatile uint64_t *)p;
+  _ReadWriteBarrier();
+  return value;
+}
+static uint64_t fence_then_load(const uint64_t *p) {
+  _ReadWriteBarrier();
+  return *(const volatile uint64_t *)p;
+}
+#else
+static uint64_t load_acquire(const uint64_t *p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static uint64_t fence_then_load(const uint64_t *p) {
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+#endif
+
+atshm_reader *atshm_open(const char *name) {
+  atshm_reader *reader = (atshm_reader *)calloc(1, sizeof(atshm_reader));
+  const void *view = NULL;
+  if (!reader) {
+    return NULL;
+  }
+  reader->bytes =
+      sizeof(atshm_header) + ATSHM_SLOT_COUNT * sizeof(atshm_frame);
+
+#if defined(_WIN32)
+  {
+    char mapping_name[256];
+    const char *base = name[0] == '/' ? name + 1 : name;
+    if ((size_t)_snprintf_s(mapping_name, sizeof(mapping_name), _TRUNCATE,
+                            "Local\\%s", base) >= sizeof(mapping_name)) {
+      free(reader);
+      return NULL;
+    }
+    reader->mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, mapping_name);
+    if (!reader->mapping) {
+      free(reader);
+      return NULL;
+    }
+    view = MapViewOfFile(reader->mapping, FILE_MAP_READ, 0, 0, reader->bytes);
+    if (!view) {
+      CloseHandle(reader->mapping);
+      free(reader);
+      return NULL;
+    }
+  }
+#else
+  {
+    struct stat info;
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+      free(reader);
+      return NULL;
+    }
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < reader->bytes) {
+      close(fd);
+      free(reader);
+      return NULL;
+    }
+    view = mmap(NULL, reader->bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+      free(reader);
+      return NULL;
+    }
+  }
+#endif
+
+  reader->header = (const atshm_header *)view;
+  reader->slots = (const atshm_frame *)(reader->header + 1);
+  if (reader->header->magic != ATSHM_MAGIC ||
+      reader->header->version != ATSHM_VERSION ||
+      reader->header->slot_count != ATSHM_SLOT_COUNT ||
+      reader->header->frame_bytes != sizeof(atshm_frame)) {
+    atshm_close(reader);
+    return NULL;
+  }
+  return reader;
+}
+
+void atshm_close(atshm_reader *reader) {
+  if (!reader) {
+    return;
+  }
+#if defined(_WIN32)
+  UnmapViewOfFile(reader->header);
+  CloseHandle(reader->mapping);
+#else
+  munmap((void *)reader->header, reader->bytes);
+#endif
+  free(reader);
+}
+
+uint64_t atshm_frame_count(const atshm_reader *reader) {
+  return load_acquire(&reader->header->frame_count);
+}
+
+const atshm_frame *atshm_begin_read(const atshm_reader *reader, uint64_t frame,
+                                    uint64_t *sequence) {
+  const atshm_frame *slot;
+  if (frame == 0) {
+    return NULL;
+  }
+  slot = &reader->slots[(frame - 1) % ATSHM_SLOT_COUNT];
+  *sequence = load_acquire(&slot->sequence);
+  return *sequence == frame * 2 ? slot : NULL;
+}
+
+int atshm_end_read(const atshm_frame *slot, uint64_t sequence) {
+  return fence_then_load(&slot->sequence) == sequence;
+}
+
+uint64_t atshm_read_latest(const atshm_reader *reader, atshm_frame *out) {
+  int attempt;
+  for (attempt = 0; attempt < READ_ATTEMPTS; ++attempt) {
+    uint64_t frame = atshm_frame_count(reader);
+    uint64_t sequence;
+    uint32_t samples, bins, bands;
+    const atshm_frame *slot = atshm_begin_read(reader, frame, &sequence);
+    if (frame == 0) {
+      return 0;
+    }
+    if (!slot) {
+      continue;
+    }
+
+    /* Everything up to the arrays, then the used part of each; counts are
+       clamped because a torn read can see any value */
+    memcpy(out, slot, offsetof(atshm_frame, samples));
+    samples = out->sample_count < ATSHM_MAX_SAMPLES ? out->sample_count
+                                                    : ATSHM_MAX_SAMPLES;
+    bins = out->bin_count < ATSHM_MAX_BINS ? out->bin_count : ATSHM_MAX_BINS;
+    bands = out->band_count < ATSHM_MAX_BANDS ? out->band_count
+                                              : ATSHM_MAX_BANDS;
+    memcpy(out->samples, slot->samples, samples * sizeof(float));
+    memcpy(out->spectrum, slot->spectrum, bins * sizeof(float));
+    memcpy(out->bands, slot->bands, bands * sizeof(float));
+
+    if (atshm_end_read(slot, sequence)) {
+      return frame;
+    }
+  }
+  return 0;
+}
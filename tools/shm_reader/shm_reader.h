@@ -0,0 +1,55 @@
+#ifndef SHM_READER_H
+#define SHM_READER_H
+
+/*
+ * Reader for AudioThing's shared-memory analysis ring. Opening maps the
+ * region read-only; after that nothing here makes a syscall, so any number
+ * of readers can poll it at any rate without affecting the writer.
+ *
+ * In-place reading, without copying the frame:
+ *
+ *   uint64_t n = atshm_frame_count(reader), sequence;
+ *   const atshm_frame *frame = atshm_begin_read(reader, n, &sequence);
+ *   if (frame) {
+ *     ... read from frame ...
+ *     if (!atshm_end_read(frame, sequence))
+ *       ... the writer reused the slot meanwhile; discard what was read ...
+ *   }
+ *
+ * atshm_read_latest() does the same with a copy and retries for you.
+ */
+
+#include "SharedAnalysisLayout.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct atshm_reader atshm_reader;
+
+/* Returns NULL if the region does not exist yet or has a different layout;
+   name is ATSHM_DEFAULT_NAME unless the writer was given another */
+atshm_reader *atshm_open(const char *name);
+void atshm_close(atshm_reader *reader);
+
+/* Frames published so far; the latest is frame number atshm_frame_count() */
+uint64_t atshm_frame_count(const atshm_reader *reader);
+
+/* Slot holding frame number frame, or NULL if that frame is not complete
+   or has already been overwritten */
+const atshm_frame *atshm_begin_read(const atshm_reader *reader, uint64_t frame,
+                                    uint64_t *sequence);
+
+/* 1 if the slot still held the same frame for the whole read */
+int atshm_end_read(const atshm_frame *slot, uint64_t sequence);
+
+/* Copies the newest complete frame into out. Returns its frame number, or
+   0 if nothing has been published or no stable copy was made within a few
+   attempts. Only the used part of each array is copied. */
+uint64_t atshm_read_latest(const atshm_reader *reader, atshm_frame *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHM_READER_H */
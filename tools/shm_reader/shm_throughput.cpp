@@ -0,0 +1,160 @@
+// Throughput of the shared-memory analysis ring with several consumers.
+// The main thread publishes frames at a fixed rate, or as fast as it can
+// with a rate of 0, while each consumer maps the region on its own and
+// reads every new frame in place. Exits non-zero if a validated frame was
+// inconsistent. Built from the repository root with
+//
+//   c++ -std=c++17 -O2 -Iinclude -Itools/shm_reader -pthread
+//       tools/shm_reader/shm_throughput.cpp src/SharedMemoryPublisher.cpp
+//       -x c tools/shm_reader/shm_reader.c -lrt -o shm_throughput
+//
+//   shm_throughput [consumers = 4] [seconds = 2] [rate Hz = 10000]
+
+#include "SharedMemoryPublisher.h"
+#include "shm_reader.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct ConsumerStats {
+  std::uint64_t read = 0;   // Frames read and validated
+  std::uint64_t torn = 0;   // Reads the writer overtook
+  std::uint64_t missed = 0; // Frames overwritten before they were read
+  std::uint64_t corrupt = 0; // Validated frames whose contents disagree
+  double checksum = 0.0;
+};
+
+void consume(const std::string &name, const std::atomic<bool> &running,
+             ConsumerStats &stats) {
+  atshm_reader *reader = atshm_open(name.c_str());
+  if (!reader) {
+    std::fprintf(stderr, "Consumer failed to open %s\n", name.c_str());
+    return;
+  }
+
+  std::uint64_t last = atshm_frame_count(reader);
+  while (running.load(std::memory_order_relaxed)) {
+    std::uint64_t latest = atshm_frame_count(reader);
+    if (latest == last) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (latest - last > ATSHM_SLOT_COUNT) {
+      stats.missed += latest - last - ATSHM_SLOT_COUNT;
+      last = latest - ATSHM_SLOT_COUNT;
+    }
+
+    for (std::uint64_t frame = last + 1; frame <= latest; ++frame) {
+      std::uint64_t sequence = 0;
+      const atshm_frame *slot = atshm_begin_read(reader, frame, &sequence);
+      if (!slot) {
+        ++stats.missed;
+        continue;
+      }
+
+      // Every sample of frame n is n; anything else is a torn frame
+      const std::uint32_t count = slot->sample_count < ATSHM_MAX_SAMPLES
+                                      ? slot->sample_count
+                                      : ATSHM_MAX_SAMPLES;
+      const float expected = static_cast<float>(frame % 1000000);
+      bool consistent = slot->time_ns == static_cast<std::int64_t>(frame);
+      double sum = 0.0;
+      for (std::uint32_t i = 0; i < count; ++i) {
+        sum += slot->samples[i];
+        consistent = consistent && slot->samples[i] == expected;
+      }
+
+      if (!atshm_end_read(slot, sequence)) {
+        ++stats.torn;
+        continue;
+      }
+      ++stats.read;
+      stats.checksum += sum;
+      stats.corrupt += consistent ? 0 : 1;
+    }
+    last = latest;
+  }
+  atshm_close(reader);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const int consumers = argc > 1 ? std::atoi(argv[1]) : 4;
+  const double seconds = argc > 2 ? std::atof(argv[2]) : 2.0;
+  const double rate = argc > 3 ? std::atof(argv[3]) : 10000.0;
+  const std::string name = "/audiothing-throughput";
+
+  SharedMemoryPublisher publisher;
+  if (!publisher.open(name)) {
+    return EXIT_FAILURE;
+  }
+
+  std::atomic<bool> running{true};
+  std::vector<ConsumerStats> stats(consumers);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < consumers; ++i) {
+    threads.emplace_back(consume, name, std::cref(running),
+                         std::ref(stats[i]));
+  }
+
+  std::vector<double> samples(1024);
+  std::vector<float> spectrum(1025, 0.5f);
+  std::vector<float> bands(64, 0.25f);
+  const std::uint64_t first = publisher.getFramesPublished();
+  const auto start = std::chrono::steady_clock::now();
+  const auto end = start + std::chrono::duration<double>(seconds);
+  std::uint64_t published = 0;
+  while (std::chrono::steady_clock::now() < end) {
+    if (rate > 0.0) {
+      const auto due = start + std::chrono::duration<double>(published / rate);
+      while (std::chrono::steady_clock::now() < due) {
+        std::this_thread::yield();
+      }
+    }
+    const std::uint64_t frame = first + published + 1;
+    std::fill(samples.begin(), samples.end(),
+              static_cast<double>(frame % 1000000));
+
+    SharedAnalysis analysis;
+    analysis.timeNs = static_cast<std::int64_t>(frame);
+    analysis.samples = samples.data();
+    analysis.sampleCount = samples.size();
+    analysis.spectrum = spectrum.data();
+    analysis.fftSize = (spectrum.size() - 1) * 2;
+    analysis.bands = bands.data();
+    analysis.bandCount = bands.size();
+    publisher.publish(analysis);
+    ++published;
+  }
+  const double elapsed =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  running = false;
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  publisher.close();
+
+  std::printf("Published %llu frames in %.2f s: %.0f frames/s\n",
+              static_cast<unsigned long long>(published), elapsed,
+              published / elapsed);
+  int failures = 0;
+  for (int i = 0; i < consumers; ++i) {
+    const ConsumerStats &s = stats[i];
+    std::printf("Consumer %d: %.0f frames/s read, %llu torn, %llu missed, "
+                "%llu corrupt\n",
+                i, s.read / elapsed, static_cast<unsigned long long>(s.torn),
+                static_cast<unsigned long long>(s.missed),
+                static_cast<unsigned long long>(s.corrupt));
+    failures += s.corrupt > 0;
+  }
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,164 @@
+#version 120
+
+// Builds waveform geometry from the per-frame sample texture; mirrors
+// drawWaveform() in WaveformDrawer.h. Each vertex only carries indices:
+//   position.x  point index along the circle
+//   position.y  radial step of the thick pass
+//   texCoord.x  waveform index, its row in the waveform texture
+//   texCoord.y  pass (0 = normal, 1 = thick)
+// Bridge vertices between passes arrive with zero alpha.
+
+const float TWO_PI = 6.28318530718;
+
+// Range each parameter is encoded over; must match packGpuGeometry()
+const float MAX_RADIUS_FACTOR = 8.0;
+const float MAX_DISPLAY_HEIGHT = 2048.0;
+const float MAX_THICKNESS = 512.0;
+
+uniform sampler2D samples;   // Row 0 raw, other rows smoothed; 16-bit in RG
+uniform vec2 sampleTexel;    // 1 / texture size
+uniform float sampleCount;   // Length of the mirrored buffer
+uniform float pointCount;
+uniform float pointMultiplier;
+uniform float thickStep;     // Radial spacing of the thick pass lines
+uniform vec2 center;
+uniform float baseRadius;    // min(center.x, center.y)
+uniform float hue;
+
+// One row per waveform, each texel a parameter in 24-bit fixed point in
+// RGB: rotation in turns, radius factor, display height, thickness, thick
+// hue offset, alpha, thick alpha. The alpha bytes of the first two hold the
+// smoothed sample row, that of the third the interpolation enum (0 none,
+// 1 linear, 2 cubic, 3 Catmull-Rom), those of the next two the last radial
+// step this frame's thickness draws. Layouts made for a thicker pass than
+// that have their extra steps folded onto the last.
+uniform sampler2D waveforms;
+uniform vec2 waveformTexel;  // 1 / texture size
+
+vec4 waveformTexelAt(float column, float wave) {
+    return texture2DLod(waveforms, (vec2(column, wave) + 0.5) * waveformTexel, 0.0);
+}
+
+float decodeParameter(vec4 texel, float minimum, float maximum) {
+    float encoded = dot(floor(texel.rgb * 255.0 + 0.5), vec3(65536.0, 256.0, 1.0));
+    return mix(minimum, maximum, encoded / 16777215.0);
+}
+
+float sampleAt(float index, float row) {
+    vec4 texel = texture2DLod(samples, (vec2(index, row) + 0.5) * sampleTexel, 0.0);
+    float encoded = (texel.r * 255.0 * 256.0 + texel.g * 255.0) / 65535.0;
+    return (encoded - 0.5) * 4.0;
+}
+
+float wrapIndex(float index) {
+    if (index < 0.0)
+        return index + sampleCount;
+    if (index >= sampleCount)
+        return index - sampleCount;
+    return index;
+}
+
+float interpolatedSample(float point, float row, float kernel) {
+    // Offset by half a point so the division never rounds down a whole step
+    float segment = floor((point + 0.5) / pointMultiplier);
+    float mu = (point - segment * pointMultiplier) / pointMultiplier;
+    float index = mod(segment, sampleCount);
+
+    // Segments run from the sample to the next; cubic keeps the original
+    // curve from the one before to the one after (see neighbourOffset())
+    float before = kernel > 1.5 && kernel < 2.5 ? 2.0 : 1.0;
+    float y0 = sampleAt(wrapIndex(index - before), row);
+    float y1 = sampleAt(wrapIndex(index - before + 1.0), row);
+    float y2 = sampleAt(wrapIndex(index + 1.0), row);
+    float y3 = sampleAt(wrapIndex(index + 2.0), row);
+
+    if (kernel < 0.5)
+        return y1;
+    if (kernel < 1.5)
+        return mix(y1, y2, mu);
+
+    float mu2 = mu * mu;
+    if (kernel > 2.5) {
+        return 0.5 * (2.0 * y1 + (y2 - y0) * mu +
+                      (2.0 * y0 - 5.0 * y1 + 4.0 * y2 - y3) * mu2 +
+                      (3.0 * y1 - y0 - 3.0 * y2 + y3) * mu * mu2);
+    }
+    float a0 = y3 - y2 - y0 + y1;
+    float a1 = y0 - y1 - a0;
+    float a2 = y2 - y0;
+    return a0 * mu * mu2 + a1 * mu2 + a2 * mu + y1;
+}
+
+vec2 pointPosition(float point, float row, float radial, vec4 geometry,
+                   float kernel) {
+    float angle = (point / pointCount + geometry.x) * TWO_PI;
+    float r = baseRadius * geometry.y + interpolatedSample(point, row, kernel) * geometry.z + radial;
+    return center + r * vec2(cos(angle), sin(angle));
+}
+
+vec3 hsvToRgb(float h, float value) {
+    h = fract(h);
+    float sector = floor(h * 6.0);
+    float f = h * 6.0 - sector;
+    float q = value * (1.0 - f);
+    float t = value * f;
+
+    if (sector < 1.0)
+        return vec3(value, t, 0.0);
+    if (sector < 2.0)
+        return vec3(q, value, 0.0);
+    if (sector < 3.0)
+        return vec3(0.0, value, t);
+    if (sector < 4.0)
+        return vec3(0.0, q, value);
+    if (sector < 5.0)
+        return vec3(t, 0.0, value);
+    return vec3(value, 0.0, q);
+}
+
+void main() {
+    float wave = floor(gl_MultiTexCoord0.x + 0.5);
+    vec4 rotation = waveformTexelAt(0.0, wave);
+    vec4 radius = waveformTexelAt(1.0, wave);
+    vec4 height = waveformTexelAt(2.0, wave);
+    vec4 thickness = waveformTexelAt(3.0, wave);
+    vec4 thickHue = waveformTexelAt(4.0, wave);
+
+    // x rotation in turns, y radius factor, z display height, w thickness
+    vec4 geometry = vec4(decodeParameter(rotation, 0.0, 1.0),
+                         decodeParameter(radius, 0.0, MAX_RADIUS_FACTOR),
+                         decodeParameter(height, -MAX_DISPLAY_HEIGHT, MAX_DISPLAY_HEIGHT),
+                         decodeParameter(thickness, 0.0, MAX_THICKNESS));
+    // x thick hue offset, y alpha, z thick alpha, w smoothed sample row
+    vec4 style = vec4(decodeParameter(thickHue, 0.0, 1.0),
+                      decodeParameter(waveformTexelAt(5.0, wave), 0.0, 1.0),
+                      decodeParameter(waveformTexelAt(6.0, wave), 0.0, 1.0),
+                      floor(rotation.a * 255.0 + 0.5) * 256.0 + floor(radius.a * 255.0 + 0.5));
+    float kernel = floor(height.a * 255.0 + 0.5);
+    float lastStep = floor(thickness.a * 255.0 + 0.5) * 256.0 + floor(thickHue.a * 255.0 + 0.5);
+
+    float point = gl_Vertex.x;
+    float gradient = -geometry.x + point / pointCount;
+
+    vec2 position;
+    vec4 color;
+    if (gl_MultiTexCoord0.y > 0.5) {
+        float radial = -geometry.w * 0.5 + min(gl_Vertex.y, lastStep) * thickStep;
+        position = pointPosition(point, style.w, radial, geometry, kernel);
+        color = vec4(hsvToRgb(fract(hue + style.x) + gradient, 1.0), style.z);
+    } else {
+        position = pointPosition(point, 0.0, 0.0, geometry, kernel);
+
+        // Same seam fix as the CPU path: snap the last point onto the first
+        // when the circle does not close
+        if (point > pointCount - 1.5) {
+            vec2 first = pointPosition(0.0, 0.0, 0.0, geometry, kernel);
+            if (distance(first, position) > baseRadius * geometry.y * 0.5)
+                position = first;
+        }
+        color = vec4(hsvToRgb(hue + gradient, 0.7), style.y);
+    }
+
+    gl_Position = gl_ModelViewProjectionMatrix * vec4(position, 0.0, 1.0);
+    gl_FrontColor = vec4(color.rgb, color.a * gl_Color.a);
+}